@@ -12,6 +12,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(ARM_MATH_CM4)
+  #include "arm_math.h"
+#endif
+
 /**
  * @addtogroup LIS2DH12
  */
@@ -23,8 +27,8 @@
  * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
  *
  * Implementation for LIS2DH12 basic usage. The implementation supports
- * different resolutions, samplerates, high-passing, activity interrupt
- * and FIFO.
+ * different resolutions, samplerates, high-passing, activity interrupt,
+ * free-fall, orientation and click detection and FIFO.
  *
  * Requires STM lis2dh12 driver, available on GitHub under BSD-3 license.
  * Requires "application_config.h", will only get compiled if LIS2DH12_ACCELERATION is defined.
@@ -46,6 +50,46 @@ typedef union
   uint8_t u8bit[6];  //!< Buffer
 } axis3bit16_t;
 
+/** @brief Function of interrupt generator 2, shared by free-fall and orientation. */
+typedef enum
+{
+  IA2_NONE = 0,     //!< Interrupt generator 2 is not in use.
+  IA2_FREE_FALL,    //!< Interrupt generator 2 detects free-fall.
+  IA2_ORIENTATION   //!< Interrupt generator 2 detects orientation change.
+} ia2_use_t;
+
+/** @brief Event sources which can be routed to interrupt pins. */
+typedef enum
+{
+  ROUTE_IA1,  //!< Interrupt generator 1.
+  ROUTE_IA2,  //!< Interrupt generator 2.
+  ROUTE_CLICK //!< Click detection.
+} route_t;
+
+/** @brief Maximum value of 7-bit threshold and duration registers. */
+#define LIS2DH12_7BIT_MAX 0x7F
+/** @brief Maximum value of 8-bit click timing registers. */
+#define LIS2DH12_8BIT_MAX 0xFF
+
+/** @brief Number of samples in FIFO + output register. */
+#define LIS2DH12_FIFO_MAX_ELEMENTS 32
+
+/**
+ * @brief Precomputed raw to G conversion.
+ *
+ * Raw data is left-justified, so one LSB of raw register value is always
+ * the same acceleration regardless of resolution. Scale, mg to G, gain and
+ * axis remapping are folded into one multiplier and offset per output axis.
+ */
+typedef struct
+{
+  float coefficient[3]; //!< G per LSB of raw value of each output axis.
+  float offset[3];      //!< Offset of each output axis, G.
+  uint8_t axis[3];      //!< Source axis of each output axis.
+  bool identity;        //!< True if axes are not remapped.
+  bool uniform;         //!< True if coefficients are equal and offsets are zero.
+} conversion_t;
+
 /** @brief Representation of 2 bytes buffer as int16_t */
 typedef union
 {
@@ -61,15 +105,94 @@ static struct
   lis2dh12_op_md_t resolution; //!< Resolution, bits. 8, 10, or 12.
   lis2dh12_fs_t scale;         //!< Scale, gravities. 2, 4, 8 or 16.
   lis2dh12_odr_t samplerate;   //!< Sample rate, 1 ... 200, or custom values for higher.
+  lis2dh12_odr_t odr;          //!< Configured sample rate, kept while sensor is powered down.
   lis2dh12_st_t selftest;      //!< Self-test enabled, positive, negative or disabled.
   uint8_t mode;                //!< Operating mode. Sleep, single or continuous.
   uint8_t handle;              //!< Device handle, SPI GPIO pin or I2C address.
   uint64_t tsample;            //!< Time of sample, @ref ruuvi_driver_sensor_timestamp_get
+  ia2_use_t ia2_use;           //!< Function of interrupt generator 2.
   stmdev_ctx_t ctx;            //!< Driver control structure
 } dev = {0};
 
 static const char m_acc_name[] = "LIS2DH12";
 
+/** @brief Calibration set by application, applied on top of scale. */
+static ruuvi_interface_lis2dh12_calibration_t m_calibration =
+{
+  .offset_g = {0, 0, 0},
+  .gain     = {1, 1, 1},
+  .axis     = {0, 1, 2}
+};
+
+/** @brief Conversion in use, defaults to 2 G scale without calibration. */
+static conversion_t m_conversion =
+{
+  .coefficient = {1.0f / 16000, 1.0f / 16000, 1.0f / 16000},
+  .offset      = {0, 0, 0},
+  .axis        = {0, 1, 2},
+  .identity    = true,
+  .uniform     = true
+};
+
+/**
+ * @brief Update precomputed conversion after scale or calibration has changed.
+ *
+ * 1 LSb of left-justified raw value:
+ * 1/16 mg @ FS = 2 g
+ * 2/16 mg @ FS = 4 g
+ * 4/16 mg @ FS = 8 g
+ * 12/16 mg @ FS = 16 g
+ *
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_INTERNAL if scale is unknown.
+ */
+static ruuvi_driver_status_t lis2dh12_conversion_update(void)
+{
+  float mg_per_lsb;
+
+  switch(dev.scale)
+  {
+    case LIS2DH12_2g:
+      mg_per_lsb = 1.0f / 16;
+      break;
+
+    case LIS2DH12_4g:
+      mg_per_lsb = 2.0f / 16;
+      break;
+
+    case LIS2DH12_8g:
+      mg_per_lsb = 4.0f / 16;
+      break;
+
+    case LIS2DH12_16g:
+      mg_per_lsb = 12.0f / 16;
+      break;
+
+    default:
+      return RUUVI_DRIVER_ERROR_INTERNAL;
+  }
+
+  m_conversion.identity = true;
+  m_conversion.uniform  = true;
+
+  for(size_t ii = 0; ii < 3; ii++)
+  {
+    m_conversion.coefficient[ii] = (mg_per_lsb / 1000.0f) * m_calibration.gain[ii];
+    m_conversion.offset[ii]      = m_calibration.offset_g[ii];
+    m_conversion.axis[ii]        = m_calibration.axis[ii];
+
+    if(ii != m_conversion.axis[ii]) { m_conversion.identity = false; }
+
+    if(0 != m_conversion.offset[ii]
+        || m_conversion.coefficient[ii] != m_conversion.coefficient[0])
+    {
+      m_conversion.uniform = false;
+    }
+  }
+
+  return RUUVI_DRIVER_SUCCESS;
+}
+
 // Check that self-test values differ enough
 static ruuvi_driver_status_t lis2dh12_verify_selftest_difference(axis3bit16_t* new,
     axis3bit16_t* old)
@@ -132,7 +255,11 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_init(ruuvi_driver_sensor_t*
   ruuvi_interface_lis2dh12_fifo_use(false);
   ruuvi_interface_lis2dh12_fifo_interrupt_use(false);
   float ths = 0;
+  uint16_t duration = 0;
   ruuvi_interface_lis2dh12_activity_interrupt_use(false, &ths);
+  ruuvi_interface_lis2dh12_free_fall_use(false, &ths, &duration,
+                                         RUUVI_INTERFACE_LIS2DH12_INT2);
+  ruuvi_interface_lis2dh12_click_use(false, NULL, RUUVI_INTERFACE_LIS2DH12_INT2);
   // Turn X-, Y-, Z-measurement on
   uint8_t enable_axes = 0x07;
   lis2dh12_write_reg(dev_ctx, LIS2DH12_CTRL_REG1, &enable_axes, 1);
@@ -146,6 +273,7 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_init(ruuvi_driver_sensor_t*
   // Set full scale to 2G for self-test
   dev.scale = LIS2DH12_2g;
   lis2dh12_full_scale_set(dev_ctx, dev.scale);
+  lis2dh12_conversion_update();
   // Enable temperature sensor
   lis2dh12_temperature_meas_set(dev_ctx, LIS2DH12_TEMP_ENABLE);
   // Set device in 10 bit mode
@@ -278,6 +406,8 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_samplerate_set(uint8_t* samplerat
 
   if(RUUVI_DRIVER_SUCCESS == err_code)
   {
+    if(LIS2DH12_POWER_DOWN != dev.samplerate) { dev.odr = dev.samplerate; }
+
     err_code |= lis2dh12_data_rate_set(&(dev.ctx), dev.samplerate);
     err_code |= ruuvi_interface_lis2dh12_samplerate_get(samplerate);
   }
@@ -427,6 +557,7 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_scale_set(uint8_t* scale)
   {
     err_code |= lis2dh12_full_scale_set(&(dev.ctx), dev.scale);
     err_code |= ruuvi_interface_lis2dh12_scale_get(scale);
+    err_code |= lis2dh12_conversion_update();
   }
 
   return err_code;
@@ -680,122 +811,94 @@ static ruuvi_driver_status_t rawToC(const uint8_t* const raw_temperature,
   return err_code;
 }
 
-/**
- * Convert raw value to acceleration in mg
- *
- * parameter raw: Input. Raw values from LIS2DH12
- * parameter acceleration: Output. Acceleration values in mg
- *
- */
-static ruuvi_driver_status_t rawToMg(const axis3bit16_t* raw_acceleration,
-                                     float* acceleration)
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_calibration_set(
+  const ruuvi_interface_lis2dh12_calibration_t* const calibration)
 {
-  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  const ruuvi_interface_lis2dh12_calibration_t identity =
+  {
+    .offset_g = {0, 0, 0},
+    .gain     = {1, 1, 1},
+    .axis     = {0, 1, 2}
+  };
 
-  for(size_t ii = 0; ii < 3; ii++)
+  if(NULL == calibration)
   {
-    switch(dev.scale)
+    m_calibration = identity;
+  }
+  else
+  {
+    for(size_t ii = 0; ii < 3; ii++)
     {
-      case LIS2DH12_2g:
-        switch(dev.resolution)
-        {
-          case LIS2DH12_LP_8bit:
-            acceleration[ii] = lis2dh12_from_fs2_lp_to_mg(raw_acceleration->i16bit[ii]);
-            break;
-
-          case LIS2DH12_NM_10bit:
-            acceleration[ii] = lis2dh12_from_fs2_nm_to_mg(raw_acceleration->i16bit[ii]);
-            break;
-
-          case LIS2DH12_HR_12bit:
-            acceleration[ii] = lis2dh12_from_fs2_hr_to_mg(raw_acceleration->i16bit[ii]);
-            break;
-
-          default:
-            acceleration[ii] = RUUVI_DRIVER_FLOAT_INVALID;
-            err_code |= RUUVI_DRIVER_ERROR_INTERNAL;
-            break;
-        }
-
-        break;
-
-      case LIS2DH12_4g:
-        switch(dev.resolution)
-        {
-          case LIS2DH12_LP_8bit:
-            acceleration[ii] = lis2dh12_from_fs4_lp_to_mg(raw_acceleration->i16bit[ii]);
-            break;
-
-          case LIS2DH12_NM_10bit:
-            acceleration[ii] = lis2dh12_from_fs4_nm_to_mg(raw_acceleration->i16bit[ii]);
-            break;
-
-          case LIS2DH12_HR_12bit:
-            acceleration[ii] = lis2dh12_from_fs4_hr_to_mg(raw_acceleration->i16bit[ii]);
-            break;
-
-          default:
-            acceleration[ii] = RUUVI_DRIVER_FLOAT_INVALID;
-            err_code |= RUUVI_DRIVER_ERROR_INTERNAL;
-            break;
-        }
-
-        break;
-
-      case LIS2DH12_8g:
-        switch(dev.resolution)
-        {
-          case LIS2DH12_LP_8bit:
-            acceleration[ii] = lis2dh12_from_fs8_lp_to_mg(raw_acceleration->i16bit[ii]);
-            break;
-
-          case LIS2DH12_NM_10bit:
-            acceleration[ii] = lis2dh12_from_fs8_nm_to_mg(raw_acceleration->i16bit[ii]);
-            break;
+      if(2 < calibration->axis[ii]) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+    }
 
-          case LIS2DH12_HR_12bit:
-            acceleration[ii] = lis2dh12_from_fs8_hr_to_mg(raw_acceleration->i16bit[ii]);
-            break;
+    m_calibration = *calibration;
+  }
 
-          default:
-            acceleration[ii] = RUUVI_DRIVER_FLOAT_INVALID;
-            err_code |= RUUVI_DRIVER_ERROR_INTERNAL;
-            break;
-        }
+  return lis2dh12_conversion_update();
+}
 
-        break;
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_calibration_get(
+  ruuvi_interface_lis2dh12_calibration_t* const calibration)
+{
+  if(NULL == calibration) { return RUUVI_DRIVER_ERROR_NULL; }
 
-      case LIS2DH12_16g:
-        switch(dev.resolution)
-        {
-          case LIS2DH12_LP_8bit:
-            acceleration[ii] = lis2dh12_from_fs16_lp_to_mg(raw_acceleration->i16bit[ii]);
-            break;
+  *calibration = m_calibration;
+  return RUUVI_DRIVER_SUCCESS;
+}
 
-          case LIS2DH12_NM_10bit:
-            acceleration[ii] = lis2dh12_from_fs16_nm_to_mg(raw_acceleration->i16bit[ii]);
-            break;
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_raw_to_g(const int16_t* const raw,
+    float* const acceleration, const size_t samples)
+{
+  if(NULL == raw || NULL == acceleration) { return RUUVI_DRIVER_ERROR_NULL; }
 
-          case LIS2DH12_HR_12bit:
-            acceleration[ii] = lis2dh12_from_fs16_hr_to_mg(raw_acceleration->i16bit[ii]);
-            break;
+  const size_t values = samples * 3;
+  #if defined(ARM_MATH_CM4)
 
-          default:
-            acceleration[ii] = RUUVI_DRIVER_FLOAT_INVALID;
-            err_code |= RUUVI_DRIVER_ERROR_INTERNAL;
-            break;
-        }
+  // Raw values are Q15 of full register range, scale the whole block at once.
+  if(m_conversion.uniform && m_conversion.identity)
+  {
+    arm_q15_to_float((q15_t*) raw, acceleration, values);
+    arm_scale_f32(acceleration, m_conversion.coefficient[0] * 32768.0f, acceleration,
+                  values);
+    return RUUVI_DRIVER_SUCCESS;
+  }
 
-        break;
+  #endif
+  // Local copies let compiler keep coefficients in registers and vectorise the loop.
+  const float c0 = m_conversion.coefficient[0];
+  const float c1 = m_conversion.coefficient[1];
+  const float c2 = m_conversion.coefficient[2];
+  const float o0 = m_conversion.offset[0];
+  const float o1 = m_conversion.offset[1];
+  const float o2 = m_conversion.offset[2];
+  const int16_t* restrict in = raw;
+  float* restrict out = acceleration;
+
+  if(m_conversion.identity)
+  {
+    for(size_t ii = 0; ii < values; ii += 3)
+    {
+      out[ii]     = in[ii]     * c0 + o0;
+      out[ii + 1] = in[ii + 1] * c1 + o1;
+      out[ii + 2] = in[ii + 2] * c2 + o2;
+    }
+  }
+  else
+  {
+    const uint8_t a0 = m_conversion.axis[0];
+    const uint8_t a1 = m_conversion.axis[1];
+    const uint8_t a2 = m_conversion.axis[2];
 
-      default:
-        acceleration[ii] = RUUVI_DRIVER_FLOAT_INVALID;
-        err_code |= RUUVI_DRIVER_ERROR_INTERNAL;
-        break;
+    for(size_t ii = 0; ii < values; ii += 3)
+    {
+      out[ii]     = in[ii + a0] * c0 + o0;
+      out[ii + 1] = in[ii + a1] * c1 + o1;
+      out[ii + 2] = in[ii + a2] * c2 + o2;
     }
   }
 
-  return err_code;
+  return RUUVI_DRIVER_SUCCESS;
 }
 
 ruuvi_driver_status_t ruuvi_interface_lis2dh12_data_get(ruuvi_driver_sensor_data_t* const
@@ -809,11 +912,10 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_data_get(ruuvi_driver_sensor_data
   memset(raw_acceleration.u8bit, 0x00, 3 * sizeof(int16_t));
   err_code |= lis2dh12_acceleration_raw_get(&(dev.ctx), raw_acceleration.u8bit);
   err_code |= lis2dh12_temperature_raw_get(&(dev.ctx), raw_temperature);
-  // Compensate data with resolution, scale
-  float acceleration[3];
-  float temperature;
-  err_code |= rawToMg(&raw_acceleration, acceleration);
-  err_code |= rawToC(raw_temperature, &temperature);
+  // Compensate data with scale and calibration
+  float values[4];
+  err_code |= ruuvi_interface_lis2dh12_raw_to_g(raw_acceleration.i16bit, values, 1);
+  err_code |= rawToC(raw_temperature, &values[3]);
   uint8_t mode;
   err_code |= ruuvi_interface_lis2dh12_mode_get(&mode);
 
@@ -826,18 +928,12 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_data_get(ruuvi_driver_sensor_data
       && RUUVI_DRIVER_SUCCESS == err_code)
   {
     ruuvi_driver_sensor_data_t d_acceleration;
-    float values[4];
     ruuvi_driver_sensor_data_fields_t acc_fields = {.bitfield = 0};
     d_acceleration.data = values;
     acc_fields.datas.acceleration_x_g = 1;
     acc_fields.datas.acceleration_y_g = 1;
     acc_fields.datas.acceleration_z_g = 1;
     acc_fields.datas.temperature_c = 1;
-    //Convert mG to G.
-    values[0] = acceleration[0] / 1000.0;
-    values[1] = acceleration[1] / 1000.0;
-    values[2] = acceleration[2] / 1000.0;
-    values[3] = temperature;
     d_acceleration.valid  = acc_fields;
     d_acceleration.fields = acc_fields;
     ruuvi_driver_sensor_data_populate(data,
@@ -884,25 +980,28 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_fifo_read(size_t* num_elements,
 
   // get current time
   p_data->timestamp_ms = ruuvi_driver_sensor_timestamp_get();
-  // Read all elements
-  axis3bit16_t raw_acceleration;
-  float acceleration[3];
+  // Read all elements, then convert the whole block in one pass
+  axis3bit16_t raw_acceleration[LIS2DH12_FIFO_MAX_ELEMENTS];
+  float acceleration[LIS2DH12_FIFO_MAX_ELEMENTS * 3];
+
+  if(elements > LIS2DH12_FIFO_MAX_ELEMENTS) { elements = LIS2DH12_FIFO_MAX_ELEMENTS; }
+
+  for(size_t ii = 0; ii < elements; ii++)
+  {
+    err_code |= lis2dh12_acceleration_raw_get(&(dev.ctx), raw_acceleration[ii].u8bit);
+  }
+
+  err_code |= ruuvi_interface_lis2dh12_raw_to_g(raw_acceleration[0].i16bit, acceleration,
+              elements);
+  ruuvi_driver_sensor_data_fields_t acc_fields = {.bitfield = 0};
+  acc_fields.datas.acceleration_x_g = 1;
+  acc_fields.datas.acceleration_y_g = 1;
+  acc_fields.datas.acceleration_z_g = 1;
 
   for(size_t ii = 0; ii < elements; ii++)
   {
-    err_code |= lis2dh12_acceleration_raw_get(&(dev.ctx), raw_acceleration.u8bit);
-    // Compensate data with resolution, scale
-    err_code |= rawToMg(&raw_acceleration, acceleration);
     ruuvi_driver_sensor_data_t d_acceleration;
-    ruuvi_driver_sensor_data_fields_t acc_fields = {.bitfield = 0};
-    acc_fields.datas.acceleration_x_g = 1;
-    acc_fields.datas.acceleration_y_g = 1;
-    acc_fields.datas.acceleration_z_g = 1;
-    //Convert mG to G
-    acceleration[0] = acceleration[0] / 1000.0;
-    acceleration[1] = acceleration[1] / 1000.0;
-    acceleration[2] = acceleration[2] / 1000.0;
-    d_acceleration.data = acceleration;
+    d_acceleration.data = &(acceleration[ii * 3]);
     d_acceleration.valid  = acc_fields;
     d_acceleration.fields = acc_fields;
     ruuvi_driver_sensor_data_populate(&(p_data[ii]),
@@ -914,11 +1013,219 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_fifo_read(size_t* num_elements,
   return err_code;
 }
 
+/**
+ * @brief Route or unroute an event source to interrupt pin.
+ *
+ * Registers are read before writing, so other events routed to the pins are kept.
+ * Source is removed from the other pin.
+ *
+ * @param[in] source Event source to route.
+ * @param[in] enable True to route source to pin, false to remove source from both pins.
+ * @param[in] pin Pin to route to.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if pin is not valid.
+ * @return error code from stack on other error.
+ */
+static ruuvi_driver_status_t lis2dh12_interrupt_route(const route_t source,
+    const bool enable, const ruuvi_interface_lis2dh12_pin_t pin)
+{
+  if(RUUVI_INTERFACE_LIS2DH12_INT1 != pin
+      && RUUVI_INTERFACE_LIS2DH12_INT2 != pin)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  lis2dh12_ctrl_reg3_t ctrl3 = { 0 };
+  lis2dh12_ctrl_reg6_t ctrl6 = { 0 };
+  const uint8_t int1 = (enable && RUUVI_INTERFACE_LIS2DH12_INT1 == pin);
+  const uint8_t int2 = (enable && RUUVI_INTERFACE_LIS2DH12_INT2 == pin);
+  err_code |= lis2dh12_pin_int1_config_get(&(dev.ctx), &ctrl3);
+  err_code |= lis2dh12_pin_int2_config_get(&(dev.ctx), &ctrl6);
+
+  switch(source)
+  {
+    case ROUTE_IA1:
+      ctrl3.i1_ia1 = int1;
+      ctrl6.i2_ia1 = int2;
+      break;
+
+    case ROUTE_IA2:
+      ctrl3.i1_ia2 = int1;
+      ctrl6.i2_ia2 = int2;
+      break;
+
+    case ROUTE_CLICK:
+      ctrl3.i1_click = int1;
+      ctrl6.i2_click = int2;
+      break;
+
+    default:
+      return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  err_code |= lis2dh12_pin_int1_config_set(&(dev.ctx), &ctrl3);
+  err_code |= lis2dh12_pin_int2_config_set(&(dev.ctx), &ctrl6);
+  return err_code;
+}
+
+/**
+ * @brief Convert acceleration to 7-bit threshold register value.
+ *
+ * Threshold is rounded up, i.e. "at least this much" and limit_g is
+ * written with the value represented by the threshold.
+ *
+ * @param[in, out] limit_g Acceleration to convert.
+ * @param[in] lsb_g Gravities per LSB of the threshold register.
+ * @param[out] threshold Register value.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if limit cannot be represented.
+ */
+static ruuvi_driver_status_t lis2dh12_threshold_from_g(float* const limit_g,
+    const float lsb_g, uint8_t* const threshold)
+{
+  if(0 > *limit_g) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  uint32_t ths = (uint32_t)(*limit_g / lsb_g) + 1;
+
+  if(ths > LIS2DH12_7BIT_MAX) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  *limit_g = ths * lsb_g;
+  *threshold = (uint8_t) ths;
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+/**
+ * @brief Get gravities per LSB of interrupt generator threshold at current scale.
+ *
+ * 1 LSb = 16 mg @ FS = 2 g
+ * 1 LSb = 32 mg @ FS = 4 g
+ * 1 LSb = 62 mg @ FS = 8 g
+ * 1 LSb = 186 mg @ FS = 16 g
+ */
+static float lis2dh12_int_threshold_lsb(void)
+{
+  switch(dev.scale)
+  {
+    case LIS2DH12_4g:
+      return 0.032f;
+
+    case LIS2DH12_8g:
+      return 0.062f;
+
+    case LIS2DH12_16g:
+      return 0.186f;
+
+    case LIS2DH12_2g:
+    default:
+      return 0.016f;
+  }
+}
+
+/**
+ * @brief Get gravities per LSB of click threshold at current scale.
+ *
+ * 1 LSb = full scale / 128.
+ */
+static float lis2dh12_click_threshold_lsb(void)
+{
+  switch(dev.scale)
+  {
+    case LIS2DH12_4g:
+      return 4.0f / 128;
+
+    case LIS2DH12_8g:
+      return 8.0f / 128;
+
+    case LIS2DH12_16g:
+      return 16.0f / 128;
+
+    case LIS2DH12_2g:
+    default:
+      return 2.0f / 128;
+  }
+}
+
+/**
+ * @brief Get configured output data rate in Hz.
+ *
+ * Uses configured rate rather than rate in register, as register is set to
+ * power down while sensor sleeps.
+ *
+ * @return Output data rate in Hz, 0 if samplerate is not configured.
+ */
+static uint32_t lis2dh12_odr_hz(void)
+{
+  switch(dev.odr)
+  {
+    case LIS2DH12_ODR_1Hz:
+      return 1;
+
+    case LIS2DH12_ODR_10Hz:
+      return 10;
+
+    case LIS2DH12_ODR_25Hz:
+      return 25;
+
+    case LIS2DH12_ODR_50Hz:
+      return 50;
+
+    case LIS2DH12_ODR_100Hz:
+      return 100;
+
+    case LIS2DH12_ODR_200Hz:
+      return 200;
+
+    case LIS2DH12_ODR_400Hz:
+      return 400;
+
+    case LIS2DH12_ODR_1kHz620_LP:
+      return 1620;
+
+    case LIS2DH12_ODR_5kHz376_LP_1kHz344_NM_HP:
+      return (LIS2DH12_LP_8bit == dev.resolution) ? 5376 : 1344;
+
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Convert milliseconds to number of samples at current samplerate.
+ *
+ * Duration is rounded up to next sample and written back with the
+ * duration represented by the samples.
+ *
+ * @param[in, out] duration_ms Duration to convert.
+ * @param[in] max Maximum number of samples register can hold.
+ * @param[out] samples Number of samples.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if samplerate is not configured.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if duration cannot be represented.
+ */
+static ruuvi_driver_status_t lis2dh12_samples_from_ms(uint16_t* const duration_ms,
+    const uint8_t max, uint8_t* const samples)
+{
+  const uint32_t odr = lis2dh12_odr_hz();
+
+  if(0 == odr) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  uint32_t count = ((uint32_t)(*duration_ms) * odr + 999) / 1000;
+
+  if(count > max) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  *duration_ms = (uint16_t)((count * 1000 + odr - 1) / odr);
+  *samples = (uint8_t) count;
+  return RUUVI_DRIVER_SUCCESS;
+}
 
 ruuvi_driver_status_t ruuvi_interface_lis2dh12_fifo_interrupt_use(const bool enable)
 {
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
   lis2dh12_ctrl_reg3_t ctrl = { 0 };
+  // Keep other events routed to INT1
+  err_code |= lis2dh12_pin_int1_config_get(&(dev.ctx), &ctrl);
+  ctrl.i1_wtm = PROPERTY_DISABLE;
 
   if(true == enable)
   {
@@ -934,9 +1241,11 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_fifo_interrupt_use(const bool ena
 
 /**
  * Enable activity interrupt on LIS2DH12
- * Triggers as ACTIVE HIGH interrupt while detected movement is above threshold limit_g
+ * Triggers as ACTIVE HIGH interrupt once detected movement is above threshold limit_g
  * Axes are high-passed for this interrupt, i.e. gravity won't trigger the interrupt
  * Axes are examined individually, compound acceleration won't trigger the interrupt.
+ * Interrupt is latched until source is read with
+ * @ref ruuvi_interface_lis2dh12_interrupt_events_get.
  *
  * parameter enable:  True to enable interrupt, false to disable interrupt
  * parameter limit_g: Desired acceleration to trigger the interrupt.
@@ -956,9 +1265,7 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_activity_interrupt_use(const bool
 
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
   lis2dh12_hp_t high_pass = LIS2DH12_ON_INT1_GEN;
-  lis2dh12_ctrl_reg6_t ctrl6 = { 0 };
   lis2dh12_int1_cfg_t  cfg = { 0 };
-  ctrl6.i2_ia1 = PROPERTY_ENABLE;
 
   if(enable)
   {
@@ -974,52 +1281,208 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_activity_interrupt_use(const bool
   cfg.ylie     = PROPERTY_ENABLE;
   cfg.zlie     = PROPERTY_ENABLE;
   */
-  // Adjust for scale
-  // 1 LSb = 16 mg @ FS = 2 g
-  // 1 LSb = 32 mg @ FS = 4 g
-  // 1 LSb = 62 mg @ FS = 8 g
-  // 1 LSb = 186 mg @ FS = 16 g
-  uint8_t  scale;
-  uint32_t threshold;
-  float divisor;
-  err_code |= ruuvi_interface_lis2dh12_scale_get(&scale);
-
-  switch(scale)
-  {
-    case 2:
-      divisor = 0.016f;
-      break;
-
-    case 4:
-      divisor = 0.032f;
-      break;
+  // Threshold LSB depends on scale
+  uint8_t  threshold;
+  err_code |= lis2dh12_threshold_from_g(limit_g, lis2dh12_int_threshold_lsb(), &threshold);
 
-    case 8:
-      divisor = 0.062f;
-      break;
-
-    case 16:
-      divisor = 0.186f;
-      break;
-
-    default:
-      divisor = 0.016f;
-      break;
-  }
-
-  threshold = (uint32_t)(*limit_g / divisor) + 1;
-
-  if(threshold > 0x7F) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+  if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
 
-  *limit_g = threshold * divisor;
   // Configure highpass on INTERRUPT 1
   err_code |= lis2dh12_high_pass_int_conf_set(&(dev.ctx), high_pass);
   // Configure INTERRUPT 1 Threshold
   err_code |= lis2dh12_int1_gen_threshold_set(&(dev.ctx), threshold);
   // Configure INTERRUPT 1 ON ZHI, ZLO, YHI, YLO, XHI, XLO
   err_code |= lis2dh12_int1_gen_conf_set(&(dev.ctx), &cfg);
+  // Latch INTERRUPT 1 so that source is valid when read outside of interrupt context
+  err_code |= lis2dh12_int1_pin_notification_mode_set(&(dev.ctx),
+              enable ? LIS2DH12_INT1_LATCHED : LIS2DH12_INT1_PULSED);
+  // Reading source releases a previously latched interrupt
+  lis2dh12_int1_src_t src = { 0 };
+  err_code |= lis2dh12_int1_gen_source_get(&(dev.ctx), &src);
   // Route INTERRUPT 1 to PIN 2
-  err_code |= lis2dh12_pin_int2_config_set(&(dev.ctx), &ctrl6);
+  err_code |= lis2dh12_interrupt_route(ROUTE_IA1, enable, RUUVI_INTERFACE_LIS2DH12_INT2);
+  return err_code;
+}
+
+/**
+ * @brief Latch interrupt generator 2 like generator 1 of activity detection.
+ *
+ * Free-fall and orientation events are short, latched source stays valid until
+ * it is read outside of interrupt context.
+ *
+ * @param[in] enable True to latch, false to pulse.
+ * @return RUUVI_DRIVER_SUCCESS on success, error code from stack otherwise.
+ */
+static ruuvi_driver_status_t lis2dh12_int2_latch(const bool enable)
+{
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  err_code |= lis2dh12_int2_pin_notification_mode_set(&(dev.ctx),
+              enable ? LIS2DH12_INT2_LATCHED : LIS2DH12_INT2_PULSED);
+  // Reading source releases a previously latched interrupt
+  lis2dh12_int2_src_t src = { 0 };
+  err_code |= lis2dh12_int2_gen_source_get(&(dev.ctx), &src);
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_free_fall_use(const bool enable,
+    float* limit_g, uint16_t* duration_ms, const ruuvi_interface_lis2dh12_pin_t pin)
+{
+  if(NULL == limit_g || NULL == duration_ms) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  // Do not disturb orientation detection
+  if(IA2_ORIENTATION == dev.ia2_use)
+  {
+    return enable ? RUUVI_DRIVER_ERROR_INVALID_STATE : RUUVI_DRIVER_SUCCESS;
+  }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  lis2dh12_int2_cfg_t cfg = { 0 };
+  uint8_t threshold = 0;
+  uint8_t duration = 0;
+
+  if(enable)
+  {
+    err_code |= lis2dh12_threshold_from_g(limit_g, lis2dh12_int_threshold_lsb(),
+                                          &threshold);
+    err_code |= lis2dh12_samples_from_ms(duration_ms, LIS2DH12_7BIT_MAX, &duration);
+
+    if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
+
+    // All axes low at the same time.
+    cfg.xlie = PROPERTY_ENABLE;
+    cfg.ylie = PROPERTY_ENABLE;
+    cfg.zlie = PROPERTY_ENABLE;
+    cfg.aoi  = PROPERTY_ENABLE;
+  }
+
+  err_code |= lis2dh12_int2_gen_threshold_set(&(dev.ctx), threshold);
+  err_code |= lis2dh12_int2_gen_duration_set(&(dev.ctx), duration);
+  err_code |= lis2dh12_int2_gen_conf_set(&(dev.ctx), &cfg);
+  err_code |= lis2dh12_int2_latch(enable);
+  err_code |= lis2dh12_interrupt_route(ROUTE_IA2, enable, pin);
+  dev.ia2_use = (enable && RUUVI_DRIVER_SUCCESS == err_code) ? IA2_FREE_FALL : IA2_NONE;
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_orientation_use(const bool enable,
+    float* limit_g, const bool four_d, const ruuvi_interface_lis2dh12_pin_t pin)
+{
+  if(NULL == limit_g) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  // Do not disturb free-fall detection
+  if(IA2_FREE_FALL == dev.ia2_use)
+  {
+    return enable ? RUUVI_DRIVER_ERROR_INVALID_STATE : RUUVI_DRIVER_SUCCESS;
+  }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  lis2dh12_int2_cfg_t cfg = { 0 };
+  uint8_t threshold = 0;
+
+  if(enable)
+  {
+    err_code |= lis2dh12_threshold_from_g(limit_g, lis2dh12_int_threshold_lsb(),
+                                          &threshold);
+
+    if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
+
+    // 6D movement recognition: trigger when device enters a known position.
+    cfg.xlie = PROPERTY_ENABLE;
+    cfg.xhie = PROPERTY_ENABLE;
+    cfg.ylie = PROPERTY_ENABLE;
+    cfg.yhie = PROPERTY_ENABLE;
+    cfg.zlie = PROPERTY_ENABLE;
+    cfg.zhie = PROPERTY_ENABLE;
+    cfg._6d  = PROPERTY_ENABLE;
+  }
+
+  err_code |= lis2dh12_int2_gen_threshold_set(&(dev.ctx), threshold);
+  err_code |= lis2dh12_int2_gen_duration_set(&(dev.ctx), 0);
+  err_code |= lis2dh12_int2_pin_detect_4d_set(&(dev.ctx), enable && four_d);
+  err_code |= lis2dh12_int2_gen_conf_set(&(dev.ctx), &cfg);
+  err_code |= lis2dh12_int2_latch(enable);
+  err_code |= lis2dh12_interrupt_route(ROUTE_IA2, enable, pin);
+  dev.ia2_use = (enable && RUUVI_DRIVER_SUCCESS == err_code) ? IA2_ORIENTATION : IA2_NONE;
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_click_use(const bool enable,
+    ruuvi_interface_lis2dh12_click_cfg_t* const config,
+    const ruuvi_interface_lis2dh12_pin_t pin)
+{
+  if(enable && NULL == config) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  lis2dh12_click_cfg_t click = { 0 };
+  uint8_t threshold = 0;
+  uint8_t time_limit = 0;
+  uint8_t latency = 0;
+  uint8_t window = 0;
+  bool route = false;
+
+  if(enable)
+  {
+    err_code |= lis2dh12_threshold_from_g(&(config->threshold_g),
+                                          lis2dh12_click_threshold_lsb(), &threshold);
+    err_code |= lis2dh12_samples_from_ms(&(config->time_limit_ms), LIS2DH12_7BIT_MAX,
+                                         &time_limit);
+    err_code |= lis2dh12_samples_from_ms(&(config->latency_ms), LIS2DH12_8BIT_MAX,
+                                         &latency);
+    err_code |= lis2dh12_samples_from_ms(&(config->window_ms), LIS2DH12_8BIT_MAX,
+                                         &window);
+
+    if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
+
+    click.xs = config->single;
+    click.ys = config->single;
+    click.zs = config->single;
+    click.xd = config->dual;
+    click.yd = config->dual;
+    click.zd = config->dual;
+    route = config->single || config->dual;
+  }
+
+  err_code |= lis2dh12_tap_threshold_set(&(dev.ctx), threshold);
+  err_code |= lis2dh12_shock_dur_set(&(dev.ctx), time_limit);
+  err_code |= lis2dh12_quiet_dur_set(&(dev.ctx), latency);
+  err_code |= lis2dh12_double_tap_timeout_set(&(dev.ctx), window);
+  err_code |= lis2dh12_tap_conf_set(&(dev.ctx), &click);
+  err_code |= lis2dh12_interrupt_route(ROUTE_CLICK, route, pin);
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_interrupt_events_get(
+  ruuvi_interface_lis2dh12_events_t* const events)
+{
+  if(NULL == events) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  lis2dh12_int1_src_t src1 = { 0 };
+  lis2dh12_int2_src_t src2 = { 0 };
+  lis2dh12_click_src_t click = { 0 };
+  err_code |= lis2dh12_int1_gen_source_get(&(dev.ctx), &src1);
+  err_code |= lis2dh12_int2_gen_source_get(&(dev.ctx), &src2);
+  err_code |= lis2dh12_tap_source_get(&(dev.ctx), &click);
+  events->bitfield = 0;
+  events->events.activity = src1.ia;
+
+  if(IA2_FREE_FALL == dev.ia2_use)
+  {
+    events->events.free_fall = src2.ia;
+  }
+  else if(IA2_ORIENTATION == dev.ia2_use)
+  {
+    events->events.orientation = src2.ia;
+    events->events.x_low  = src2.xl;
+    events->events.x_high = src2.xh;
+    events->events.y_low  = src2.yl;
+    events->events.y_high = src2.yh;
+    events->events.z_low  = src2.zl;
+    events->events.z_high = src2.zh;
+  }
+
+  events->events.single_click = click.ia && click.sclick;
+  events->events.double_click = click.ia && click.dclick;
   return err_code;
 }
 /*@}*/
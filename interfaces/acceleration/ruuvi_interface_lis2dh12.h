@@ -7,7 +7,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
-#include <stddef.h>
+#include <stdint.h>
 
 /**
  * @addtogroup Acceleration
@@ -18,8 +18,8 @@
  * @brief Implement @ref ruuvi_driver_sensor_t functions on LIS2DH12
  *
  * The implementation supports
- * different resolutions, samplerates, high-passing, activity interrupt
- * and FIFO.
+ * different resolutions, samplerates, high-passing, activity interrupt,
+ * free-fall, 6D/4D orientation and click detection and FIFO.
  */
 /*@}*/
 /**
@@ -61,6 +61,63 @@
 /** @brief Resolution used on "default" setting. */
 #define RUUVI_INTERFACE_LIS2DH12_DEFAULT_RESOLUTION 10
 
+/**
+ * @brief Calibration applied to acceleration values.
+ *
+ * Output axis N is source axis axis[N] multiplied by gain[N] and added with offset_g[N].
+ * Negative gain can be used to flip the direction of an axis, for example if the
+ * sensor is mounted upside down.
+ */
+typedef struct
+{
+  float offset_g[3]; //!< Offset of X, Y, Z output, G.
+  float gain[3];     //!< Gain of X, Y, Z output.
+  uint8_t axis[3];   //!< Source axis of X, Y, Z output, 0 = X, 1 = Y, 2 = Z.
+} ruuvi_interface_lis2dh12_calibration_t;
+
+/** @brief Interrupt pin of LIS2DH12 to route event to. */
+typedef enum
+{
+  RUUVI_INTERFACE_LIS2DH12_INT1 = 1, //!< Route event to INT1 pin.
+  RUUVI_INTERFACE_LIS2DH12_INT2 = 2  //!< Route event to INT2 pin.
+} ruuvi_interface_lis2dh12_pin_t;
+
+/** @brief Click detection configuration, @ref ruuvi_interface_lis2dh12_click_use. */
+typedef struct
+{
+  float threshold_g;      //!< Acceleration to detect as click.
+  uint16_t time_limit_ms; //!< Maximum duration of click.
+  uint16_t latency_ms;    //!< Dead time after first click of double click.
+  uint16_t window_ms;     //!< Time after latency to detect second click of double click.
+  bool single;            //!< True to detect single clicks.
+  bool dual;              //!< True to detect double clicks.
+} ruuvi_interface_lis2dh12_click_cfg_t;
+
+/**
+ * @brief Events decoded from LIS2DH12 interrupt source registers.
+ *
+ * Position bits are valid if orientation detection is in use and
+ * tell which axes are over the threshold in which direction.
+ */
+typedef union
+{
+  uint16_t bitfield; //!< All events as bitfield.
+  struct
+  {
+    uint16_t activity : 1;     //!< Activity interrupt generator triggered.
+    uint16_t free_fall : 1;    //!< Free-fall detected.
+    uint16_t orientation : 1;  //!< Orientation changed.
+    uint16_t single_click : 1; //!< Single click detected.
+    uint16_t double_click : 1; //!< Double click detected.
+    uint16_t x_low : 1;        //!< X-axis points down.
+    uint16_t x_high : 1;       //!< X-axis points up.
+    uint16_t y_low : 1;        //!< Y-axis points down.
+    uint16_t y_high : 1;       //!< Y-axis points up.
+    uint16_t z_low : 1;        //!< Z-axis points down.
+    uint16_t z_high : 1;       //!< Z-axis points up.
+  } events; //!< Individual events.
+} ruuvi_interface_lis2dh12_events_t;
+
 /** @brief @ref ruuvi_driver_sensor_init_fp */
 ruuvi_driver_status_t ruuvi_interface_lis2dh12_init(ruuvi_driver_sensor_t*
     acceleration_sensor, ruuvi_driver_bus_t bus, uint8_t handle);
@@ -91,6 +148,45 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_mode_get(uint8_t*);
 ruuvi_driver_status_t ruuvi_interface_lis2dh12_data_get(ruuvi_driver_sensor_data_t* const
     data);
 
+/**
+ * @brief Set calibration applied to acceleration.
+ *
+ * Calibration is combined with current scale into a precomputed conversion,
+ * so calibration does not add cost to reading samples.
+ *
+ * @param[in] calibration Calibration to apply. NULL to remove calibration.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if source axis is not 0, 1 or 2.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_calibration_set(
+  const ruuvi_interface_lis2dh12_calibration_t* const calibration);
+
+/**
+ * @brief Get calibration applied to acceleration.
+ *
+ * @param[out] calibration Calibration in use, identity if calibration was removed.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if calibration is NULL.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_calibration_get(
+  ruuvi_interface_lis2dh12_calibration_t* const calibration);
+
+/**
+ * @brief Convert a block of raw samples to G.
+ *
+ * Uses conversion precomputed for current scale and calibration, so the block is
+ * converted in a single pass without branching per sample. Uses CMSIS-DSP if
+ * ARM_MATH_CM4 is defined and calibration does not remap axes or add offset.
+ *
+ * @param[in] raw Left-justified raw values, interleaved X, Y, Z. 3 * samples long.
+ * @param[out] acceleration Acceleration in G, interleaved X, Y, Z. 3 * samples long.
+ * @param[in] samples Number of XYZ samples to convert.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if raw or acceleration is NULL.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_raw_to_g(const int16_t* const raw,
+    float* const acceleration, const size_t samples);
+
 /**
 * @brief Enable 32-level FIFO in LIS2DH12
 * If FIFO is enabled, values are stored on LIS2DH12 FIFO and oldest element is returned on data read.
@@ -125,9 +221,11 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_fifo_interrupt_use(const bool ena
 
 /**
 * Enable activity interrupt on LIS2DH12
-* Triggers as ACTIVE HIGH interrupt while detected movement is above threshold limit_g
+* Triggers as ACTIVE HIGH interrupt once detected movement is above threshold limit_g
 * Axes are high-passed for this interrupt, i.e. gravity won't trigger the interrupt
 * Axes are examined individually, compound acceleration won't trigger the interrupt.
+* Interrupt is latched until source is read with
+* @ref ruuvi_interface_lis2dh12_interrupt_events_get.
 *
 * @param[in] enable  True to enable interrupt, false to disable interrupt
 * @param[in, out] limit_g: Desired acceleration to trigger the interrupt.
@@ -141,6 +239,91 @@ ruuvi_driver_status_t ruuvi_interface_lis2dh12_fifo_interrupt_use(const bool ena
 */
 ruuvi_driver_status_t ruuvi_interface_lis2dh12_activity_interrupt_use(const bool enable,
     float* limit_g);
+
+/**
+ * @brief Enable free-fall detection on LIS2DH12.
+ *
+ * Free-fall is detected when all axes are below threshold at the same time for
+ * at least given duration. Uses interrupt generator 2 and therefore cannot be
+ * used at the same time with orientation detection.
+ * Sensor must be in continuous mode for duration to be meaningful, duration
+ * is counted in samples at configured samplerate. Interrupt is latched until source
+ * is read with @ref ruuvi_interface_lis2dh12_interrupt_events_get.
+ *
+ * @param[in] enable True to enable detection, false to disable.
+ * @param[in, out] limit_g Threshold of free-fall, typically 0.35 G. Rounded up, written
+ *                         with the value set to sensor.
+ * @param[in, out] duration_ms Minimum duration of free-fall. Rounded up to next sample,
+ *                             written with the value set to sensor.
+ * @param[in] pin Interrupt pin to route event to.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if limit_g or duration_ms is NULL
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if limit or duration cannot be represented.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if orientation detection is in use
+ *                                          or samplerate is not set.
+ * @return error code from stack on other error.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_free_fall_use(const bool enable,
+    float* limit_g, uint16_t* duration_ms, const ruuvi_interface_lis2dh12_pin_t pin);
+
+/**
+ * @brief Enable orientation change detection on LIS2DH12.
+ *
+ * Triggers when sensor moves to a new known position. In 6D mode all six directions
+ * are detected, in 4D mode Z-axis is ignored. Uses interrupt generator 2 and
+ * therefore cannot be used at the same time with free-fall detection.
+ * New position can be read from @ref ruuvi_interface_lis2dh12_events_t. Interrupt
+ * is latched until source is read with @ref ruuvi_interface_lis2dh12_interrupt_events_get.
+ *
+ * @param[in] enable True to enable detection, false to disable.
+ * @param[in, out] limit_g Threshold of axis pointing to gravity, typically 0.7 G.
+ *                         Rounded up, written with the value set to sensor.
+ * @param[in] four_d True to use 4D detection, false to use 6D.
+ * @param[in] pin Interrupt pin to route event to.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if limit_g is NULL
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if limit cannot be represented.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if free-fall detection is in use.
+ * @return error code from stack on other error.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_orientation_use(const bool enable,
+    float* limit_g, const bool four_d, const ruuvi_interface_lis2dh12_pin_t pin);
+
+/**
+ * @brief Enable single and/or double click detection on LIS2DH12.
+ *
+ * Click is detected on all axes. Timing parameters are counted in samples
+ * at configured samplerate, so samplerate must be set before configuring clicks.
+ * Click engine requires samplerate of at least 100 Hz to work reliably.
+ *
+ * @param[in] enable True to enable detection, false to disable.
+ * @param[in, out] config Configuration of click detection. Written with the values
+ *                        set to sensor. Ignored if enable is false.
+ * @param[in] pin Interrupt pin to route event to.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if config is NULL and enable is true.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if configuration cannot be represented.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if samplerate is not set.
+ * @return error code from stack on other error.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_click_use(const bool enable,
+    ruuvi_interface_lis2dh12_click_cfg_t* const config,
+    const ruuvi_interface_lis2dh12_pin_t pin);
+
+/**
+ * @brief Read and decode interrupt sources of LIS2DH12.
+ *
+ * Call this from GPIO interrupt handler (or from scheduler task queued by the handler)
+ * to find out which event caused the interrupt. Reading sources clears latched
+ * interrupts.
+ *
+ * @param[out] events Events which are active in sensor.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if events is NULL
+ * @return error code from stack on other error.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_interrupt_events_get(
+  ruuvi_interface_lis2dh12_events_t* const events);
 /*@}*/
 #endif
 #endif
\ No newline at end of file
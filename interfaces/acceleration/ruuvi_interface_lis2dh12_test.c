@@ -0,0 +1,245 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_RUN_TESTS && RUUVI_INTERFACE_ACCELERATION_LIS2DH12_ENABLED
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_sensor.h"
+#include "ruuvi_driver_test.h"
+#include "ruuvi_interface_lis2dh12.h"
+#include "ruuvi_interface_lis2dh12_test.h"
+#include "ruuvi_interface_rtc.h"
+#include "ruuvi_interface_spi.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/** @brief Raw input shared by tests, interleaved X, Y, Z. */
+static int16_t m_raw[RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES * 3];
+/** @brief Reference output. */
+static float m_reference[RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES * 3];
+/** @brief Output under test. */
+static float m_converted[RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES * 3];
+
+static void raw_fill(void)
+{
+  for(size_t ii = 0; ii < sizeof(m_raw) / sizeof(int16_t); ii++)
+  {
+    m_raw[ii] = (int16_t)((ii * 1021) - 16384);
+  }
+}
+
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_test_conversion(void)
+{
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  const size_t samples = RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES;
+  ruuvi_interface_lis2dh12_calibration_t app_calibration;
+  ruuvi_interface_lis2dh12_calibration_get(&app_calibration);
+  raw_fill();
+  // - Conversion must return RUUVI_DRIVER_ERROR_NULL if input or output is NULL.
+  err_code = ruuvi_interface_lis2dh12_raw_to_g(NULL, m_converted, samples);
+  err_code |= ruuvi_interface_lis2dh12_raw_to_g(m_raw, NULL, samples);
+
+  if(RUUVI_DRIVER_ERROR_NULL != err_code)
+  {
+    RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+    ruuvi_driver_test_register(false);
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  ruuvi_driver_test_register(true);
+  // - Calibration must return RUUVI_DRIVER_ERROR_INVALID_PARAM if source axis is over 2.
+  ruuvi_interface_lis2dh12_calibration_t calibration =
+  {
+    .offset_g = {0.1f, -0.2f, 0.3f},
+    .gain     = {1.01f, -1.0f, 0.98f},
+    .axis     = {1, 3, 0}
+  };
+  err_code = ruuvi_interface_lis2dh12_calibration_set(&calibration);
+
+  if(RUUVI_DRIVER_ERROR_INVALID_PARAM != err_code)
+  {
+    RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+    ruuvi_driver_test_register(false);
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  ruuvi_driver_test_register(true);
+  // - Calibrated output axis N must equal uncalibrated source axis * gain + offset.
+  calibration.axis[1] = 2;
+  calibration.axis[2] = 0;
+  err_code = ruuvi_interface_lis2dh12_calibration_set(NULL);
+  err_code |= ruuvi_interface_lis2dh12_raw_to_g(m_raw, m_reference, samples);
+  err_code |= ruuvi_interface_lis2dh12_calibration_set(&calibration);
+  err_code |= ruuvi_interface_lis2dh12_raw_to_g(m_raw, m_converted, samples);
+  bool fail = (RUUVI_DRIVER_SUCCESS != err_code);
+
+  for(size_t ii = 0; ii < samples && !fail; ii++)
+  {
+    for(size_t jj = 0; jj < 3; jj++)
+    {
+      const float expect = m_reference[ii * 3 + calibration.axis[jj]]
+                           * calibration.gain[jj] + calibration.offset_g[jj];
+
+      if(!ruuvi_driver_expect_close(expect, -4, m_converted[ii * 3 + jj])) { fail = true; }
+    }
+  }
+
+  if(fail)
+  {
+    RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+    ruuvi_driver_test_register(false);
+    ruuvi_interface_lis2dh12_calibration_set(&app_calibration);
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  ruuvi_driver_test_register(true);
+  // - Conversion must be equal to uncalibrated conversion after calibration is removed.
+  err_code = ruuvi_interface_lis2dh12_calibration_set(NULL);
+  err_code |= ruuvi_interface_lis2dh12_raw_to_g(m_raw, m_converted, samples);
+  fail = (RUUVI_DRIVER_SUCCESS != err_code);
+
+  for(size_t ii = 0; ii < samples * 3 && !fail; ii++)
+  {
+    if(m_reference[ii] != m_converted[ii]) { fail = true; }
+  }
+
+  ruuvi_interface_lis2dh12_calibration_set(&app_calibration);
+
+  if(fail)
+  {
+    RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+    ruuvi_driver_test_register(false);
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  ruuvi_driver_test_register(true);
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+/**
+ * @brief Run conversion benchmark rounds.
+ *
+ * @return Nanoseconds per sample.
+ */
+static uint32_t benchmark_run(void)
+{
+  const uint64_t start_us = ruuvi_interface_rtc_micros();
+
+  for(size_t ii = 0; ii < RUUVI_INTERFACE_LIS2DH12_TEST_BENCHMARK_ROUNDS; ii++)
+  {
+    ruuvi_interface_lis2dh12_raw_to_g(m_raw, m_converted,
+                                      RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES);
+  }
+
+  const uint64_t elapsed_us = ruuvi_interface_rtc_micros() - start_us;
+  return (uint32_t)((elapsed_us * 1000) / (RUUVI_INTERFACE_LIS2DH12_TEST_BENCHMARK_ROUNDS
+                    * RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES));
+}
+
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_test_conversion_benchmark(
+  const ruuvi_driver_test_print_fp printfp)
+{
+  if(RUUVI_DRIVER_UINT64_INVALID == ruuvi_interface_rtc_micros())
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_STATE;
+  }
+
+  char msg[128];
+  ruuvi_interface_lis2dh12_calibration_t app_calibration;
+  ruuvi_interface_lis2dh12_calibration_get(&app_calibration);
+  const ruuvi_interface_lis2dh12_calibration_t calibration =
+  {
+    .offset_g = {0.1f, -0.2f, 0.3f},
+    .gain     = {1.01f, -1.0f, 0.98f},
+    .axis     = {1, 2, 0}
+  };
+  raw_fill();
+  ruuvi_interface_lis2dh12_calibration_set(NULL);
+  const uint32_t plain_ns = benchmark_run();
+  ruuvi_interface_lis2dh12_calibration_set(&calibration);
+  const uint32_t calibrated_ns = benchmark_run();
+  ruuvi_interface_lis2dh12_calibration_set(&app_calibration);
+  const uint32_t resolution_ns = (1000000000U / ruuvi_interface_rtc_ticks_per_second())
+                                 / (RUUVI_INTERFACE_LIS2DH12_TEST_BENCHMARK_ROUNDS
+                                    * RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES);
+  snprintf(msg, sizeof(msg),
+           "LIS2DH12 raw to G: %lu ns / sample, calibrated %lu ns / sample, +-%lu ns.\r\n",
+           (unsigned long) plain_ns, (unsigned long) calibrated_ns,
+           (unsigned long) resolution_ns);
+  printfp(msg);
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+/** @brief Read command of WHO_AM_I register. */
+#define REGISTER_TEST_WHO_AM_I (0x0F | 0x80)
+/** @brief Read command of OUT_X_L register with address increment. */
+#define REGISTER_TEST_OUT_X_L  (0x28 | 0x80 | 0x40)
+
+/** @brief Register read as separate command and data transfers. */
+static ruuvi_driver_status_t register_read_split(const ruuvi_interface_gpio_id_t ss,
+    uint8_t command, uint8_t* const data, const size_t len)
+{
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  err_code |= ruuvi_interface_gpio_write(ss, RUUVI_INTERFACE_GPIO_LOW);
+  err_code |= ruuvi_interface_spi_xfer_blocking(&command, 1, NULL, 0);
+  err_code |= ruuvi_interface_spi_xfer_blocking(NULL, 0, data, len);
+  err_code |= ruuvi_interface_gpio_write(ss, RUUVI_INTERFACE_GPIO_HIGH);
+  return err_code;
+}
+
+/**
+ * @brief Run register read rounds.
+ *
+ * @return Nanoseconds per read.
+ */
+static uint32_t register_benchmark_run(const ruuvi_interface_gpio_id_t ss,
+                                       const bool combined)
+{
+  uint8_t data[6];
+  const uint64_t start_us = ruuvi_interface_rtc_micros();
+
+  for(size_t ii = 0; ii < RUUVI_INTERFACE_LIS2DH12_TEST_REGISTER_ROUNDS; ii++)
+  {
+    if(combined)
+    {
+      ruuvi_interface_spi_register_read(ss, REGISTER_TEST_OUT_X_L, data, sizeof(data));
+    }
+    else { register_read_split(ss, REGISTER_TEST_OUT_X_L, data, sizeof(data)); }
+  }
+
+  const uint64_t elapsed_us = ruuvi_interface_rtc_micros() - start_us;
+  return (uint32_t)((elapsed_us * 1000) / RUUVI_INTERFACE_LIS2DH12_TEST_REGISTER_ROUNDS);
+}
+
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_test_register_benchmark(
+  const ruuvi_driver_test_print_fp printfp, const ruuvi_interface_gpio_id_t ss)
+{
+  if(RUUVI_DRIVER_UINT64_INVALID == ruuvi_interface_rtc_micros())
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_STATE;
+  }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  char msg[128];
+  uint8_t split_id = 0;
+  uint8_t combined_id = 0;
+  // - Combined read must return the same WHO_AM_I as separate transfers.
+  err_code |= register_read_split(ss, REGISTER_TEST_WHO_AM_I, &split_id, 1);
+  err_code |= ruuvi_interface_spi_register_read(ss, REGISTER_TEST_WHO_AM_I, &combined_id, 1);
+
+  if(RUUVI_DRIVER_SUCCESS != err_code || split_id != combined_id)
+  {
+    err_code |= RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  ruuvi_driver_test_register(RUUVI_DRIVER_SUCCESS == err_code);
+  const uint32_t split_ns = register_benchmark_run(ss, false);
+  const uint32_t combined_ns = register_benchmark_run(ss, true);
+  const uint32_t resolution_ns = (1000000000U / ruuvi_interface_rtc_ticks_per_second())
+                                 / RUUVI_INTERFACE_LIS2DH12_TEST_REGISTER_ROUNDS;
+  snprintf(msg, sizeof(msg),
+           "LIS2DH12 6-byte register read: %lu ns separate, %lu ns combined, +-%lu ns.\r\n",
+           (unsigned long) split_ns, (unsigned long) combined_ns,
+           (unsigned long) resolution_ns);
+  printfp(msg);
+  return err_code;
+}
+
+#endif
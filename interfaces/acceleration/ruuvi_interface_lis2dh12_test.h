@@ -0,0 +1,79 @@
+#ifndef RUUVI_INTERFACE_LIS2DH12_TEST_H
+#define RUUVI_INTERFACE_LIS2DH12_TEST_H
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_test.h"
+#include "ruuvi_interface_gpio.h"
+#include <stdbool.h>
+/**
+ * @addtogroup LIS2DH12
+ * @{
+ */
+/**
+* @file ruuvi_interface_lis2dh12_test.h
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-10-21
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Test raw to G conversion defined in @ref ruuvi_interface_lis2dh12.h
+*
+*/
+
+/** @brief Number of blocks converted in benchmark. */
+#define RUUVI_INTERFACE_LIS2DH12_TEST_BENCHMARK_ROUNDS 1000
+/** @brief Number of samples in one block, equal to full FIFO. */
+#define RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES 32
+/** @brief Number of register reads in SPI benchmark. */
+#define RUUVI_INTERFACE_LIS2DH12_TEST_REGISTER_ROUNDS 1000
+
+/**
+ * @brief Test raw to G conversion with calibration.
+ *
+ * - Conversion must return @c RUUVI_DRIVER_ERROR_NULL if input or output is @c NULL.
+ * - Calibration must return @c RUUVI_DRIVER_ERROR_INVALID_PARAM if source axis is over 2.
+ * - Calibrated output axis N must equal uncalibrated source axis * gain + offset.
+ * - Conversion must be equal to uncalibrated conversion after calibration is removed.
+ *
+ * Calibration in use before test is restored after test.
+ *
+ * @return @c RUUVI_DRIVER_SUCCESS if all tests pass, error code on failure
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_test_conversion(void);
+
+/**
+ * @brief Benchmark raw to G conversion.
+ *
+ * Converts @ref RUUVI_INTERFACE_LIS2DH12_TEST_BENCHMARK_ROUNDS blocks of
+ * @ref RUUVI_INTERFACE_LIS2DH12_TEST_BLOCK_SAMPLES samples with and without
+ * calibration and prints the time taken per sample and resolution of the result.
+ * Time is measured with @ref ruuvi_interface_rtc_micros, RTC must be running.
+ * Calibration in use before benchmark is restored after benchmark.
+ *
+ * @param[in] printfp Function to print results with.
+ * @return @c RUUVI_DRIVER_SUCCESS if benchmark was run.
+ * @return @c RUUVI_DRIVER_ERROR_INVALID_STATE if RTC is not running.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_test_conversion_benchmark(
+  const ruuvi_driver_test_print_fp printfp);
+
+/**
+ * @brief Benchmark SPI register reads of LIS2DH12.
+ *
+ * Reads acceleration registers @ref RUUVI_INTERFACE_LIS2DH12_TEST_REGISTER_ROUNDS
+ * times with separate command and data transfers and with one combined register
+ * transfer, and prints the time taken per read and resolution of the result.
+ * Time is measured with @ref ruuvi_interface_rtc_micros. Requires SPI to be
+ * initialized, LIS2DH12 to be connected and RTC to be running.
+ *
+ * - Combined read must return the same WHO_AM_I as separate transfers.
+ *
+ * @param[in] printfp Function to print results with.
+ * @param[in] ss Slave select pin of LIS2DH12.
+ * @return @c RUUVI_DRIVER_SUCCESS if benchmark was run and reads matched.
+ * @return @c RUUVI_DRIVER_ERROR_INVALID_STATE if RTC is not running.
+ * @return @c RUUVI_DRIVER_ERROR_SELFTEST if reads did not match.
+ */
+ruuvi_driver_status_t ruuvi_interface_lis2dh12_test_register_benchmark(
+  const ruuvi_driver_test_print_fp printfp, const ruuvi_interface_gpio_id_t ss);
+
+/*@}*/
+#endif
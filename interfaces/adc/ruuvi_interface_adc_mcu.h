@@ -3,6 +3,8 @@
 #include "ruuvi_driver_error.h"
 #include "ruuvi_driver_sensor.h"
 #include "ruuvi_interface_adc.h"
+#include "ruuvi_interface_adc_stream.h"
+#include "ruuvi_interface_communication_radio.h"
 #include "ruuvi_interface_gpio.h"
 /**
  * @addtogroup ADC
@@ -51,6 +53,15 @@ typedef struct
   bool negative_pulldown_active;           //!< True to enable pulldown to AGND
 } ruuvi_interface_adc_sample_t;
 
+/** @brief Supply voltage measured around radio transmission. */
+typedef struct
+{
+  uint64_t timestamp_ms; //!< Time of sample under load.
+  float idle_v;          //!< Voltage before radio activity.
+  float loaded_v;        //!< Voltage during transmission.
+  float droop_v;         //!< Idle voltage minus loaded voltage.
+} ruuvi_interface_adc_droop_t;
+
 /** @brief @ref ruuvi_driver_sensor_init_fp */
 ruuvi_driver_status_t ruuvi_interface_adc_mcu_init(ruuvi_driver_sensor_t* adc_sensor,
     ruuvi_driver_bus_t, uint8_t handle);
@@ -98,5 +109,111 @@ ruuvi_driver_status_t ruuvi_interface_adc_mcu_data_get(ruuvi_driver_sensor_data_
  */
 ruuvi_driver_status_t ruuvi_interface_adc_complex_sample(const
     ruuvi_interface_adc_sample_t* const sample, ruuvi_interface_adc_data_t* const data);
+
+/**
+ * @brief Sample several channels in one scan.
+ *
+ * All channels are converted on a single trigger while the ADC is enabled once,
+ * results share one timestamp. Oversampling is common to all channels,
+ * the largest number of oversamples requested by any channel is used.
+ * Initializes the ADC before sampling and uninitializes the ADC after sampling.
+ * Reference may be @ref RUUVI_INTERFACE_ADC_VREF_INTERNAL or
+ * @ref RUUVI_INTERFACE_ADC_AINVDD. With AINVDD reference only the ratiometric
+ * value is valid.
+ *
+ * @param[in]  samples definitions of the channels to sample
+ * @param[in]  count number of channels, at most 8
+ * @param[out] data values of samples in volts and as a ratio to reference, in order of
+ *             samples.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if either pointer is NULL
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if ADC is already initialized
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if count or any channel is invalid
+ * @return RUUVI_DRIVER_ERROR_TIMEOUT if conversion did not complete, ADC is stopped.
+ * @return error code from stack on other error.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_scan(const ruuvi_interface_adc_sample_t*
+    const samples, const size_t count, ruuvi_interface_adc_data_t* const data);
+
+/**
+ * @brief Start continuous sampling of ADC channel in hardware.
+ *
+ * Samples are triggered by a hardware timer and written to buffers by DMA,
+ * CPU wakes up once per buffer. Completed buffers are delivered as batches
+ * in scheduler context, see @ref ruuvi_interface_adc_stream.h.
+ * ADC must be initialized and oversampling disabled. ADC is in continuous mode
+ * until @ref ruuvi_interface_adc_mcu_stream_stop is called.
+ *
+ * @param[in] buffers Memory for buffer_count * samples values.
+ * @param[in] buffer_count Number of buffers, at least
+ *                         @ref RUUVI_INTERFACE_ADC_STREAM_MIN_BUFFERS.
+ * @param[in] samples Number of samples in one buffer.
+ * @param[in] interval_us Time between samples, at least 5 us.
+ * @param[in] handler Function to receive batches.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if buffers or handler is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if ADC is not initialized, is not in
+ *         sleep or uses oversampling.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if buffers or interval are invalid.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_stream_start(int16_t* const buffers,
+    const size_t buffer_count, const size_t samples, const uint32_t interval_us,
+    const ruuvi_interface_adc_batch_fp_t handler);
+
+/**
+ * @brief Stop continuous sampling. Batches which were not delivered are discarded.
+ *
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_stream_stop(void);
+
+/**
+ * @brief Measure voltage droop of initialized channel on every radio transmission.
+ *
+ * Idle voltage is sampled when radio notifies upcoming activity, loaded voltage is
+ * sampled by hardware timer delay_us later while radio transmits.
+ * Radio driver forwards its activity events to
+ * @ref ruuvi_interface_adc_mcu_radio_activity_handler, no application callback is
+ * needed. Initialize ADC on AINVDD to measure battery under load.
+ * ADC is in continuous mode until @ref ruuvi_interface_adc_mcu_droop_stop is called.
+ *
+ * @param[in] delay_us Time from radio activity event to loaded sample. Radio
+ *                     notifies 800 us ahead of activity, ramp-up takes about 140 us.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if ADC is not initialized, is not in
+ *         sleep or uses oversampling.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if delay_us is 0.
+ * @return RUUVI_DRIVER_ERROR_NOT_SUPPORTED if droop measurement is not enabled.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_droop_start(const uint32_t delay_us);
+
+/**
+ * @brief Stop droop measurement. Latest measurement remains available.
+ *
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_droop_stop(void);
+
+/**
+ * @brief Radio activity handler of droop measurement. Called in interrupt context.
+ *
+ * Measurement is discarded if radio activity ends before loaded sample is taken.
+ *
+ * @param[in] evt Radio activity event.
+ */
+void ruuvi_interface_adc_mcu_radio_activity_handler(const
+    ruuvi_interface_communication_radio_activity_evt_t evt);
+
+/**
+ * @brief Get latest droop measurement.
+ *
+ * @param[out] data Latest measurement. Values are invalid if there has been no
+ *                  measurement.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if data is NULL.
+ * @return RUUVI_DRIVER_ERROR_NOT_SUPPORTED if droop measurement is not enabled.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_droop_get(ruuvi_interface_adc_droop_t*
+    const data);
 /*@}*/
 #endif
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED || DOXYGEN
+#include "ruuvi_driver_error.h"
+#include "ruuvi_interface_adc_stream.h"
+#include "ruuvi_interface_scheduler.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @addtogroup ADC
+ *
+ */
+/*@{*/
+/**
+ * @file ruuvi_interface_adc_stream.c
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-04
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ * @brief Continuous ADC sampling into a ring of DMA buffers.
+ *
+ * Buffer states are written by source in interrupt context and by consumer in
+ * scheduler context. Source only takes FREE buffers and appends to ready queue tail,
+ * consumer only frees buffers and advances the queue head.
+ */
+
+/** @brief State of a buffer. */
+typedef enum
+{
+  BUFFER_FREE = 0, //!< Buffer can be given to source.
+  BUFFER_SOURCE,   //!< Buffer is being filled by source.
+  BUFFER_READY     //!< Buffer is filled and waits for consumer.
+} buffer_state_t;
+
+static int16_t* m_buffers;
+static size_t m_buffer_count;
+static size_t m_samples;
+static uint32_t m_interval_us;
+static float m_volts_per_lsb;
+static ruuvi_interface_adc_batch_fp_t m_handler;
+
+static volatile uint8_t m_state[RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS];
+static size_t m_count[RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS];
+static uint64_t m_timestamp[RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS];
+static uint32_t m_dropped[RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS];
+static volatile uint8_t m_ready[RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS]; //!< Ready queue.
+static volatile uint32_t m_ready_head; //!< Written by consumer.
+static volatile uint32_t m_ready_tail; //!< Written by source.
+static uint32_t m_dropped_pending;     //!< Written by source.
+
+static void stream_scheduler_handler(void* p_event_data, uint16_t event_size)
+{
+  ruuvi_interface_adc_stream_process();
+}
+
+/** @brief Take a free buffer for source, NULL if none is free. */
+static int16_t* stream_buffer_take(void)
+{
+  for(size_t ii = 0; ii < m_buffer_count; ii++)
+  {
+    if(BUFFER_FREE == m_state[ii])
+    {
+      m_state[ii] = BUFFER_SOURCE;
+      return m_buffers + (ii * m_samples);
+    }
+  }
+
+  return NULL;
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_stream_init(int16_t* const buffers,
+    const size_t buffer_count, const size_t samples, const uint32_t interval_us,
+    const float volts_per_lsb, const ruuvi_interface_adc_batch_fp_t handler)
+{
+  if(NULL == buffers || NULL == handler) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(RUUVI_INTERFACE_ADC_STREAM_MIN_BUFFERS > buffer_count || RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS < buffer_count
+      || 0 == samples)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  if(NULL != m_buffers) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  for(size_t ii = 0; ii < RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS; ii++)
+  {
+    m_state[ii] = BUFFER_FREE;
+  }
+
+  m_buffer_count = buffer_count;
+  m_samples = samples;
+  m_interval_us = interval_us;
+  m_volts_per_lsb = volts_per_lsb;
+  m_handler = handler;
+  m_ready_head = 0;
+  m_ready_tail = 0;
+  m_dropped_pending = 0;
+  m_buffers = buffers;
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_stream_uninit(void)
+{
+  m_buffers = NULL;
+  m_handler = NULL;
+  m_buffer_count = 0;
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+bool ruuvi_interface_adc_stream_is_init(void)
+{
+  return (NULL != m_buffers);
+}
+
+int16_t* ruuvi_interface_adc_stream_buffer_get(void)
+{
+  if(NULL == m_buffers) { return NULL; }
+
+  return stream_buffer_take();
+}
+
+int16_t* ruuvi_interface_adc_stream_buffer_done(int16_t* const buffer, const size_t count,
+    const uint64_t timestamp_ms)
+{
+  if(NULL == m_buffers || NULL == buffer) { return NULL; }
+
+  const size_t index = (size_t)(buffer - m_buffers) / m_samples;
+
+  if(index >= m_buffer_count) { return NULL; }
+
+  int16_t* const next = stream_buffer_take();
+
+  // No room for a new batch, keep sampling into the same buffer.
+  if(NULL == next)
+  {
+    m_dropped_pending++;
+    return buffer;
+  }
+
+  m_count[index] = (count > m_samples) ? m_samples : count;
+  m_timestamp[index] = timestamp_ms;
+  m_dropped[index] = m_dropped_pending;
+  m_dropped_pending = 0;
+  m_state[index] = BUFFER_READY;
+  // Next buffer was taken from free buffers before this one is queued, so at most
+  // buffer_count - 1 buffers are ready and tail never catches up with head.
+  m_ready[m_ready_tail] = (uint8_t) index;
+  m_ready_tail = (m_ready_tail + 1) % m_buffer_count;
+  // If scheduler queue is full batch is delivered with the next one.
+  ruuvi_interface_scheduler_event_put(NULL, 0, stream_scheduler_handler);
+  return next;
+}
+
+size_t ruuvi_interface_adc_stream_process(void)
+{
+  size_t delivered = 0;
+
+  while(NULL != m_buffers && m_ready_head != m_ready_tail)
+  {
+    const uint8_t index = m_ready[m_ready_head];
+    const size_t intervals = m_count[index] ? m_count[index] - 1 : 0;
+    const uint64_t span_ms = ((uint64_t) m_interval_us * intervals) / 1000;
+    ruuvi_interface_adc_batch_t batch =
+    {
+      .timestamp_ms  = m_timestamp[index] - span_ms,
+      .interval_us   = m_interval_us,
+      .samples       = m_buffers + (index * m_samples),
+      .count         = m_count[index],
+      .volts_per_lsb = m_volts_per_lsb,
+      .dropped       = m_dropped[index]
+    };
+
+    if(RUUVI_DRIVER_UINT64_INVALID == m_timestamp[index] || span_ms > m_timestamp[index])
+    {
+      batch.timestamp_ms = RUUVI_DRIVER_UINT64_INVALID;
+    }
+
+    m_handler(&batch);
+    m_state[index] = BUFFER_FREE;
+    m_ready_head = (m_ready_head + 1) % m_buffer_count;
+    delivered++;
+  }
+
+  return delivered;
+}
+
+/*@}*/
+#endif
@@ -0,0 +1,140 @@
+#ifndef RUUVI_INTERFACE_ADC_STREAM_H
+#define RUUVI_INTERFACE_ADC_STREAM_H
+#include "ruuvi_driver_error.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+/**
+ * @addtogroup ADC
+ *
+ */
+/*@{*/
+/**
+ * @file ruuvi_interface_adc_stream.h
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-04
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ * @brief Continuous ADC sampling into a ring of DMA buffers.
+ *
+ * Platform ADC driver fills buffers given by @ref ruuvi_interface_adc_stream_buffer_done
+ * without CPU involvement per sample. Completed buffers are delivered as batches to
+ * the application in scheduler context. Buffers are owned by the stream until
+ * the handler of the batch returns.
+ *
+ * If application does not consume batches fast enough newest batch is dropped,
+ * as the buffer has to be given back to DMA right away to keep sampling running.
+ * Number of dropped batches is reported with next delivered batch.
+ *
+ * The module does not depend on ADC hardware, any source which fills buffers can
+ * drive it.
+ *
+ * @code{.c}
+ *  static int16_t buffers[4 * 256];
+ *  err_code = ruuvi_interface_adc_stream_init(buffers, 4, 256, 125, 0.0035f, on_batch);
+ *  // Source, i.e. DMA done interrupt:
+ *  int16_t* next = ruuvi_interface_adc_stream_buffer_done(done, 256, timestamp);
+ * @endcode
+ */
+
+/**
+ * @brief Minimum number of buffers in stream.
+ *
+ * Source keeps two buffers queued for DMA, a third one is needed to hold a completed
+ * batch until consumer runs.
+ */
+#define RUUVI_INTERFACE_ADC_STREAM_MIN_BUFFERS 3
+/** @brief Maximum number of buffers in stream. */
+#define RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS 8
+
+/** @brief Batch of consecutive samples. */
+typedef struct
+{
+  uint64_t timestamp_ms;  //!< Time of first sample in batch.
+  uint32_t interval_us;   //!< Time between samples.
+  const int16_t* samples; //!< Raw ADC values.
+  size_t count;           //!< Number of samples.
+  float volts_per_lsb;    //!< Multiplier from raw value to volts.
+  uint32_t dropped;       //!< Number of batches dropped since previous delivered batch.
+} ruuvi_interface_adc_batch_t;
+
+/**
+ * @brief Function to receive completed batches.
+ *
+ * Samples may be accessed only until the function returns.
+ *
+ * @param[in] batch Completed batch.
+ */
+typedef void (*ruuvi_interface_adc_batch_fp_t)(const ruuvi_interface_adc_batch_t* const
+    batch);
+
+/**
+ * @brief Initialize stream over given buffer memory.
+ *
+ * @param[in] buffers Memory for buffer_count * samples values, must stay valid until
+ *                    @ref ruuvi_interface_adc_stream_uninit.
+ * @param[in] buffer_count Number of buffers, at least
+ *                         @ref RUUVI_INTERFACE_ADC_STREAM_MIN_BUFFERS.
+ * @param[in] samples Number of samples in one buffer.
+ * @param[in] interval_us Time between samples.
+ * @param[in] volts_per_lsb Multiplier from raw value to volts, reported in batches.
+ * @param[in] handler Function called with completed batches.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if buffers or handler is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if buffer count is less than
+ *         @ref RUUVI_INTERFACE_ADC_STREAM_MIN_BUFFERS or more than
+ *         @ref RUUVI_INTERFACE_ADC_STREAM_MAX_BUFFERS or samples is 0.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if stream is already initialized.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_stream_init(int16_t* const buffers,
+    const size_t buffer_count, const size_t samples, const uint32_t interval_us,
+    const float volts_per_lsb, const ruuvi_interface_adc_batch_fp_t handler);
+
+/**
+ * @brief Uninitialize stream. Pending batches are discarded.
+ *
+ * @return RUUVI_DRIVER_SUCCESS.
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_stream_uninit(void);
+
+/**
+ * @brief Check if stream is initialized.
+ *
+ * @return true if stream is initialized.
+ */
+bool ruuvi_interface_adc_stream_is_init(void);
+
+/**
+ * @brief Get a free buffer for source to fill.
+ *
+ * Called by source before starting, once per buffer to queue in DMA.
+ *
+ * @return Pointer to buffer, NULL if there is no free buffer.
+ */
+int16_t* ruuvi_interface_adc_stream_buffer_get(void);
+
+/**
+ * @brief Mark a buffer filled and get the next buffer to fill.
+ *
+ * Safe to call from interrupt context. Batch is delivered in scheduler context.
+ * If there is no free buffer the filled buffer is dropped and returned back to source.
+ *
+ * @param[in] buffer Filled buffer, as returned by this module.
+ * @param[in] count Number of samples in buffer.
+ * @param[in] timestamp_ms Time of last sample in buffer.
+ * @return Buffer to fill next, NULL if stream is not initialized.
+ */
+int16_t* ruuvi_interface_adc_stream_buffer_done(int16_t* const buffer, const size_t count,
+    const uint64_t timestamp_ms);
+
+/**
+ * @brief Deliver all completed batches to handler.
+ *
+ * Called from scheduler after @ref ruuvi_interface_adc_stream_buffer_done,
+ * can be called directly if scheduler is not used.
+ *
+ * @return Number of batches delivered.
+ */
+size_t ruuvi_interface_adc_stream_process(void);
+
+/*@}*/
+#endif
@@ -0,0 +1,112 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_RUN_TESTS && RUUVI_INTERFACE_ADC_STREAM_ENABLED
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_test.h"
+#include "ruuvi_interface_adc_stream.h"
+#include "ruuvi_interface_adc_stream_test.h"
+#include <stdbool.h>
+#include <string.h>
+
+/** @brief Memory of buffers under test. */
+static int16_t m_buffers[RUUVI_INTERFACE_ADC_STREAM_TEST_BUFFERS *
+                         RUUVI_INTERFACE_ADC_STREAM_TEST_SAMPLES];
+/** @brief Copy of latest delivered batch. */
+static ruuvi_interface_adc_batch_t m_batch;
+/** @brief Copy of samples of latest delivered batch. */
+static int16_t m_samples[RUUVI_INTERFACE_ADC_STREAM_TEST_SAMPLES];
+
+static void batch_handler(const ruuvi_interface_adc_batch_t* const batch)
+{
+  m_batch = *batch;
+  memcpy(m_samples, batch->samples, batch->count * sizeof(int16_t));
+}
+
+/** @brief Simulate ADC filling buffer with a ramp starting at start. */
+static void source_fill(int16_t* const buffer, const int16_t start)
+{
+  for(size_t ii = 0; ii < RUUVI_INTERFACE_ADC_STREAM_TEST_SAMPLES; ii++)
+  {
+    buffer[ii] = start + (int16_t) ii;
+  }
+}
+
+static bool batch_matches(const int16_t start, const uint64_t timestamp,
+                          const uint32_t dropped)
+{
+  bool match = (RUUVI_INTERFACE_ADC_STREAM_TEST_SAMPLES == m_batch.count)
+               && (timestamp == m_batch.timestamp_ms)
+               && (dropped == m_batch.dropped);
+
+  for(size_t ii = 0; ii < m_batch.count && match; ii++)
+  {
+    match = (start + (int16_t) ii == m_samples[ii]);
+  }
+
+  return match;
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_stream_test(void)
+{
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  const size_t samples = RUUVI_INTERFACE_ADC_STREAM_TEST_SAMPLES;
+  bool fail = false;
+  // - Init must return RUUVI_DRIVER_ERROR_NULL if buffers or handler is NULL.
+  err_code = ruuvi_interface_adc_stream_init(NULL, RUUVI_INTERFACE_ADC_STREAM_TEST_BUFFERS,
+             samples, 1000, 1.0f, batch_handler);
+  err_code |= ruuvi_interface_adc_stream_init(m_buffers,
+              RUUVI_INTERFACE_ADC_STREAM_TEST_BUFFERS, samples, 1000, 1.0f, NULL);
+
+  if(RUUVI_DRIVER_ERROR_NULL != err_code) { fail = true; }
+
+  ruuvi_driver_test_register(!fail);
+  // - Init must return RUUVI_DRIVER_ERROR_INVALID_PARAM with 2 buffers, which both
+  //   would be queued to source with no room for a completed batch.
+  err_code = ruuvi_interface_adc_stream_init(m_buffers, 2, samples, 1000, 1.0f,
+             batch_handler);
+
+  if(RUUVI_DRIVER_ERROR_INVALID_PARAM != err_code) { fail = true; }
+
+  ruuvi_driver_test_register(RUUVI_DRIVER_ERROR_INVALID_PARAM == err_code);
+  // - Filled buffer must be delivered once, in order, with samples unchanged.
+  // - Timestamp of batch must be the time of first sample.
+  err_code = ruuvi_interface_adc_stream_init(m_buffers,
+             RUUVI_INTERFACE_ADC_STREAM_TEST_BUFFERS, samples, 1000, 1.0f, batch_handler);
+  int16_t* const first = ruuvi_interface_adc_stream_buffer_get();
+  int16_t* const second = ruuvi_interface_adc_stream_buffer_get();
+  source_fill(first, 100);
+  int16_t* const third = ruuvi_interface_adc_stream_buffer_done(first, samples, 1000);
+  bool pass = (RUUVI_DRIVER_SUCCESS == err_code) && (NULL != third)
+              && (1 == ruuvi_interface_adc_stream_process())
+              && batch_matches(100, 1000 - (samples - 1), 0)
+              && (0 == ruuvi_interface_adc_stream_process());
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Source must get the filled buffer back if all other buffers are waiting for consumer.
+  source_fill(second, 200);
+  int16_t* const fourth = ruuvi_interface_adc_stream_buffer_done(second, samples, 2000);
+  source_fill(third, 300);
+  pass = (first == fourth)
+         && (third == ruuvi_interface_adc_stream_buffer_done(third, samples, 3000))
+         && (third == ruuvi_interface_adc_stream_buffer_done(third, samples, 4000))
+         && (1 == ruuvi_interface_adc_stream_process())
+         && batch_matches(200, 2000 - (samples - 1), 0);
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Next delivered batch must report number of dropped batches.
+  source_fill(fourth, 400);
+  pass = (NULL != ruuvi_interface_adc_stream_buffer_done(fourth, samples, 5000))
+         && (1 == ruuvi_interface_adc_stream_process())
+         && batch_matches(400, 5000 - (samples - 1), 2);
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  ruuvi_interface_adc_stream_uninit();
+
+  if(fail)
+  {
+    RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  return RUUVI_DRIVER_SUCCESS;
+}
+#endif
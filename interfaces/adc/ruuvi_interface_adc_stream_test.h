@@ -0,0 +1,42 @@
+#ifndef RUUVI_INTERFACE_ADC_STREAM_TEST_H
+#define RUUVI_INTERFACE_ADC_STREAM_TEST_H
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_test.h"
+/**
+ * @addtogroup ADC
+ * @{
+ */
+/**
+* @file ruuvi_interface_adc_stream_test.h
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-12-04
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Test batching of @ref ruuvi_interface_adc_stream.h with a simulated buffer source.
+*
+*/
+
+/** @brief Number of buffers in test stream. */
+#define RUUVI_INTERFACE_ADC_STREAM_TEST_BUFFERS 3
+/** @brief Number of samples in one buffer of test stream. */
+#define RUUVI_INTERFACE_ADC_STREAM_TEST_SAMPLES 8
+
+/**
+ * @brief Test ADC stream with simulated source.
+ *
+ * - Init must return @c RUUVI_DRIVER_ERROR_NULL if buffers or handler is @c NULL.
+ * - Init must return @c RUUVI_DRIVER_ERROR_INVALID_PARAM with 2 buffers, which both
+ *   would be queued to source with no room for a completed batch.
+ * - Filled buffer must be delivered once, in order, with samples unchanged.
+ * - Timestamp of batch must be the time of first sample.
+ * - Source must get the filled buffer back if all other buffers are waiting for consumer.
+ * - Next delivered batch must report number of dropped batches.
+ *
+ * Stream is uninitialized after test.
+ *
+ * @return @c RUUVI_DRIVER_SUCCESS if all tests pass, error code on failure
+ */
+ruuvi_driver_status_t ruuvi_interface_adc_stream_test(void);
+
+/*@}*/
+#endif
@@ -52,6 +52,19 @@ typedef volatile void* const ruuvi_interface_atomic_ptr;
  */
 bool ruuvi_interface_atomic_flag(ruuvi_interface_atomic_ptr flag, const bool set);
 
+/**
+ * @brief Enter critical region, application interrupts are blocked until exit.
+ *
+ * Use only for short updates of data shared with interrupts, which cannot return
+ * on a held lock. Regions may be nested, every enter must be paired with an exit.
+ */
+void ruuvi_interface_atomic_critical_enter(void);
+
+/**
+ * @brief Exit critical region entered with @ref ruuvi_interface_atomic_critical_enter.
+ */
+void ruuvi_interface_atomic_critical_exit(void);
+
 /*@}*/
 
 #endif
\ No newline at end of file
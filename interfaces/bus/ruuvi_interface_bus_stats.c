@@ -0,0 +1,159 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED || DOXYGEN
+#include "ruuvi_driver_error.h"
+#include "ruuvi_interface_bus_stats.h"
+#include "ruuvi_interface_log.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @addtogroup Bus
+ *
+ */
+/*@{*/
+/**
+ * @file ruuvi_interface_bus_stats.c
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-11
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ * @brief Per-device statistics of a bus.
+ */
+
+#define BUS_STATS_LOG_LINE_LEN 160 //!< Enough for all non-empty buckets.
+
+static uint8_t latency_bucket(uint32_t latency_us)
+{
+  uint8_t bucket = 0;
+
+  while(latency_us > 1 && bucket < (RUUVI_INTERFACE_BUS_STATS_BUCKETS - 1))
+  {
+    latency_us >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+/** @brief Get entry of device, add it if there is room. NULL if device does not fit. */
+static ruuvi_interface_bus_stats_t* device_entry(ruuvi_interface_bus_stats_table_t* const
+    table, const uint16_t device)
+{
+  for(size_t ii = 0; ii < table->count; ii++)
+  {
+    if(device == table->devices[ii].device) { return &(table->devices[ii]); }
+  }
+
+  if(RUUVI_INTERFACE_BUS_STATS_MAX_DEVICES <= table->count) { return NULL; }
+
+  ruuvi_interface_bus_stats_t* const entry = &(table->devices[table->count]);
+  memset(entry, 0, sizeof(ruuvi_interface_bus_stats_t));
+  entry->device = device;
+  table->count++;
+  return entry;
+}
+
+void ruuvi_interface_bus_stats_record(ruuvi_interface_bus_stats_table_t* const table,
+                                      const uint16_t device, const size_t bytes,
+                                      const uint32_t latency_us, const ruuvi_driver_status_t status)
+{
+  if(NULL == table) { return; }
+
+  ruuvi_interface_bus_stats_t* const entry = device_entry(table, device);
+
+  if(NULL == entry)
+  {
+    table->untracked++;
+    return;
+  }
+
+  if(RUUVI_DRIVER_ERROR_BUSY == status || RUUVI_DRIVER_ERROR_NO_MEM == status)
+  {
+    entry->busy++;
+    return;
+  }
+
+  if(RUUVI_DRIVER_ERROR_NOT_ACKNOWLEDGED == status || RUUVI_DRIVER_ERROR_NOT_FOUND == status)
+  {
+    entry->nacks++;
+  }
+  else if(RUUVI_DRIVER_ERROR_TIMEOUT == status) { entry->timeouts++; }
+  else if(RUUVI_DRIVER_SUCCESS != status) { entry->errors++; }
+
+  entry->transactions++;
+  entry->bytes += bytes;
+  entry->latency_us += latency_us;
+  entry->histogram[latency_bucket(latency_us)]++;
+}
+
+ruuvi_driver_status_t ruuvi_interface_bus_stats_find(const
+    ruuvi_interface_bus_stats_table_t* const table, const uint16_t device,
+    ruuvi_interface_bus_stats_t* const stats)
+{
+  if(NULL == table || NULL == stats) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  for(size_t ii = 0; ii < table->count; ii++)
+  {
+    if(device == table->devices[ii].device)
+    {
+      memcpy(stats, &(table->devices[ii]), sizeof(ruuvi_interface_bus_stats_t));
+      return RUUVI_DRIVER_SUCCESS;
+    }
+  }
+
+  return RUUVI_DRIVER_ERROR_NOT_FOUND;
+}
+
+void ruuvi_interface_bus_stats_reset(ruuvi_interface_bus_stats_table_t* const table)
+{
+  if(NULL == table) { return; }
+
+  table->count = 0;
+  table->untracked = 0;
+}
+
+void ruuvi_interface_bus_stats_log(const ruuvi_interface_bus_stats_table_t* const table,
+                                   const ruuvi_interface_log_severity_t severity, const char* const name)
+{
+  if(NULL == table || NULL == name) { return; }
+
+  char msg[BUS_STATS_LOG_LINE_LEN];
+
+  for(size_t ii = 0; ii < table->count; ii++)
+  {
+    const ruuvi_interface_bus_stats_t* const entry = &(table->devices[ii]);
+    snprintf(msg, sizeof(msg),
+             "%s 0x%02X: %lu xfers, %lu bytes, %lu us, %lu NACK, %lu timeout, "
+             "%lu busy, %lu error\r\n", name, entry->device,
+             (unsigned long) entry->transactions, (unsigned long) entry->bytes,
+             (unsigned long) entry->latency_us, (unsigned long) entry->nacks,
+             (unsigned long) entry->timeouts, (unsigned long) entry->busy,
+             (unsigned long) entry->errors);
+    ruuvi_interface_log(severity, msg);
+    size_t written = snprintf(msg, sizeof(msg), "%s 0x%02X us:", name, entry->device);
+
+    for(uint8_t bucket = 0; bucket < RUUVI_INTERFACE_BUS_STATS_BUCKETS
+        && written < sizeof(msg); bucket++)
+    {
+      if(0 != entry->histogram[bucket])
+      {
+        written += snprintf(msg + written, sizeof(msg) - written, " %lu:%lu",
+                            (unsigned long)(bucket ? (1UL << bucket) : 0),
+                            (unsigned long) entry->histogram[bucket]);
+      }
+    }
+
+    if(written < sizeof(msg) - 2) { snprintf(msg + written, sizeof(msg) - written, "\r\n"); }
+
+    ruuvi_interface_log(severity, msg);
+  }
+
+  if(0 != table->untracked)
+  {
+    snprintf(msg, sizeof(msg), "%s: %lu transactions of untracked devices\r\n", name,
+             (unsigned long) table->untracked);
+    ruuvi_interface_log(severity, msg);
+  }
+}
+
+/*@}*/
+#endif
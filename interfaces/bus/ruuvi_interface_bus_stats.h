@@ -0,0 +1,123 @@
+#ifndef RUUVI_INTERFACE_BUS_STATS_H
+#define RUUVI_INTERFACE_BUS_STATS_H
+#include "ruuvi_driver_error.h"
+#include "ruuvi_interface_log.h"
+#include <stddef.h>
+#include <stdint.h>
+/**
+ * @defgroup Bus Bus statistics
+ * @brief Transaction counters and latency histograms of devices on a shared bus.
+ *
+ */
+/*@{*/
+/**
+ * @file ruuvi_interface_bus_stats.h
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-11
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ * @brief Per-device statistics of a bus.
+ *
+ * Bus drivers own one table each and record every completed transaction into it
+ * from their interrupt context, see @ref ruuvi_interface_i2c_stats_get and
+ * @ref ruuvi_interface_spi_stats_get. Devices are identified by I2C address or
+ * by slave select pin.
+ *
+ * Latency is time the bus was used by transaction, waiting in queue is not included.
+ * Histogram bucket 0 counts latencies below 2 us, bucket n counts
+ * latencies of [2^n, 2^(n+1)) us and the last bucket everything above.
+ *
+ * @code{.c}
+ *  ruuvi_interface_bus_stats_t stats;
+ *  err_code = ruuvi_interface_bus_stats_find(ruuvi_interface_i2c_stats_get(), 0x76, &stats);
+ *  ruuvi_interface_bus_stats_log(ruuvi_interface_i2c_stats_get(), RUUVI_INTERFACE_LOG_INFO,
+ *                                "I2C");
+ * @endcode
+ */
+
+/** @brief Maximum number of devices tracked per bus. */
+#ifndef RUUVI_INTERFACE_BUS_STATS_MAX_DEVICES
+  #define RUUVI_INTERFACE_BUS_STATS_MAX_DEVICES 8
+#endif
+
+/** @brief Number of log2 latency buckets, last bucket starts at 32 ms. */
+#define RUUVI_INTERFACE_BUS_STATS_BUCKETS 16
+
+/** @brief Statistics of one device. */
+typedef struct
+{
+  uint16_t device;        //!< I2C address or slave select pin.
+  uint32_t transactions;  //!< Completed transactions, including failed ones.
+  uint32_t bytes;         //!< Bytes transferred in both directions.
+  uint32_t nacks;         //!< Transactions not acknowledged by device.
+  uint32_t timeouts;      //!< Transactions aborted on timeout.
+  uint32_t busy;          //!< Transactions rejected as bus or queue was busy.
+  uint32_t errors;        //!< Transactions failed on other errors.
+  uint32_t latency_us;    //!< Total bus time of transactions, wraps around.
+  uint32_t histogram[RUUVI_INTERFACE_BUS_STATS_BUCKETS]; //!< Latency distribution.
+} ruuvi_interface_bus_stats_t;
+
+/** @brief Statistics of all devices on a bus. */
+typedef struct
+{
+  ruuvi_interface_bus_stats_t devices[RUUVI_INTERFACE_BUS_STATS_MAX_DEVICES];
+  size_t count;       //!< Number of devices in table.
+  uint32_t untracked; //!< Transactions of devices which did not fit into table.
+} ruuvi_interface_bus_stats_table_t;
+
+/**
+ * @brief Record a transaction of a device.
+ *
+ * Device is added to table on its first transaction. Transactions rejected with
+ * RUUVI_DRIVER_ERROR_BUSY or RUUVI_DRIVER_ERROR_NO_MEM are counted only as busy,
+ * RUUVI_DRIVER_ERROR_NOT_ACKNOWLEDGED and RUUVI_DRIVER_ERROR_NOT_FOUND as NACKs.
+ * Must not be called concurrently on the same table.
+ *
+ * @param[in,out] table Table of the bus. Does nothing if NULL.
+ * @param[in] device I2C address or slave select pin of device.
+ * @param[in] bytes Number of bytes in transaction.
+ * @param[in] latency_us Bus time of transaction.
+ * @param[in] status Result of transaction.
+ */
+void ruuvi_interface_bus_stats_record(ruuvi_interface_bus_stats_table_t* const table,
+                                      const uint16_t device, const size_t bytes,
+                                      const uint32_t latency_us, const ruuvi_driver_status_t status);
+
+/**
+ * @brief Get statistics of a device.
+ *
+ * Statistics are updated in interrupt context, a copy taken while device is
+ * active may mix values of consecutive transactions.
+ *
+ * @param[in] table Table of the bus.
+ * @param[in] device I2C address or slave select pin of device.
+ * @param[out] stats Copy of statistics of device.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if table or stats is NULL.
+ * @return RUUVI_DRIVER_ERROR_NOT_FOUND if device has no recorded transactions.
+ */
+ruuvi_driver_status_t ruuvi_interface_bus_stats_find(const
+    ruuvi_interface_bus_stats_table_t* const table, const uint16_t device,
+    ruuvi_interface_bus_stats_t* const stats);
+
+/**
+ * @brief Clear all statistics of a bus.
+ *
+ * @param[in,out] table Table of the bus. Does nothing if NULL.
+ */
+void ruuvi_interface_bus_stats_reset(ruuvi_interface_bus_stats_table_t* const table);
+
+/**
+ * @brief Write statistics of all devices on a bus to log.
+ *
+ * One line of counters and one line of non-empty histogram buckets are written per
+ * device.
+ *
+ * @param[in] table Table of the bus. Does nothing if NULL.
+ * @param[in] severity Severity of log messages.
+ * @param[in] name Name of the bus printed on each line, i.e. "I2C".
+ */
+void ruuvi_interface_bus_stats_log(const ruuvi_interface_bus_stats_table_t* const table,
+                                   const ruuvi_interface_log_severity_t severity, const char* const name);
+
+/*@}*/
+#endif
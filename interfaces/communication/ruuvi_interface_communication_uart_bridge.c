@@ -0,0 +1,338 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_ENABLED || DOXYGEN
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_sensor.h"
+#include "ruuvi_interface_atomic.h"
+#include "ruuvi_interface_communication_uart_bridge.h"
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @addtogroup UART_bridge
+ *
+ */
+/*@{*/
+/**
+ * @file ruuvi_interface_communication_uart_bridge.c
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-13
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ * @brief Framed stream of scanned advertisements.
+ *
+ * Reports are queued in a short critical region, so a report is never lost to
+ * a concurrent drain. Queue is drained under a lock, caller which does not get the
+ * lock returns instead of waiting as it may have interrupted the holder. Drain
+ * request of such caller is left pending and the holder drains again after
+ * releasing the lock. Holder sends a copy of the oldest frame and removes it only
+ * if the frame was not dropped or replaced meanwhile.
+ */
+
+/** @brief Queued report. */
+typedef struct
+{
+  uint8_t addr[6];
+  uint32_t seq;     //!< Sequence number of report, changes when frame is replaced.
+  int8_t rssi;
+  uint32_t timestamp_ms;
+  uint8_t data_len;
+  uint8_t data[31];
+} bridge_frame_t;
+
+static bridge_frame_t m_queue[RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE];
+static size_t m_head  = 0; //!< Oldest frame.
+static size_t m_count = 0; //!< Number of queued frames.
+static uint32_t m_seq = 0;  //!< Sequence number of latest queued report.
+static ruuvi_interface_communication_uart_bridge_policy_t m_policy;
+static ruuvi_interface_communication_uart_bridge_send_fp_t m_send = NULL;
+static ruuvi_interface_communication_uart_bridge_stats_t m_stats;
+static ruuvi_interface_atomic_t m_lock = RUUVI_INTERFACE_ATOMIC_FLAG_INIT;
+static volatile bool m_drain_pending = false; //!< Drain was requested while locked.
+/** @brief Encoded frame, reused for every frame. */
+static uint8_t m_wire[RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_WIRE_MAX_LEN];
+
+size_t ruuvi_interface_communication_cobs_encode(const uint8_t* const input,
+    const size_t len, uint8_t* const output, const size_t output_size)
+{
+  if(NULL == input || NULL == output || 0 == output_size) { return 0; }
+
+  size_t code_index = 0; // Position of code byte of current block.
+  size_t written = 1;
+  uint8_t code = 1;
+
+  for(size_t ii = 0; ii < len; ii++)
+  {
+    if(written >= output_size) { return 0; }
+
+    if(0 != input[ii])
+    {
+      output[written++] = input[ii];
+      code++;
+    }
+
+    // Block ends on zero or after 254 non-zero bytes.
+    if(0 == input[ii] || 0xFF == code)
+    {
+      output[code_index] = code;
+      code = 1;
+      code_index = written;
+
+      if(0 == input[ii] || ii + 1 < len)
+      {
+        if(written >= output_size) { return 0; }
+
+        written++;
+      }
+    }
+  }
+
+  if(code_index < written) { output[code_index] = code; }
+
+  return written;
+}
+
+size_t ruuvi_interface_communication_cobs_decode(const uint8_t* const input,
+    const size_t len, uint8_t* const output, const size_t output_size)
+{
+  if(NULL == input || NULL == output) { return 0; }
+
+  size_t read = 0;
+  size_t written = 0;
+
+  while(read < len)
+  {
+    const uint8_t code = input[read++];
+
+    if(0 == code || (read + code - 1) > len) { return 0; }
+
+    for(uint8_t ii = 1; ii < code; ii++)
+    {
+      if(written >= output_size || 0 == input[read]) { return 0; }
+
+      output[written++] = input[read++];
+    }
+
+    // Block which ended before 254 bytes was followed by zero, except last block.
+    if(0xFF != code && read < len)
+    {
+      if(written >= output_size) { return 0; }
+
+      output[written++] = 0;
+    }
+  }
+
+  return written;
+}
+
+static size_t frame_encode(const bridge_frame_t* const frame)
+{
+  uint8_t raw[RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_FRAME_MAX_LEN];
+  memcpy(raw, frame->addr, sizeof(frame->addr));
+  raw[6] = (uint8_t) frame->rssi;
+  raw[7] = (uint8_t)(frame->timestamp_ms);
+  raw[8] = (uint8_t)(frame->timestamp_ms >> 8);
+  raw[9] = (uint8_t)(frame->timestamp_ms >> 16);
+  raw[10] = (uint8_t)(frame->timestamp_ms >> 24);
+  memcpy(raw + RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_HEADER_LEN, frame->data,
+         frame->data_len);
+  size_t len = ruuvi_interface_communication_cobs_encode(raw,
+               RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_HEADER_LEN + frame->data_len,
+               m_wire, sizeof(m_wire) - 1);
+  m_wire[len++] = 0;
+  return len;
+}
+
+// Write frames until sink is full. Call with lock held.
+static size_t queue_drain(void)
+{
+  size_t sent = 0;
+  bridge_frame_t frame;
+  bool queued = true;
+
+  while(queued)
+  {
+    ruuvi_interface_atomic_critical_enter();
+    queued = (0 != m_count);
+
+    if(queued) { memcpy(&frame, &m_queue[m_head], sizeof(frame)); }
+
+    ruuvi_interface_atomic_critical_exit();
+
+    if(!queued) { break; }
+
+    const size_t len = frame_encode(&frame);
+
+    // Frame is encoded again on next try.
+    if(RUUVI_DRIVER_SUCCESS != m_send(m_wire, len)) { break; }
+
+    sent++;
+    ruuvi_interface_atomic_critical_enter();
+
+    // Frame replaced by a newer report is sent again.
+    if(0 != m_count && frame.seq == m_queue[m_head].seq)
+    {
+      m_head = (m_head + 1) % RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE;
+      m_count--;
+    }
+
+    ruuvi_interface_atomic_critical_exit();
+  }
+
+  m_stats.sent += sent;
+  return sent;
+}
+
+// Release lock, drain for callers which found the lock held meanwhile.
+static size_t lock_release(void)
+{
+  size_t sent = 0;
+  ruuvi_interface_atomic_flag(&m_lock, false);
+
+  // Request arriving after the check gets the lock itself.
+  while(m_drain_pending && ruuvi_interface_atomic_flag(&m_lock, true))
+  {
+    m_drain_pending = false;
+    sent += queue_drain();
+    ruuvi_interface_atomic_flag(&m_lock, false);
+  }
+
+  return sent;
+}
+
+// Get slot for new report by policy, NULL if report is dropped. Call in critical region.
+static bridge_frame_t* queue_slot(const ruuvi_interface_communication_ble4_scan_t* const
+                                  scan)
+{
+  if(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_LATEST_PER_ADDRESS == m_policy)
+  {
+    for(size_t ii = 0; ii < m_count; ii++)
+    {
+      bridge_frame_t* const frame = &m_queue[(m_head + ii) %
+                                    RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE];
+
+      if(!memcmp(frame->addr, scan->addr, sizeof(frame->addr)))
+      {
+        m_stats.replaced++;
+        return frame;
+      }
+    }
+  }
+
+  if(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE == m_count)
+  {
+    m_stats.dropped++;
+
+    if(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_NEWEST == m_policy) { return NULL; }
+
+    m_head = (m_head + 1) % RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE;
+    m_count--;
+  }
+
+  bridge_frame_t* const frame = &m_queue[(m_head + m_count) %
+                                RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE];
+  m_count++;
+  return frame;
+}
+
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_init(
+  const ruuvi_interface_communication_uart_bridge_policy_t policy,
+  const ruuvi_interface_communication_uart_bridge_send_fp_t send)
+{
+  if(NULL == send) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_LATEST_PER_ADDRESS < policy)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  m_policy = policy;
+  m_head = 0;
+  m_count = 0;
+  m_seq = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_lock = RUUVI_INTERFACE_ATOMIC_FLAG_INIT;
+  m_drain_pending = false;
+  m_send = send;
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_uninit(void)
+{
+  m_send = NULL;
+  m_count = 0;
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_on_evt(
+  const ruuvi_interface_communication_evt_t evt, void* p_data, size_t data_len)
+{
+  if(NULL == m_send) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  if(RUUVI_INTERFACE_COMMUNICATION_RECEIVED != evt) { return RUUVI_DRIVER_SUCCESS; }
+
+  if(NULL == p_data) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(sizeof(ruuvi_interface_communication_ble4_scan_t) != data_len)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_LENGTH;
+  }
+
+  const ruuvi_interface_communication_ble4_scan_t* const scan =
+    (ruuvi_interface_communication_ble4_scan_t*) p_data;
+  const size_t copy_len = (scan->data_len > sizeof(m_queue[0].data)) ?
+                          sizeof(m_queue[0].data) : scan->data_len;
+  const uint32_t timestamp_ms = (uint32_t) ruuvi_driver_sensor_timestamp_get();
+  // Drain may be interrupted, update queue atomically instead of under the lock.
+  ruuvi_interface_atomic_critical_enter();
+  m_stats.received++;
+  bridge_frame_t* const frame = queue_slot(scan);
+
+  if(NULL != frame)
+  {
+    memcpy(frame->addr, scan->addr, sizeof(frame->addr));
+    frame->seq = ++m_seq;
+    frame->rssi = scan->rssi;
+    frame->timestamp_ms = timestamp_ms;
+    frame->data_len = (uint8_t) copy_len;
+    memcpy(frame->data, scan->data, copy_len);
+  }
+
+  ruuvi_interface_atomic_critical_exit();
+  ruuvi_interface_communication_uart_bridge_process();
+  return (NULL == frame) ? RUUVI_DRIVER_ERROR_BUSY : RUUVI_DRIVER_SUCCESS;
+}
+
+size_t ruuvi_interface_communication_uart_bridge_process(void)
+{
+  size_t sent = 0;
+
+  if(NULL == m_send) { return 0; }
+
+  // Holder of lock drains on release if this call does not get the lock.
+  m_drain_pending = true;
+
+  if(ruuvi_interface_atomic_flag(&m_lock, true))
+  {
+    m_drain_pending = false;
+    sent = queue_drain();
+    sent += lock_release();
+  }
+
+  return sent;
+}
+
+void ruuvi_interface_communication_uart_bridge_on_tx(const size_t free)
+{
+  ruuvi_interface_communication_uart_bridge_process();
+}
+
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_stats_get(
+  ruuvi_interface_communication_uart_bridge_stats_t* const stats)
+{
+  if(NULL == stats) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  memcpy(stats, &m_stats, sizeof(m_stats));
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+/*@}*/
+#endif
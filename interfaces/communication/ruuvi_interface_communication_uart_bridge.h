@@ -0,0 +1,179 @@
+#ifndef RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_H
+#define RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_H
+#include "ruuvi_driver_error.h"
+#include "ruuvi_interface_communication.h"
+#include "ruuvi_interface_communication_ble4_advertising.h"
+#include <stddef.h>
+#include <stdint.h>
+/**
+ * @defgroup UART_bridge UART bridge
+ * @brief Stream scanned advertisements to a host over UART.
+ *
+ */
+/*@{*/
+/**
+ * @file ruuvi_interface_communication_uart_bridge.h
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-13
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ * @brief Framed stream of scanned advertisements.
+ *
+ * Scan reports are queued and written to a byte sink as COBS-encoded frames,
+ * each frame terminated by 0x00. Decoded frame is:
+ * | Offset | Length | Content                                     |
+ * |--------|--------|---------------------------------------------|
+ * | 0      | 6      | MAC address, MSB first                      |
+ * | 6      | 1      | RSSI, int8                                  |
+ * | 7      | 4      | Timestamp ms, uint32 little endian          |
+ * | 11     | 0-31   | Advertisement payload                       |
+ *
+ * If the sink cannot keep up, frames are dropped from queue by policy.
+ * Sink is typically @ref ruuvi_interface_uart_send, queue is drained on each
+ * new report and on each transmit callback.
+ *
+ * @code{.c}
+ *  ruuvi_interface_communication_uart_bridge_init(
+ *    RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_LATEST_PER_ADDRESS, ruuvi_interface_uart_send);
+ *  ruuvi_interface_uart_tx_cb_set(ruuvi_interface_communication_uart_bridge_on_tx);
+ *  // In scan event handler:
+ *  ruuvi_interface_communication_uart_bridge_on_evt(evt, p_data, data_len);
+ * @endcode
+ */
+
+/** @brief Number of frames waiting for sink. */
+#ifndef RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE
+  #define RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE 16
+#endif
+
+/** @brief Length of frame before payload. */
+#define RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_HEADER_LEN 11
+/** @brief Maximum length of decoded frame. */
+#define RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_FRAME_MAX_LEN \
+  (RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_HEADER_LEN + 31)
+/** @brief Maximum length of frame on wire, COBS overhead byte and delimiter included. */
+#define RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_WIRE_MAX_LEN \
+  (RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_FRAME_MAX_LEN + 2)
+
+/** @brief What to drop when queue is full. */
+typedef enum
+{
+  RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_NEWEST,       //!< Discard new report.
+  RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_OLDEST,       //!< Discard oldest queued frame.
+  RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_LATEST_PER_ADDRESS //!< Replace queued frame of same address, otherwise drop oldest.
+} ruuvi_interface_communication_uart_bridge_policy_t;
+
+/**
+ * @brief Function to write bytes to link.
+ *
+ * @param[in] data Bytes to write.
+ * @param[in] len Number of bytes.
+ * @return RUUVI_DRIVER_SUCCESS if all bytes were accepted.
+ * @return error code if none of the bytes were accepted, i.e. RUUVI_DRIVER_ERROR_NO_MEM.
+ */
+typedef ruuvi_driver_status_t (*ruuvi_interface_communication_uart_bridge_send_fp_t)(
+  const uint8_t* const data, const size_t len);
+
+/** @brief Counters of bridge. */
+typedef struct
+{
+  uint32_t received; //!< Reports given to bridge.
+  uint32_t sent;     //!< Frames written to sink.
+  uint32_t replaced; //!< Queued frames replaced by newer frame of same address.
+  uint32_t dropped;  //!< Frames discarded by policy on full queue.
+} ruuvi_interface_communication_uart_bridge_stats_t;
+
+/**
+ * @brief Initialize bridge.
+ *
+ * @param[in] policy Drop policy.
+ * @param[in] send Sink of encoded frames.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if send is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if policy is unknown.
+ */
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_init(
+  const ruuvi_interface_communication_uart_bridge_policy_t policy,
+  const ruuvi_interface_communication_uart_bridge_send_fp_t send);
+
+/**
+ * @brief Uninitialize bridge. Queued frames are discarded.
+ *
+ * @return RUUVI_DRIVER_SUCCESS.
+ */
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_uninit(void);
+
+/**
+ * @brief Handle communication event, see @ref ruuvi_interface_communication_evt_handler_fp_t.
+ *
+ * @ref RUUVI_INTERFACE_COMMUNICATION_RECEIVED with a
+ * @ref ruuvi_interface_communication_ble4_scan_t is queued and queue is drained to sink.
+ * Other events are ignored. Safe to call from interrupt context, report is queued
+ * in a short critical region also while an interrupted context drains the queue.
+ *
+ * @return RUUVI_DRIVER_SUCCESS if event was handled or ignored.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if bridge is not initialized.
+ * @return RUUVI_DRIVER_ERROR_NULL if data of report is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_LENGTH if data of report is not a scan report.
+ * @return RUUVI_DRIVER_ERROR_BUSY if queue is full and report was dropped by
+ *         @ref RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_NEWEST policy.
+ */
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_on_evt(
+  const ruuvi_interface_communication_evt_t evt, void* p_data, size_t data_len);
+
+/**
+ * @brief Write queued frames to sink until sink is full or queue is empty.
+ *
+ * If queue is locked by interrupted caller, frames are written by that caller
+ * when it releases the lock.
+ *
+ * @return Number of frames written by this call.
+ */
+size_t ruuvi_interface_communication_uart_bridge_process(void);
+
+/**
+ * @brief Transmit callback, see @ref ruuvi_interface_uart_tx_cb_t. Drains queue.
+ *
+ * @param[in] free Free space in sink, unused.
+ */
+void ruuvi_interface_communication_uart_bridge_on_tx(const size_t free);
+
+/**
+ * @brief Get counters of bridge.
+ *
+ * @param[out] stats Counters.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if stats is NULL.
+ */
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_stats_get(
+  ruuvi_interface_communication_uart_bridge_stats_t* const stats);
+
+/**
+ * @brief Encode data with Consistent Overhead Byte Stuffing.
+ *
+ * Output contains no 0x00 bytes, delimiter is not added.
+ * Output is at most len + len / 254 + 1 bytes.
+ *
+ * @param[in] input Data to encode.
+ * @param[in] len Length of data.
+ * @param[out] output Encoded data.
+ * @param[in] output_size Size of output buffer.
+ * @return Length of encoded data, 0 if output does not fit or a pointer is NULL.
+ */
+size_t ruuvi_interface_communication_cobs_encode(const uint8_t* const input,
+    const size_t len, uint8_t* const output, const size_t output_size);
+
+/**
+ * @brief Decode data encoded with @ref ruuvi_interface_communication_cobs_encode.
+ *
+ * @param[in] input Encoded data without delimiter.
+ * @param[in] len Length of encoded data.
+ * @param[out] output Decoded data.
+ * @param[in] output_size Size of output buffer.
+ * @return Length of decoded data, 0 if input is invalid, output does not fit or
+ *         a pointer is NULL.
+ */
+size_t ruuvi_interface_communication_cobs_decode(const uint8_t* const input,
+    const size_t len, uint8_t* const output, const size_t output_size);
+
+/*@}*/
+#endif
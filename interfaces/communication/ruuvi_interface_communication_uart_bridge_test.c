@@ -0,0 +1,295 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_RUN_TESTS && RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_ENABLED
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_sensor.h"
+#include "ruuvi_driver_test.h"
+#include "ruuvi_interface_communication_uart_bridge.h"
+#include "ruuvi_interface_communication_uart_bridge_test.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/** @brief Bytes received by loopback sink since last delimiter. */
+static uint8_t m_rx[RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_WIRE_MAX_LEN];
+static size_t m_rx_len;
+/** @brief Latest decoded frame. */
+static uint8_t m_frame[RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_FRAME_MAX_LEN];
+static size_t m_frame_len;
+static uint32_t m_frames;  //!< Number of frames decoded.
+static uint32_t m_errors;  //!< Number of frames which could not be decoded.
+static bool m_sink_full;   //!< True to reject writes.
+static bool m_sink_contend; //!< True to reject next write and call transmit callback.
+static bool m_sink_report;  //!< True to give a scan report to bridge on next write.
+
+static ruuvi_driver_status_t scan_put(const uint8_t id, const uint8_t fill);
+
+/** @brief Loopback sink, decodes frames like a host would. */
+static ruuvi_driver_status_t sink_send(const uint8_t* const data, const size_t len)
+{
+  if(m_sink_full) { return RUUVI_DRIVER_ERROR_NO_MEM; }
+
+  // Transmit completes while bridge holds the lock, like UART interrupt would.
+  if(m_sink_contend)
+  {
+    m_sink_contend = false;
+    ruuvi_interface_communication_uart_bridge_on_tx(0);
+    return RUUVI_DRIVER_ERROR_NO_MEM;
+  }
+
+  // Scan report arrives while bridge drains, like scan interrupt would.
+  if(m_sink_report)
+  {
+    m_sink_report = false;
+    (void) scan_put(5, 0x05);
+  }
+
+  for(size_t ii = 0; ii < len; ii++)
+  {
+    if(0 != data[ii])
+    {
+      if(m_rx_len < sizeof(m_rx)) { m_rx[m_rx_len] = data[ii]; }
+
+      m_rx_len++;
+      continue;
+    }
+
+    m_frame_len = 0;
+
+    if(m_rx_len <= sizeof(m_rx))
+    {
+      m_frame_len = ruuvi_interface_communication_cobs_decode(m_rx, m_rx_len, m_frame,
+                    sizeof(m_frame));
+    }
+
+    if(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_HEADER_LEN > m_frame_len) { m_errors++; }
+    else { m_frames++; }
+
+    m_rx_len = 0;
+  }
+
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+static void sink_reset(void)
+{
+  m_rx_len = 0;
+  m_frame_len = 0;
+  m_frames = 0;
+  m_errors = 0;
+  m_sink_full = false;
+  m_sink_contend = false;
+  m_sink_report = false;
+}
+
+/** @brief Scan report with address ending in id and payload filled with fill. */
+static void scan_fill(ruuvi_interface_communication_ble4_scan_t* const scan,
+                      const uint8_t id, const uint8_t fill)
+{
+  memset(scan, 0, sizeof(*scan));
+  scan->addr[0] = 0xC0;
+  scan->addr[5] = id;
+  scan->rssi = -70;
+  scan->data_len = sizeof(scan->data);
+  memset(scan->data, fill, sizeof(scan->data));
+  scan->data[0] = 0x00;
+}
+
+static ruuvi_driver_status_t scan_put(const uint8_t id, const uint8_t fill)
+{
+  ruuvi_interface_communication_ble4_scan_t scan;
+  scan_fill(&scan, id, fill);
+  return ruuvi_interface_communication_uart_bridge_on_evt(
+           RUUVI_INTERFACE_COMMUNICATION_RECEIVED, &scan, sizeof(scan));
+}
+
+/** @brief Check that latest decoded frame matches report. */
+static bool frame_matches(const uint8_t id, const uint8_t fill)
+{
+  ruuvi_interface_communication_ble4_scan_t scan;
+  scan_fill(&scan, id, fill);
+  const uint8_t* const payload = m_frame +
+                                 RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_HEADER_LEN;
+  return (RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_FRAME_MAX_LEN == m_frame_len)
+         && !memcmp(m_frame, scan.addr, sizeof(scan.addr))
+         && ((uint8_t) scan.rssi == m_frame[6])
+         && !memcmp(payload, scan.data, scan.data_len);
+}
+
+/** @brief Fill queue with blocked sink, then release first frame. */
+static bool queue_overflow_check(const ruuvi_interface_communication_uart_bridge_policy_t
+                                 policy, const uint8_t first_id)
+{
+  ruuvi_interface_communication_uart_bridge_stats_t stats;
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  sink_reset();
+  err_code |= ruuvi_interface_communication_uart_bridge_init(policy, sink_send);
+  m_sink_full = true;
+
+  for(uint8_t ii = 0; ii < RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE; ii++)
+  {
+    err_code |= scan_put(ii, 0x10 + ii);
+  }
+
+  // Only dropping new report is reported to caller.
+  const ruuvi_driver_status_t overflow_status = scan_put(
+        RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE,
+        0x10 + RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE);
+  err_code |= (RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_NEWEST == policy) ?
+              (overflow_status ^ RUUVI_DRIVER_ERROR_BUSY) : overflow_status;
+  m_sink_full = false;
+  const size_t sent = ruuvi_interface_communication_uart_bridge_process();
+  err_code |= ruuvi_interface_communication_uart_bridge_stats_get(&stats);
+  // Decoder keeps the last frame, its id tells which end of the queue was dropped.
+  bool pass = (RUUVI_DRIVER_SUCCESS == err_code)
+              && (RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE == sent)
+              && (1 == stats.dropped) && (0 == m_errors);
+  const uint8_t last_id = first_id + RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_QUEUE_SIZE - 1;
+  pass = pass && frame_matches(last_id, 0x10 + last_id);
+  ruuvi_interface_communication_uart_bridge_uninit();
+  return pass;
+}
+
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_test(void)
+{
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  ruuvi_interface_communication_uart_bridge_stats_t stats;
+  bool fail = false;
+  bool pass;
+  // - Init must return RUUVI_DRIVER_ERROR_NULL if sink is NULL.
+  err_code = ruuvi_interface_communication_uart_bridge_init(
+               RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_OLDEST, NULL);
+  pass = (RUUVI_DRIVER_ERROR_NULL == err_code);
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Init must return RUUVI_DRIVER_ERROR_INVALID_PARAM with unknown policy.
+  err_code = ruuvi_interface_communication_uart_bridge_init(
+               (ruuvi_interface_communication_uart_bridge_policy_t) 0x7F, sink_send);
+  pass = (RUUVI_DRIVER_ERROR_INVALID_PARAM == err_code);
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - COBS decode must return the encoded data, including zeros and runs over 254 bytes.
+  static uint8_t raw[300];
+  static uint8_t encoded[sizeof(raw) + 3];
+  static uint8_t decoded[sizeof(raw)];
+
+  for(size_t ii = 0; ii < sizeof(raw); ii++)
+  {
+    raw[ii] = (ii < 10 || ii > 270) ? (uint8_t)(ii % 3) : (uint8_t)(ii | 0x01);
+  }
+
+  const size_t encoded_len = ruuvi_interface_communication_cobs_encode(raw, sizeof(raw),
+                             encoded, sizeof(encoded));
+  pass = (0 != encoded_len) && (NULL == memchr(encoded, 0, encoded_len))
+         && (sizeof(raw) == ruuvi_interface_communication_cobs_decode(encoded, encoded_len,
+             decoded, sizeof(decoded)))
+         && !memcmp(raw, decoded, sizeof(raw))
+         && (0 == ruuvi_interface_communication_cobs_encode(raw, sizeof(raw), encoded,
+             sizeof(raw)));
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Frame must be decoded with the address, RSSI and payload of report.
+  sink_reset();
+  err_code = ruuvi_interface_communication_uart_bridge_init(
+               RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_OLDEST, sink_send);
+  err_code |= scan_put(1, 0xAB);
+  pass = (RUUVI_DRIVER_SUCCESS == err_code) && (1 == m_frames) && (0 == m_errors)
+         && frame_matches(1, 0xAB);
+  ruuvi_interface_communication_uart_bridge_uninit();
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Drop newest must keep the oldest frames on full queue.
+  pass = queue_overflow_check(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_NEWEST, 0);
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Drop oldest must keep the newest frames on full queue.
+  pass = queue_overflow_check(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_OLDEST, 1);
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Latest per address must replace queued frame of the same address.
+  sink_reset();
+  err_code = ruuvi_interface_communication_uart_bridge_init(
+               RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_LATEST_PER_ADDRESS, sink_send);
+  m_sink_full = true;
+  err_code |= scan_put(2, 0x01);
+  err_code |= scan_put(2, 0x02);
+  m_sink_full = false;
+  pass = (1 == ruuvi_interface_communication_uart_bridge_process());
+  err_code |= ruuvi_interface_communication_uart_bridge_stats_get(&stats);
+  pass = pass && (RUUVI_DRIVER_SUCCESS == err_code) && (1 == stats.replaced)
+         && (0 == stats.dropped) && (2 == stats.received) && frame_matches(2, 0x02);
+  ruuvi_interface_communication_uart_bridge_uninit();
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Transmit callback on locked queue must have frames drained by holder of lock.
+  sink_reset();
+  err_code = ruuvi_interface_communication_uart_bridge_init(
+               RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_OLDEST, sink_send);
+  m_sink_full = true;
+  err_code |= scan_put(3, 0x03);
+  err_code |= scan_put(4, 0x04);
+  m_sink_full = false;
+  m_sink_contend = true;
+  pass = (2 == ruuvi_interface_communication_uart_bridge_process());
+  err_code |= ruuvi_interface_communication_uart_bridge_stats_get(&stats);
+  pass = pass && (RUUVI_DRIVER_SUCCESS == err_code) && (2 == m_frames)
+         && (2 == stats.sent) && (0 == m_errors) && frame_matches(4, 0x04);
+  ruuvi_interface_communication_uart_bridge_uninit();
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  // - Report on locked queue must be queued and drained by holder of lock.
+  sink_reset();
+  err_code = ruuvi_interface_communication_uart_bridge_init(
+               RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_DROP_OLDEST, sink_send);
+  m_sink_report = true;
+  err_code |= scan_put(3, 0x03);
+  err_code |= ruuvi_interface_communication_uart_bridge_stats_get(&stats);
+  pass = (RUUVI_DRIVER_SUCCESS == err_code) && (2 == m_frames) && (2 == stats.received)
+         && (2 == stats.sent) && (0 == stats.dropped) && (0 == m_errors)
+         && frame_matches(5, 0x05);
+  ruuvi_interface_communication_uart_bridge_uninit();
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  return fail ? RUUVI_DRIVER_ERROR_SELFTEST : RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_test_benchmark(
+  const ruuvi_driver_test_print_fp printfp)
+{
+  const uint64_t start = ruuvi_driver_sensor_timestamp_get();
+
+  if(RUUVI_DRIVER_UINT64_INVALID == start) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  char msg[128];
+  sink_reset();
+  err_code |= ruuvi_interface_communication_uart_bridge_init(
+                RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_LATEST_PER_ADDRESS, sink_send);
+
+  for(uint32_t ii = 0; ii < RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_TEST_BENCHMARK_FRAMES;
+      ii++)
+  {
+    err_code |= scan_put((uint8_t) ii, (uint8_t) ii);
+  }
+
+  uint64_t elapsed_ms = ruuvi_driver_sensor_timestamp_get() - start;
+  ruuvi_interface_communication_uart_bridge_uninit();
+
+  if(0 == elapsed_ms) { elapsed_ms = 1; }
+
+  const uint64_t fps = ((uint64_t) m_frames * 1000) / elapsed_ms;
+  snprintf(msg, sizeof(msg), "UART bridge: %lu frames / s, %lu lost.\r\n",
+           (unsigned long) fps,
+           (unsigned long)(RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_TEST_BENCHMARK_FRAMES
+                           - m_frames));
+  printfp(msg);
+
+  if(RUUVI_DRIVER_SUCCESS != err_code || 0 != m_errors
+      || RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_TEST_BENCHMARK_FRAMES != m_frames)
+  {
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+#endif
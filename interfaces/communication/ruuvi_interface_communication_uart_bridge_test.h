@@ -0,0 +1,57 @@
+#ifndef RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_TEST_H
+#define RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_TEST_H
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_test.h"
+/**
+ * @addtogroup UART_bridge
+ * @{
+ */
+/**
+* @file ruuvi_interface_communication_uart_bridge_test.h
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-12-13
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Test @ref ruuvi_interface_communication_uart_bridge.h with a loopback sink which
+* decodes frames as a host would. Does not require UART hardware.
+*
+*/
+
+/** @brief Number of frames streamed in benchmark. */
+#define RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_TEST_BENCHMARK_FRAMES 10000
+
+/**
+ * @brief Test UART bridge and COBS encoding.
+ *
+ * - Init must return @c RUUVI_DRIVER_ERROR_NULL if sink is @c NULL.
+ * - Init must return @c RUUVI_DRIVER_ERROR_INVALID_PARAM with unknown policy.
+ * - COBS decode must return the encoded data, including zeros and runs over 254 bytes.
+ * - Frame must be decoded with the address, RSSI and payload of report.
+ * - Drop newest must keep the oldest frames on full queue.
+ * - Drop oldest must keep the newest frames on full queue.
+ * - Latest per address must replace queued frame of the same address.
+ * - Transmit callback on locked queue must have frames drained by holder of lock.
+ *
+ * Bridge is uninitialized after test.
+ *
+ * @return @c RUUVI_DRIVER_SUCCESS if all tests pass, error code on failure
+ */
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_test(void);
+
+/**
+ * @brief Benchmark bridge throughput.
+ *
+ * Streams @ref RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_TEST_BENCHMARK_FRAMES
+ * full-length reports through the loopback sink, decoding every frame, and prints
+ * frames per second. Requires sensor timestamp function to be set up.
+ *
+ * @param[in] printfp Function to print results with.
+ * @return @c RUUVI_DRIVER_SUCCESS if benchmark was run and all frames were decoded.
+ * @return @c RUUVI_DRIVER_ERROR_INVALID_STATE if timestamp function is not set up.
+ * @return @c RUUVI_DRIVER_ERROR_SELFTEST if frames were lost or corrupted.
+ */
+ruuvi_driver_status_t ruuvi_interface_communication_uart_bridge_test_benchmark(
+  const ruuvi_driver_test_print_fp printfp);
+
+/*@}*/
+#endif
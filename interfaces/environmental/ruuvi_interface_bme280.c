@@ -18,9 +18,6 @@
 #include "bme280.h"
 #include "bme280_defs.h"
 #include "bme280_selftest.h"
-#if !(BME280_FLOAT_ENABLE || DOXYGEN)
-  #error "Please #define BME280_FLOAT_ENABLE in makefile CFLAGS"
-#endif
 
 /**
  * @addtogroup BME280
@@ -34,7 +31,9 @@
  *
  * Requires Bosch BME280_driver, available under BSD-3 on GitHub.
  * Will only get compiled if RUUVI_INTERFACE_ENVIRONMENTAL_BME280_ENABLED is defined as true
- * Requires BME280_FLOAT_ENABLE defined in makefile or otherwise passed to preprocessor
+ *
+ * Data is read in a single burst and compensated with the integer formulas of
+ * BME280 datasheet section 4.2.3, Bosch API is used for configuration only.
  *
  */
 
@@ -55,8 +54,76 @@
           } while(0)
 
 
+/** @brief Length of pressure, temperature and humidity data registers 0xF7 ... 0xFE */
+#define BME280_BURST_LEN (8U)
+/** @brief Offset of temperature data in burst. */
+#define BME280_BURST_T_OFFSET (3U)
+/** @brief Offset of humidity data in burst. */
+#define BME280_BURST_H_OFFSET (6U)
+/** @brief Status register. */
+#define BME280_STATUS_ADDR (0xF3U)
+/** @brief Status bit set while conversion is running. */
+#define BME280_STATUS_MEASURING (1U << 3)
+
+/**
+ * @brief Calibration constants of BME280, with shifts of datasheet formulas precomputed.
+ */
+typedef struct
+{
+  int64_t p4_s35; //!< dig_P4 << 35
+  int32_t t1;     //!< dig_T1
+  int32_t t1_s1;  //!< dig_T1 << 1
+  int32_t t2;     //!< dig_T2
+  int32_t t3;     //!< dig_T3
+  int32_t p1;     //!< dig_P1
+  int32_t p2;     //!< dig_P2
+  int32_t p3;     //!< dig_P3
+  int32_t p5;     //!< dig_P5
+  int32_t p6;     //!< dig_P6
+  int32_t p7_s4;  //!< dig_P7 << 4
+  int32_t p8;     //!< dig_P8
+  int32_t p9;     //!< dig_P9
+  int32_t h4_s20; //!< dig_H4 << 20
+  int32_t h1;     //!< dig_H1
+  int32_t h2;     //!< dig_H2
+  int32_t h3;     //!< dig_H3
+  int32_t h5;     //!< dig_H5
+  int32_t h6;     //!< dig_H6
+} bme280_calib_t;
+
+/** @brief Standby time setting and its duration in microseconds. */
+typedef struct
+{
+  uint8_t setting;     //!< BME280_STANDBY_TIME_ setting.
+  uint32_t standby_us; //!< Duration of standby, microseconds.
+} bme280_standby_t;
+
+/** @brief Standby times from longest to shortest. */
+static const bme280_standby_t m_standby[] =
+{
+  { BME280_STANDBY_TIME_1000_MS, 1000000 },
+  { BME280_STANDBY_TIME_500_MS,  500000 },
+  { BME280_STANDBY_TIME_250_MS,  250000 },
+  { BME280_STANDBY_TIME_125_MS,  125000 },
+  { BME280_STANDBY_TIME_62_5_MS, 62500 },
+  { BME280_STANDBY_TIME_20_MS,   20000 },
+  { BME280_STANDBY_TIME_10_MS,   10000 },
+  { BME280_STANDBY_TIME_0_5_MS,  500 }
+};
+
+/** @brief Sample interval requested by application, microseconds. */
+#define BME280_INTERVAL_DEFAULT_US (1000000U)
+/** @brief Interval which selects longest standby. */
+#define BME280_INTERVAL_MIN_RATE_US (UINT32_MAX)
+/** @brief Interval which selects shortest standby. */
+#define BME280_INTERVAL_MAX_RATE_US (0U)
+
 /** State variables **/
 static struct bme280_dev dev = {0};
+static bme280_calib_t m_calib;
+static uint32_t m_interval_us = BME280_INTERVAL_DEFAULT_US; //!< Requested sample interval.
+static ruuvi_interface_bme280_schedule_t m_schedule; //!< Sample schedule in normal mode.
+static ruuvi_driver_sensor_data_fields_t m_channels; //!< Channels converted by sensor.
 static uint64_t tsample;
 static const char m_sensor_name[] = "BME280";
 
@@ -80,15 +147,226 @@ void bosch_delay_ms(uint32_t time_ms)
   ruuvi_interface_delay_ms(time_ms);
 }
 
-// BME280 datasheet Appendix B.
-static uint32_t bme280_max_meas_time(uint8_t oversampling)
+/**
+ * @brief Cache calibration constants read by bme280_init.
+ */
+static void bme280_calib_cache(void)
+{
+  const struct bme280_calib_data* const c = &(dev.calib_data);
+  m_calib.t1     = c->dig_T1;
+  m_calib.t1_s1  = ((int32_t)c->dig_T1) << 1;
+  m_calib.t2     = c->dig_T2;
+  m_calib.t3     = c->dig_T3;
+  m_calib.p1     = c->dig_P1;
+  m_calib.p2     = c->dig_P2;
+  m_calib.p3     = c->dig_P3;
+  m_calib.p4_s35 = ((int64_t)c->dig_P4) << 35;
+  m_calib.p5     = c->dig_P5;
+  m_calib.p6     = c->dig_P6;
+  m_calib.p7_s4  = ((int32_t)c->dig_P7) << 4;
+  m_calib.p8     = c->dig_P8;
+  m_calib.p9     = c->dig_P9;
+  m_calib.h1     = c->dig_H1;
+  m_calib.h2     = c->dig_H2;
+  m_calib.h3     = c->dig_H3;
+  m_calib.h4_s20 = ((int32_t)c->dig_H4) << 20;
+  m_calib.h5     = c->dig_H5;
+  m_calib.h6     = c->dig_H6;
+}
+
+/**
+ * @brief Compensate temperature, BME280 datasheet 4.2.3.
+ *
+ * @param[in] adc_t Raw temperature.
+ * @param[out] t_fine Fine temperature for pressure and humidity compensation.
+ * @return Temperature in 0.01 DegC.
+ */
+static int32_t bme280_compensate_t(const int32_t adc_t, int32_t* const t_fine)
+{
+  const int32_t var1 = (((adc_t >> 3) - m_calib.t1_s1) * m_calib.t2) >> 11;
+  const int32_t var2 = (((((adc_t >> 4) - m_calib.t1) * ((adc_t >> 4) - m_calib.t1)) >> 12)
+                        * m_calib.t3) >> 14;
+  *t_fine = var1 + var2;
+  return (*t_fine * 5 + 128) >> 8;
+}
+
+/**
+ * @brief Compensate pressure, BME280 datasheet 4.2.3.
+ *
+ * @param[in] adc_p Raw pressure.
+ * @param[in] t_fine Fine temperature.
+ * @return Pressure in Pa as Q24.8, 0 on invalid calibration.
+ */
+static uint32_t bme280_compensate_p(const int32_t adc_p, const int32_t t_fine)
+{
+  int64_t var1 = ((int64_t)t_fine) - 128000;
+  int64_t var2 = var1 * var1 * m_calib.p6;
+  var2 = var2 + ((var1 * m_calib.p5) << 17);
+  var2 = var2 + m_calib.p4_s35;
+  var1 = ((var1 * var1 * m_calib.p3) >> 8) + ((var1 * m_calib.p2) << 12);
+  var1 = (((((int64_t)1) << 47) + var1) * m_calib.p1) >> 33;
+
+  // Avoid division by zero
+  if(0 == var1) { return 0; }
+
+  int64_t p = 1048576 - adc_p;
+  p = (((p << 31) - var2) * 3125) / var1;
+  var1 = (((int64_t)m_calib.p9) * (p >> 13) * (p >> 13)) >> 25;
+  var2 = (((int64_t)m_calib.p8) * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + m_calib.p7_s4;
+  return (uint32_t)p;
+}
+
+/**
+ * @brief Compensate humidity, BME280 datasheet 4.2.3.
+ *
+ * @param[in] adc_h Raw humidity.
+ * @param[in] t_fine Fine temperature.
+ * @return Humidity in %RH as Q22.10.
+ */
+static uint32_t bme280_compensate_h(const int32_t adc_h, const int32_t t_fine)
 {
-  // Time
-  float time = 1.25f + \
-               2.3 * 3 * oversampling + \
-               2 * 0.575;
-  // Roundoff + margin
-  return (uint32_t)(2 + (uint32_t) time);
+  int32_t v = t_fine - 76800;
+  v = (((((adc_h << 14) - m_calib.h4_s20 - (m_calib.h5 * v)) + 16384) >> 15)
+       * (((((((v * m_calib.h6) >> 10) * (((v * m_calib.h3) >> 11) + 32768)) >> 10)
+            + 2097152) * m_calib.h2 + 8192) >> 14));
+  v = v - (((((v >> 15) * (v >> 15)) >> 7) * m_calib.h1) >> 4);
+  v = (v < 0) ? 0 : v;
+  v = (v > 419430400) ? 419430400 : v;
+  return (uint32_t)(v >> 12);
+}
+
+/**
+ * @brief Number of oversamples of Bosch oversampling setting, 0 if channel is skipped.
+ */
+static uint32_t bme280_os_count(const uint8_t osr)
+{
+  return (BME280_NO_OVERSAMPLING == osr) ? 0 : (1U << (osr - 1));
+}
+
+/**
+ * @brief Measurement time of current oversampling settings, BME280 datasheet Appendix B.
+ *
+ * Typical: 1 + 2 * T_os + (2 * P_os + 0.5) + (2 * H_os + 0.5) ms.
+ * Maximum: 1.25 + 2.3 * T_os + (2.3 * P_os + 0.575) + (2.3 * H_os + 0.575) ms.
+ * Pressure and humidity terms are left out if the channel is skipped.
+ *
+ * @param[in] maximum True to calculate maximum time, false to calculate typical time.
+ * @return measurement time in microseconds.
+ */
+static uint32_t bme280_meas_time_us(const bool maximum)
+{
+  const uint32_t per_os = maximum ? 2300 : 2000;
+  const uint32_t setup  = maximum ? 575 : 500;
+  const uint32_t os_t = bme280_os_count(dev.settings.osr_t);
+  const uint32_t os_p = bme280_os_count(dev.settings.osr_p);
+  const uint32_t os_h = bme280_os_count(dev.settings.osr_h);
+  uint32_t time_us = (maximum ? 1250 : 1000) + per_os * os_t;
+
+  if(os_p) { time_us += per_os * os_p + setup; }
+
+  if(os_h) { time_us += per_os * os_h + setup; }
+
+  return time_us;
+}
+
+/**
+ * @brief Duration of standby setting in microseconds.
+ */
+static uint32_t bme280_standby_us(const uint8_t setting)
+{
+  for(size_t ii = 0; ii < sizeof(m_standby) / sizeof(m_standby[0]); ii++)
+  {
+    if(setting == m_standby[ii].setting) { return m_standby[ii].standby_us; }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Select longest standby which fits the requested interval.
+ *
+ * Period of normal mode is maximum measurement time + standby time.
+ * If interval cannot be met with shortest standby and reduce_os is true,
+ * oversampling of all channels is reduced until interval can be met.
+ * Settings are stored in dev, but not written to sensor.
+ *
+ * @param[in] interval_us Requested sample interval.
+ * @param[in] reduce_os True to reduce oversampling if interval cannot be met.
+ * @return @c RUUVI_DRIVER_SUCCESS if interval can be met.
+ * @return @c RUUVI_DRIVER_ERROR_NOT_SUPPORTED if interval is too short, shortest standby
+ *         is selected.
+ */
+static ruuvi_driver_status_t bme280_standby_select(const uint32_t interval_us,
+    const bool reduce_os)
+{
+  const size_t count = sizeof(m_standby) / sizeof(m_standby[0]);
+
+  while(true)
+  {
+    const uint32_t meas_us = bme280_meas_time_us(true);
+
+    for(size_t ii = 0; ii < count; ii++)
+    {
+      if((interval_us >= meas_us) && (interval_us - meas_us >= m_standby[ii].standby_us))
+      {
+        dev.settings.standby_time = m_standby[ii].setting;
+        return RUUVI_DRIVER_SUCCESS;
+      }
+    }
+
+    dev.settings.standby_time = m_standby[count - 1].setting;
+
+    // Fastest rate requested, use whatever measurement time oversampling needs.
+    if(BME280_INTERVAL_MAX_RATE_US == interval_us) { return RUUVI_DRIVER_SUCCESS; }
+
+    if(!reduce_os
+        || (BME280_OVERSAMPLING_1X >= dev.settings.osr_t
+            && BME280_OVERSAMPLING_1X >= dev.settings.osr_p
+            && BME280_OVERSAMPLING_1X >= dev.settings.osr_h))
+    {
+      return RUUVI_DRIVER_ERROR_NOT_SUPPORTED;
+    }
+
+    if(BME280_OVERSAMPLING_1X < dev.settings.osr_t) { dev.settings.osr_t--; }
+
+    if(BME280_OVERSAMPLING_1X < dev.settings.osr_p) { dev.settings.osr_p--; }
+
+    if(BME280_OVERSAMPLING_1X < dev.settings.osr_h) { dev.settings.osr_h--; }
+  }
+}
+
+/**
+ * @brief Apply enabled channels to oversampling settings.
+ *
+ * Skipped channels get oversampling 0, enabled channels which were skipped
+ * get oversampling of temperature. Settings are stored in dev, but not written to sensor.
+ */
+static void bme280_channels_apply(void)
+{
+  // Temperature is always needed for compensation.
+  if(BME280_NO_OVERSAMPLING == dev.settings.osr_t)
+  {
+    dev.settings.osr_t = BME280_OVERSAMPLING_1X;
+  }
+
+  if(!m_channels.datas.pressure_pa)
+  {
+    dev.settings.osr_p = BME280_NO_OVERSAMPLING;
+  }
+  else if(BME280_NO_OVERSAMPLING == dev.settings.osr_p)
+  {
+    dev.settings.osr_p = dev.settings.osr_t;
+  }
+
+  if(!m_channels.datas.humidity_rh)
+  {
+    dev.settings.osr_h = BME280_NO_OVERSAMPLING;
+  }
+  else if(BME280_NO_OVERSAMPLING == dev.settings.osr_h)
+  {
+    dev.settings.osr_h = dev.settings.osr_t;
+  }
 }
 
 /** Initialize BME280 into low-power mode **/
@@ -142,6 +420,12 @@ ruuvi_driver_status_t ruuvi_interface_bme280_init(ruuvi_driver_sensor_t*
 
   err_code |= BME_TO_RUUVI_ERROR(bme280_crc_selftest(&dev));
   err_code |= BME_TO_RUUVI_ERROR(bme280_soft_reset(&dev));
+  // bme280_init has read calibration to dev, compute constants once.
+  bme280_calib_cache();
+  m_channels.bitfield = 0;
+  m_channels.datas.humidity_rh = 1;
+  m_channels.datas.pressure_pa = 1;
+  m_channels.datas.temperature_c = 1;
   // Setup Oversampling 1 to enable sensor
   uint8_t dsp = RUUVI_DRIVER_SENSOR_DSP_OS;
   uint8_t dsp_parameter = 1;
@@ -186,39 +470,59 @@ ruuvi_driver_status_t ruuvi_interface_bme280_uninit(ruuvi_driver_sensor_t* senso
   ruuvi_driver_sensor_uninitialize(sensor);
   memset(&dev, 0, sizeof(dev));
   tsample = RUUVI_DRIVER_UINT64_INVALID;
+  m_interval_us = BME280_INTERVAL_DEFAULT_US;
+  m_schedule.period_us = 0;
   return err_code;
 }
 
+/**
+ * Samplerate selects the longest standby time at which measurement + standby fits
+ * into 1 / samplerate. Oversampling is reduced if samplerate cannot be met otherwise.
+ */
 ruuvi_driver_status_t ruuvi_interface_bme280_samplerate_set(uint8_t* samplerate)
 {
   if(NULL == samplerate) { return RUUVI_DRIVER_ERROR_NULL; }
 
   VERIFY_SENSOR_SLEEPS();
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  uint32_t interval_us = m_interval_us;
 
-  if(RUUVI_DRIVER_SENSOR_CFG_DEFAULT == *samplerate)  { dev.settings.standby_time = BME280_STANDBY_TIME_1000_MS; }
-  else if(*samplerate == 1)                           { dev.settings.standby_time = BME280_STANDBY_TIME_1000_MS; }
-  else if(*samplerate == 2)                           { dev.settings.standby_time = BME280_STANDBY_TIME_500_MS; }
-  else if(*samplerate <= 8)                           { dev.settings.standby_time = BME280_STANDBY_TIME_125_MS; }
-  else if(*samplerate <= 16)                          { dev.settings.standby_time = BME280_STANDBY_TIME_62_5_MS; }
-  else if(*samplerate <= 50)                          { dev.settings.standby_time = BME280_STANDBY_TIME_20_MS; }
-  else if(*samplerate <= 100)                         { dev.settings.standby_time = BME280_STANDBY_TIME_10_MS; }
-  else if(*samplerate <= 200)                         { dev.settings.standby_time = BME280_STANDBY_TIME_0_5_MS; }
-  else if(RUUVI_DRIVER_SENSOR_CFG_MIN == *samplerate) { dev.settings.standby_time = BME280_STANDBY_TIME_1000_MS; }
-  else if(RUUVI_DRIVER_SENSOR_CFG_MAX == *samplerate) { dev.settings.standby_time = BME280_STANDBY_TIME_0_5_MS; }
+  if(RUUVI_DRIVER_SENSOR_CFG_DEFAULT == *samplerate)        { interval_us = BME280_INTERVAL_DEFAULT_US; }
+  else if(RUUVI_DRIVER_SENSOR_CFG_MIN == *samplerate)       { interval_us = BME280_INTERVAL_MIN_RATE_US; }
+  else if(RUUVI_DRIVER_SENSOR_CFG_MAX == *samplerate)       { interval_us = BME280_INTERVAL_MAX_RATE_US; }
   else if(RUUVI_DRIVER_SENSOR_CFG_NO_CHANGE == *samplerate) {} // do nothing
+  else if(*samplerate <= 200)                               { interval_us = 1000000U / *samplerate; }
   else { *samplerate = RUUVI_DRIVER_SENSOR_ERR_NOT_SUPPORTED; err_code |= RUUVI_DRIVER_ERROR_NOT_SUPPORTED; }
 
   if(RUUVI_DRIVER_SUCCESS == err_code)
   {
+    err_code |= bme280_standby_select(interval_us, true);
+  }
+
+  if(RUUVI_DRIVER_SUCCESS == err_code)
+  {
+    m_interval_us = interval_us;
     // BME 280 must be in standby while configured
-    err_code |=  BME_TO_RUUVI_ERROR(bme280_set_sensor_settings(BME280_STANDBY_SEL, &dev));
+    err_code |=  BME_TO_RUUVI_ERROR(bme280_set_sensor_settings(BME280_STANDBY_SEL
+                                    | BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL
+                                    | BME280_OSR_HUM_SEL, &dev));
     err_code |= ruuvi_interface_bme280_samplerate_get(samplerate);
   }
+  else
+  {
+    // Restore settings in sensor
+    bme280_get_sensor_settings(&dev);
+    *samplerate = RUUVI_DRIVER_SENSOR_ERR_NOT_SUPPORTED;
+  }
 
   return err_code;
 }
 
+/**
+ * Samplerate is reported as number of complete samples per second in normal mode,
+ * rounded down. Rates below 1 Hz are reported as RUUVI_DRIVER_SENSOR_CFG_MIN and rates
+ * above 200 Hz as RUUVI_DRIVER_SENSOR_CFG_MAX.
+ */
 ruuvi_driver_status_t ruuvi_interface_bme280_samplerate_get(uint8_t* samplerate)
 {
   if(NULL == samplerate) { return RUUVI_DRIVER_ERROR_NULL; }
@@ -227,13 +531,13 @@ ruuvi_driver_status_t ruuvi_interface_bme280_samplerate_get(uint8_t* samplerate)
 
   if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
 
-  if(BME280_STANDBY_TIME_1000_MS == dev.settings.standby_time)      { *samplerate = 1;   }
-  else if(BME280_STANDBY_TIME_500_MS == dev.settings.standby_time)  { *samplerate = 2;   }
-  else if(BME280_STANDBY_TIME_125_MS == dev.settings.standby_time)  { *samplerate = 8;   }
-  else if(BME280_STANDBY_TIME_62_5_MS == dev.settings.standby_time) { *samplerate = 16;  }
-  else if(BME280_STANDBY_TIME_20_MS == dev.settings.standby_time)   { *samplerate = 50;  }
-  else if(BME280_STANDBY_TIME_10_MS == dev.settings.standby_time)   { *samplerate = 100;  }
-  else if(BME280_STANDBY_TIME_0_5_MS == dev.settings.standby_time)    { *samplerate = 200; }
+  const uint32_t period_us = bme280_meas_time_us(true)
+                             + bme280_standby_us(dev.settings.standby_time);
+  const uint32_t rate = 1000000U / period_us;
+
+  if(1 > rate)        { *samplerate = RUUVI_DRIVER_SENSOR_CFG_MIN; }
+  else if(200 < rate) { *samplerate = RUUVI_DRIVER_SENSOR_CFG_MAX; }
+  else                { *samplerate = (uint8_t) rate; }
 
   return err_code;
 }
@@ -402,6 +706,12 @@ ruuvi_driver_status_t ruuvi_interface_bme280_dsp_set(uint8_t* dsp, uint8_t* para
     }
   }
 
+  // Keep skipped channels skipped.
+  bme280_channels_apply();
+  // Oversampling changes measurement time, fit standby to requested samplerate.
+  // Samplerate drops if oversampling does not fit in it.
+  bme280_standby_select(m_interval_us, false);
+  settings_sel |= BME280_STANDBY_SEL;
   //Write configuration
   return BME_TO_RUUVI_ERROR(bme280_set_sensor_settings(settings_sel, &dev));
 }
@@ -447,13 +757,13 @@ ruuvi_driver_status_t ruuvi_interface_bme280_dsp_get(uint8_t* dsp, uint8_t* para
 
   // Check if OS has been set. If yes, read DSP param from there.
   // Param should be same for OS and IIR if it is >1.
-  // OSR is same for every element.
-  if(BME280_NO_OVERSAMPLING != dev.settings.osr_h
-      && BME280_OVERSAMPLING_1X != dev.settings.osr_h)
+  // OSR is same for every enabled element, temperature is always enabled.
+  if(BME280_NO_OVERSAMPLING != dev.settings.osr_t
+      && BME280_OVERSAMPLING_1X != dev.settings.osr_t)
   {
     *dsp |= RUUVI_DRIVER_SENSOR_DSP_OS;
 
-    switch(dev.settings.osr_h)
+    switch(dev.settings.osr_t)
     {
       case BME280_OVERSAMPLING_2X:
         *parameter = 2;
@@ -500,18 +810,23 @@ ruuvi_driver_status_t ruuvi_interface_bme280_mode_set(uint8_t* mode)
       }
 
       err_code = BME_TO_RUUVI_ERROR(bme280_set_sensor_mode(BME280_FORCED_MODE, &dev));
-      // We assume that dev struct is in sync with the state of the BME280 and underlying interface
-      // which has the number of settings as 2^OSR is not changed.
-      // We also assume that each element runs same OSR
-      uint8_t samples = 1 << (dev.settings.osr_h - 1);
-      ruuvi_interface_delay_ms(bme280_max_meas_time(samples));
+      // We assume that dev struct is in sync with the state of the BME280.
+      ruuvi_interface_delay_ms((bme280_meas_time_us(true) + 999) / 1000);
       tsample = ruuvi_driver_sensor_timestamp_get();
       // BME280 returns to SLEEP after forced sample
       *mode = RUUVI_DRIVER_SENSOR_CFG_SLEEP;
       break;
 
     case RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS:
+      // Schedule of samples is known from here on, data_get can timestamp
+      // latest sample without waiting for the sensor. Sensor runs at typical
+      // timing, estimate is re-anchored when a conversion is seen running.
+      m_schedule.meas_us   = bme280_meas_time_us(false);
+      m_schedule.period_us = m_schedule.meas_us
+                             + bme280_standby_us(dev.settings.standby_time);
       err_code = BME_TO_RUUVI_ERROR(bme280_set_sensor_mode(BME280_NORMAL_MODE, &dev));
+      m_schedule.start_ms  = ruuvi_driver_sensor_timestamp_get();
+      m_schedule.latest_ms = RUUVI_DRIVER_UINT64_INVALID;
       break;
 
     default:
@@ -555,16 +870,73 @@ ruuvi_driver_status_t ruuvi_interface_bme280_mode_get(uint8_t* mode)
 }
 
 
+uint64_t ruuvi_interface_bme280_schedule_tsample(ruuvi_interface_bme280_schedule_t* const
+    schedule, const uint64_t now_ms, const bool measuring)
+{
+  if(NULL == schedule
+      || RUUVI_DRIVER_UINT64_INVALID == now_ms
+      || RUUVI_DRIVER_UINT64_INVALID == schedule->start_ms
+      || 0 == schedule->period_us)
+  {
+    return now_ms;
+  }
+
+  if(now_ms < schedule->start_ms) { return RUUVI_DRIVER_UINT64_INVALID; }
+
+  const uint64_t half_meas_ms = schedule->meas_us / 2000;
+  const uint64_t since_start_ms = now_ms - schedule->start_ms;
+
+  // Anchor on the cycle before the running one, if a sample has completed since start.
+  if(measuring && since_start_ms > half_meas_ms
+      && (since_start_ms - half_meas_ms) * 1000 >= schedule->period_us)
+  {
+    schedule->start_ms = now_ms - half_meas_ms - (schedule->period_us / 1000);
+  }
+
+  const uint64_t elapsed_us = (now_ms - schedule->start_ms) * 1000;
+
+  if(elapsed_us < schedule->meas_us) { return RUUVI_DRIVER_UINT64_INVALID; }
+
+  const uint64_t samples = (elapsed_us - schedule->meas_us) / schedule->period_us;
+  uint64_t latest = schedule->start_ms
+                    + (schedule->meas_us + samples * schedule->period_us) / 1000;
+
+  if(latest > now_ms) { latest = now_ms; }
+
+  // Anchor is exact to half of measurement time, re-anchoring can move estimate back.
+  if(RUUVI_DRIVER_UINT64_INVALID != schedule->latest_ms && latest < schedule->latest_ms)
+  {
+    latest = schedule->latest_ms;
+  }
+
+  schedule->latest_ms = latest;
+  return latest;
+}
+
 ruuvi_driver_status_t ruuvi_interface_bme280_data_get(ruuvi_driver_sensor_data_t* const
     p_data)
 {
   if(NULL == p_data) { return RUUVI_DRIVER_ERROR_NULL; }
 
-  struct bme280_data comp_data;
-
+  // Read only channels which are converted and requested. Temperature is always
+  // read for compensation, pressure precedes and humidity follows it.
+  ruuvi_driver_sensor_data_fields_t env_fields = {.bitfield = 0};
+  env_fields.datas.humidity_rh   = m_channels.datas.humidity_rh
+                                   & p_data->fields.datas.humidity_rh;
+  env_fields.datas.pressure_pa   = m_channels.datas.pressure_pa
+                                   & p_data->fields.datas.pressure_pa;
+  env_fields.datas.temperature_c = m_channels.datas.temperature_c
+                                   & p_data->fields.datas.temperature_c;
+
+  if(0 == env_fields.bitfield) { return RUUVI_DRIVER_SUCCESS; }
+
+  uint8_t raw[BME280_BURST_LEN] = {0};
+  const uint8_t first = env_fields.datas.pressure_pa ? 0 : BME280_BURST_T_OFFSET;
+  const uint8_t last  = env_fields.datas.humidity_rh ? BME280_BURST_LEN :
+                        BME280_BURST_H_OFFSET;
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
-
-  err_code = BME_TO_RUUVI_ERROR(bme280_get_sensor_data(BME280_ALL, &comp_data, &dev));
+  err_code = BME_TO_RUUVI_ERROR(bme280_get_regs(BME280_DATA_ADDR + first, raw + first,
+                                last - first, &dev));
 
   if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
 
@@ -574,23 +946,37 @@ ruuvi_driver_status_t ruuvi_interface_bme280_data_get(ruuvi_driver_sensor_data_t
   err_code |= ruuvi_interface_bme280_mode_get(&mode);
 
   if(RUUVI_DRIVER_SENSOR_CFG_SLEEP == mode)           { p_data->timestamp_ms = tsample; }
-  else if(RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS == mode) { p_data->timestamp_ms = ruuvi_driver_sensor_timestamp_get(); }
+  else if(RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS == mode)
+  {
+    uint8_t status = 0;
+    err_code |= BME_TO_RUUVI_ERROR(bme280_get_regs(BME280_STATUS_ADDR, &status, 1, &dev));
+    p_data->timestamp_ms = ruuvi_interface_bme280_schedule_tsample(&m_schedule,
+                           ruuvi_driver_sensor_timestamp_get(), status & BME280_STATUS_MEASURING);
+  }
   else { RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_INTERNAL, ~RUUVI_DRIVER_ERROR_FATAL); }
 
   // If we have valid data, return it.
   if(RUUVI_DRIVER_UINT64_INVALID != p_data->timestamp_ms)
   {
     ruuvi_driver_sensor_data_t d_environmental = {0};
-    ruuvi_driver_sensor_data_fields_t env_fields = {.bitfield = 0};
+    const int32_t adc_p = ((int32_t)raw[0] << 12) | ((int32_t)raw[1] << 4) | (raw[2] >> 4);
+    const int32_t adc_t = ((int32_t)raw[3] << 12) | ((int32_t)raw[4] << 4) | (raw[5] >> 4);
+    const int32_t adc_h = ((int32_t)raw[6] << 8)  | raw[7];
+    int32_t t_fine;
+    const int32_t temperature = bme280_compensate_t(adc_t, &t_fine);
+    const uint32_t pressure   = env_fields.datas.pressure_pa ?
+                                bme280_compensate_p(adc_p, t_fine) : 0;
+    const uint32_t humidity   = env_fields.datas.humidity_rh ?
+                                bme280_compensate_h(adc_h, t_fine) : 0;
     float env_values[3];
-    env_values[0] = (float)comp_data.humidity;
-    env_values[1] = (float)comp_data.pressure;
-    env_values[2] = (float)comp_data.temperature;
-    env_fields.datas.humidity_rh = 1;
-    env_fields.datas.pressure_pa = 1;
-    env_fields.datas.temperature_c = 1;
+    env_values[0] = humidity / 1024.0f;
+    env_values[1] = pressure / 256.0f;
+    env_values[2] = temperature / 100.0f;
     d_environmental.data = env_values;
-    d_environmental.fields = env_fields;
+    // Layout of values is fixed, only converted and requested values are valid.
+    d_environmental.fields.datas.humidity_rh = 1;
+    d_environmental.fields.datas.pressure_pa = 1;
+    d_environmental.fields.datas.temperature_c = 1;
     d_environmental.valid  = env_fields;
     ruuvi_driver_sensor_data_populate(p_data,
                                       &d_environmental,
@@ -599,5 +985,60 @@ ruuvi_driver_status_t ruuvi_interface_bme280_data_get(ruuvi_driver_sensor_data_t
 
   return err_code;
 }
+
+ruuvi_driver_status_t ruuvi_interface_bme280_measure_start(uint32_t* const conversion_us)
+{
+  if(NULL == conversion_us) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  VERIFY_SENSOR_SLEEPS();
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  err_code = BME_TO_RUUVI_ERROR(bme280_set_sensor_mode(BME280_FORCED_MODE, &dev));
+  *conversion_us = bme280_meas_time_us(true);
+  // Sample is timestamped at the end of conversion, data_get returns it once
+  // sensor is back in sleep.
+  const uint64_t now = ruuvi_driver_sensor_timestamp_get();
+  tsample = (RUUVI_DRIVER_UINT64_INVALID == now) ? now :
+            now + (*conversion_us + 999) / 1000;
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_bme280_channels_set(
+  ruuvi_driver_sensor_data_fields_t* const channels)
+{
+  if(NULL == channels) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(!(channels->datas.humidity_rh
+       || channels->datas.pressure_pa
+       || channels->datas.temperature_c))
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  VERIFY_SENSOR_SLEEPS();
+  ruuvi_driver_status_t err_code = BME_TO_RUUVI_ERROR(bme280_get_sensor_settings(&dev));
+  m_channels.bitfield = 0;
+  m_channels.datas.humidity_rh   = channels->datas.humidity_rh;
+  m_channels.datas.pressure_pa   = channels->datas.pressure_pa;
+  m_channels.datas.temperature_c = 1;
+  bme280_channels_apply();
+  // Shorter measurement allows longer standby at same samplerate.
+  bme280_standby_select(m_interval_us, false);
+  err_code |= BME_TO_RUUVI_ERROR(bme280_set_sensor_settings(BME280_OSR_PRESS_SEL
+                                 | BME280_OSR_TEMP_SEL | BME280_OSR_HUM_SEL
+                                 | BME280_STANDBY_SEL, &dev));
+  err_code |= ruuvi_interface_bme280_channels_get(channels);
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_bme280_channels_get(
+  ruuvi_driver_sensor_data_fields_t* const channels)
+{
+  if(NULL == channels) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  channels->datas.humidity_rh   = m_channels.datas.humidity_rh;
+  channels->datas.pressure_pa   = m_channels.datas.pressure_pa;
+  channels->datas.temperature_c = m_channels.datas.temperature_c;
+  return RUUVI_DRIVER_SUCCESS;
+}
 /*@}*/
 #endif
\ No newline at end of file
@@ -12,7 +12,8 @@
  * @brief Implement @ref ruuvi_driver_sensor_t functions on BME280
  *
  * The implementation supports
- * different samplerates, low-pass filtering and oversampling.
+ * different samplerates, low-pass filtering, oversampling and
+ * skipping unused channels.
  */
 /*@}*/
 /**
@@ -82,5 +83,75 @@ ruuvi_driver_status_t ruuvi_interface_bme280_mode_get(uint8_t*);
 /** @brief @ref ruuvi_driver_sensor_data_fp */
 ruuvi_driver_status_t ruuvi_interface_bme280_data_get(ruuvi_driver_sensor_data_t* const
     data);
+
+/**
+ * @brief Select channels which BME280 converts.
+ *
+ * Skipped channels have oversampling 0, so they are never converted or read,
+ * which shortens measurement time and lowers power consumption.
+ * Temperature is required for compensating pressure and humidity, so it is
+ * enabled if either of them is enabled.
+ * Data fields which are not converted are not marked valid in @ref ruuvi_driver_sensor_data_t.
+ *
+ * @param[in, out] channels Fields humidity_rh, pressure_pa and temperature_c select the
+ *                          channels. Written with channels which were enabled.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if channels is NULL
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if no channel is selected
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if sensor is not in sleep mode
+ * @return error code from stack on other error.
+ */
+ruuvi_driver_status_t ruuvi_interface_bme280_channels_set(
+  ruuvi_driver_sensor_data_fields_t* const channels);
+
+/**
+ * @brief Get channels which BME280 converts.
+ *
+ * @param[out] channels Fields humidity_rh, pressure_pa and temperature_c of enabled channels.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if channels is NULL
+ */
+ruuvi_driver_status_t ruuvi_interface_bme280_channels_get(
+  ruuvi_driver_sensor_data_fields_t* const channels);
+
+/**
+ * @brief Start a forced mode conversion without waiting for it.
+ *
+ * Data can be read with @ref ruuvi_interface_bme280_data_get after conversion time.
+ * Conforms to @ref ruuvi_interface_environmental_measure_start_fp.
+ *
+ * @param[out] conversion_us Maximum conversion time with current settings.
+ * @return RUUVI_DRIVER_SUCCESS on success
+ * @return RUUVI_DRIVER_ERROR_NULL if conversion_us is NULL
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if sensor is not in sleep mode
+ */
+ruuvi_driver_status_t ruuvi_interface_bme280_measure_start(uint32_t* const conversion_us);
+
+/** @brief Estimated schedule of samples in normal mode. */
+typedef struct
+{
+  uint64_t start_ms;  //!< Estimated start of a measurement cycle.
+  uint64_t latest_ms; //!< Latest given timestamp, RUUVI_DRIVER_UINT64_INVALID if none.
+  uint32_t meas_us;   //!< Typical measurement time.
+  uint32_t period_us; //!< Typical measurement + standby time, 0 if schedule is unknown.
+} ruuvi_interface_bme280_schedule_t;
+
+/**
+ * @brief Timestamp of latest completed sample in normal mode.
+ *
+ * Samples complete at start + measurement time + N * period. Actual period differs
+ * from typical period, so start is re-anchored whenever a conversion is seen running:
+ * the cycle started within the last measurement time. Estimate is never later than now
+ * and never earlier than previous estimate. Used by
+ * @ref ruuvi_interface_bme280_data_get, public for testing.
+ *
+ * @param[in, out] schedule Schedule of samples, start and latest are updated.
+ * @param[in] now_ms Current time.
+ * @param[in] measuring True if status register shows a conversion running.
+ * @return Time of latest sample, RUUVI_DRIVER_UINT64_INVALID if first sample is not ready.
+ * @return now_ms if schedule is not known.
+ */
+uint64_t ruuvi_interface_bme280_schedule_tsample(ruuvi_interface_bme280_schedule_t* const
+    schedule, const uint64_t now_ms, const bool measuring);
 /*@}*/
 #endif
\ No newline at end of file
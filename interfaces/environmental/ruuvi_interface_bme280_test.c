@@ -0,0 +1,153 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_RUN_TESTS && RUUVI_INTERFACE_ENVIRONMENTAL_BME280_ENABLED
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_sensor.h"
+#include "ruuvi_driver_test.h"
+#include "ruuvi_interface_bme280.h"
+#include "ruuvi_interface_bme280_test.h"
+#include <stdbool.h>
+
+/** @brief Time of first conversion start of simulated sensor, us. */
+static uint64_t m_sensor_start_us;
+
+/** @brief Number of samples simulated sensor has completed at now_ms. */
+static uint64_t sensor_samples(const uint64_t now_ms)
+{
+  const uint64_t now_us = now_ms * 1000;
+
+  if(now_us < m_sensor_start_us + RUUVI_INTERFACE_BME280_TEST_MEAS_US) { return 0; }
+
+  return 1 + (now_us - m_sensor_start_us - RUUVI_INTERFACE_BME280_TEST_MEAS_US)
+         / RUUVI_INTERFACE_BME280_TEST_PERIOD_US;
+}
+
+/** @brief Status register of simulated sensor shows conversion running at now_ms. */
+static bool sensor_measuring(const uint64_t now_ms)
+{
+  const uint64_t now_us = now_ms * 1000;
+
+  if(now_us < m_sensor_start_us) { return false; }
+
+  return ((now_us - m_sensor_start_us) % RUUVI_INTERFACE_BME280_TEST_PERIOD_US)
+         < RUUVI_INTERFACE_BME280_TEST_MEAS_US;
+}
+
+/** @brief Completion time of latest sample of simulated sensor, first sample if none, ms. */
+static uint64_t sensor_latest_ms(const uint64_t now_ms)
+{
+  const uint64_t samples = sensor_samples(now_ms);
+  const uint64_t latest = (samples > 0) ? (samples - 1) : 0;
+  return (m_sensor_start_us + RUUVI_INTERFACE_BME280_TEST_MEAS_US
+          + latest * RUUVI_INTERFACE_BME280_TEST_PERIOD_US) / 1000;
+}
+
+/** @brief Distance of delta_ms to nearest multiple of period, ms. */
+static uint64_t period_residual(const uint64_t delta_ms)
+{
+  const uint64_t delta_us = delta_ms * 1000;
+  uint64_t residual = delta_us % RUUVI_INTERFACE_BME280_TEST_PERIOD_US;
+
+  if(residual > RUUVI_INTERFACE_BME280_TEST_PERIOD_US / 2)
+  {
+    residual = RUUVI_INTERFACE_BME280_TEST_PERIOD_US - residual;
+  }
+
+  return residual / 1000;
+}
+
+/** @brief Nearest number of periods in delta_ms. */
+static uint64_t period_count(const uint64_t delta_ms)
+{
+  return (delta_ms * 1000 + RUUVI_INTERFACE_BME280_TEST_PERIOD_US / 2)
+         / RUUVI_INTERFACE_BME280_TEST_PERIOD_US;
+}
+
+/**
+ * @brief Read simulated sensor every poll interval for given number of periods.
+ *
+ * @param[in, out] schedule Schedule under test.
+ * @param[in, out] now_ms Simulated time, advanced by reads.
+ * @param[in, out] latest_ms Latest valid timestamp, RUUVI_DRIVER_UINT64_INVALID if none.
+ * @param[in] periods Number of periods to read.
+ * @return true if all timestamps pass.
+ */
+static bool schedule_poll(ruuvi_interface_bme280_schedule_t* const schedule,
+                          uint64_t* const now_ms, uint64_t* const latest_ms, const uint32_t periods)
+{
+  const uint64_t meas_ms = RUUVI_INTERFACE_BME280_TEST_MEAS_US / 1000;
+  const uint64_t end_ms = *now_ms
+                          + (periods * (uint64_t) RUUVI_INTERFACE_BME280_TEST_PERIOD_US) / 1000;
+  bool pass = true;
+
+  while(pass && *now_ms < end_ms)
+  {
+    *now_ms += RUUVI_INTERFACE_BME280_TEST_POLL_MS;
+    const uint64_t ts = ruuvi_interface_bme280_schedule_tsample(schedule, *now_ms,
+                        sensor_measuring(*now_ms));
+
+    if(RUUVI_DRIVER_UINT64_INVALID == ts)
+    {
+      pass = (RUUVI_DRIVER_UINT64_INVALID == *latest_ms) && (0 == sensor_samples(*now_ms));
+      continue;
+    }
+
+    // Before first conversion is seen running, schedule is anchored at mode change
+    // and first sample may be given up to the start delay of sensor early.
+    const uint64_t truth = sensor_latest_ms(*now_ms);
+    pass = (ts <= *now_ms) && (((ts > truth) ? (ts - truth) : (truth - ts)) <= meas_ms + 1);
+
+    if(pass && RUUVI_DRIVER_UINT64_INVALID != *latest_ms)
+    {
+      pass = (ts >= *latest_ms) && (period_residual(ts - *latest_ms) <= meas_ms + 1);
+    }
+
+    *latest_ms = ts;
+  }
+
+  return pass;
+}
+
+ruuvi_driver_status_t ruuvi_interface_bme280_test_schedule(void)
+{
+  bool fail = false;
+
+  for(uint32_t offset_us = 0; offset_us <= 5000; offset_us += 500)
+  {
+    const uint64_t anchor_ms = 1000;
+    ruuvi_interface_bme280_schedule_t schedule =
+    {
+      .start_ms  = anchor_ms,
+      .latest_ms = RUUVI_DRIVER_UINT64_INVALID,
+      .meas_us   = RUUVI_INTERFACE_BME280_TEST_MEAS_US,
+      .period_us = RUUVI_INTERFACE_BME280_TEST_PERIOD_US
+    };
+    uint64_t now_ms = anchor_ms;
+    uint64_t latest_ms = RUUVI_DRIVER_UINT64_INVALID;
+    m_sensor_start_us = anchor_ms * 1000 + offset_us;
+    // - Timestamps before gap must be monotonic, spaced at period and near samples.
+    bool pass = schedule_poll(&schedule, &now_ms, &latest_ms, 10);
+    const uint64_t before_ms = latest_ms;
+    const uint64_t samples_before = sensor_samples(now_ms);
+    ruuvi_driver_test_register(pass);
+    fail |= !pass;
+    // - Gap without reads.
+    now_ms += (RUUVI_INTERFACE_BME280_TEST_GAP
+               * (uint64_t) RUUVI_INTERFACE_BME280_TEST_PERIOD_US) / 1000;
+    // - Timestamps after gap must continue with number of periods sampled during gap.
+    pass = schedule_poll(&schedule, &now_ms, &latest_ms, 1);
+    pass = pass && (RUUVI_DRIVER_UINT64_INVALID != before_ms)
+           && (period_count(latest_ms - before_ms) == sensor_samples(now_ms) - samples_before);
+    pass = pass && schedule_poll(&schedule, &now_ms, &latest_ms, 10);
+    ruuvi_driver_test_register(pass);
+    fail |= !pass;
+  }
+
+  if(fail)
+  {
+    RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  return RUUVI_DRIVER_SUCCESS;
+}
+#endif
@@ -0,0 +1,47 @@
+#ifndef RUUVI_INTERFACE_BME280_TEST_H
+#define RUUVI_INTERFACE_BME280_TEST_H
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_test.h"
+/**
+ * @addtogroup Environmental
+ * @{
+ */
+/**
+* @file ruuvi_interface_bme280_test.h
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-12-18
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Test timestamps of BME280 normal mode against a simulated sensor and clock.
+*
+*/
+
+/** @brief Typical measurement time of simulated sensor, 1x oversampling on all channels. */
+#define RUUVI_INTERFACE_BME280_TEST_MEAS_US   9300
+/** @brief Typical period of simulated sensor, 62.5 ms standby. */
+#define RUUVI_INTERFACE_BME280_TEST_PERIOD_US 71800
+/** @brief Interval of reads in simulation. */
+#define RUUVI_INTERFACE_BME280_TEST_POLL_MS   7
+/** @brief Number of periods without reads in simulation. */
+#define RUUVI_INTERFACE_BME280_TEST_GAP       20
+
+/**
+ * @brief Test timestamps of normal mode samples with simulated sensor.
+ *
+ * Sensor starts measuring 0 ... 5 ms after schedule is anchored, runs at typical
+ * timing and is read every few ms before and after a gap of several periods without
+ * reads. Drift of sensor oscillator is not simulated.
+ *
+ * - Timestamp must be @c RUUVI_DRIVER_UINT64_INVALID only before first sample.
+ * - Timestamp must never decrease and never be later than current time.
+ * - Timestamp must be within measurement time of latest completed sample.
+ * - Timestamps must be spaced at multiples of period, within measurement time.
+ * - Number of periods between timestamps before and after gap must match number of
+ *   samples completed during the gap.
+ *
+ * @return @c RUUVI_DRIVER_SUCCESS if all tests pass, error code on failure
+ */
+ruuvi_driver_status_t ruuvi_interface_bme280_test_schedule(void);
+
+/*@}*/
+#endif
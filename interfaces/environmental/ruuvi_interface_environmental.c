@@ -0,0 +1,98 @@
+#include "ruuvi_driver_enabled_modules.h"
+#include "ruuvi_interface_environmental.h"
+#if RUUVI_INTERFACE_ENVIRONMENTAL_ENABLED || DOXYGEN
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_sensor.h"
+#include "ruuvi_interface_yield.h"
+
+/**
+ * @addtogroup Environmental
+ */
+/*@{*/
+/**
+ * @file ruuvi_interface_environmental.c
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-02
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ *
+ * Parallel sampling of environmental sensors.
+ */
+
+/** @brief Maximum number of values in one sample of a sensor. */
+#define ENVIRONMENTAL_MAX_VALUES (32U)
+
+static bool source_is_usable(const ruuvi_interface_environmental_source_t* const source)
+{
+  return (NULL != source->sensor)
+         && (NULL != source->measure_start)
+         && ruuvi_driver_sensor_is_init(source->sensor);
+}
+
+ruuvi_driver_status_t ruuvi_interface_environmental_sample(
+  const ruuvi_interface_environmental_source_t* const sources, const size_t count,
+  ruuvi_driver_sensor_data_t* const data)
+{
+  if(NULL == sources || NULL == data) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(RUUVI_INTERFACE_ENVIRONMENTAL_MAX_SOURCES < count)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  uint32_t started = 0; // Bitmask of sources with conversion running.
+  uint32_t longest_us = 0;
+  uint64_t timestamp = 0;
+  data->valid.bitfield = 0;
+
+  // Start all conversions before waiting for any of them.
+  for(size_t ii = 0; ii < count; ii++)
+  {
+    if(!source_is_usable(&sources[ii])) { continue; }
+
+    uint32_t conversion_us = 0;
+    const ruuvi_driver_status_t start_status = sources[ii].measure_start(&conversion_us);
+    err_code |= start_status;
+
+    // Keep going on error, conversions already started must still be collected.
+    if(RUUVI_DRIVER_SUCCESS != start_status) { continue; }
+
+    started |= (1UL << ii);
+
+    if(conversion_us > longest_us) { longest_us = conversion_us; }
+  }
+
+  if(longest_us >= 1000)
+  {
+    ruuvi_interface_delay_ms((longest_us + 999) / 1000);
+  }
+  else if(longest_us)
+  {
+    ruuvi_interface_delay_us(longest_us);
+  }
+
+  // Read results back to back while bus is up.
+  for(size_t ii = 0; ii < count; ii++)
+  {
+    if(!(started & (1UL << ii))) { continue; }
+
+    float values[ENVIRONMENTAL_MAX_VALUES];
+    ruuvi_driver_sensor_data_t sample = {0};
+    sample.fields = sources[ii].sensor->provides;
+    sample.data = values;
+    err_code |= sources[ii].sensor->data_get(&sample);
+    ruuvi_driver_sensor_data_populate(data, &sample, data->fields);
+
+    if(RUUVI_DRIVER_UINT64_INVALID != sample.timestamp_ms
+        && sample.timestamp_ms > timestamp)
+    {
+      timestamp = sample.timestamp_ms;
+    }
+  }
+
+  data->timestamp_ms = timestamp ? timestamp : RUUVI_DRIVER_UINT64_INVALID;
+  return err_code;
+}
+
+/*@}*/
+#endif
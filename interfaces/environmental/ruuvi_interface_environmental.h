@@ -3,6 +3,8 @@
 #include "ruuvi_driver_enabled_modules.h"
 #if RUUVI_INTERFACE_ENVIRONMENTAL_ENABLED || DOXYGEN
   #include "ruuvi_driver_error.h"
+  #include "ruuvi_driver_sensor.h"
+  #include <stddef.h>
   #include <stdint.h>
 
   /**
@@ -18,9 +20,72 @@
   * @date 2019-08-07
   * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
   *
+  * Sample several environmental sensors in parallel. Conversions of all sensors
+  * are started first, then CPU sleeps once until the longest conversion is ready and
+  * results are read back to back. Total time is the longest conversion time
+  * instead of the sum of conversion times.
   *
+  * @code{.c}
+  *  static const ruuvi_interface_environmental_source_t sources[] =
+  *  {
+  *    { .sensor = &bme280, .measure_start = ruuvi_interface_bme280_measure_start },
+  *    { .sensor = &shtcx,  .measure_start = ruuvi_interface_shtcx_measure_start },
+  *    { .sensor = &tmp117, .measure_start = ruuvi_interface_tmp117_measure_start }
+  *  };
+  *  float values[3];
+  *  ruuvi_driver_sensor_data_t data = { .fields = fields, .data = values };
+  *  err_code = ruuvi_interface_environmental_sample(sources, 3, &data);
+  * @endcode
   */
 
+  /**
+   * @brief Start a single conversion without waiting for it.
+   *
+   * Result is read with data_get of the sensor once conversion time has passed.
+   * Sensor must be in sleep mode.
+   *
+   * @param[out] conversion_us Maximum time until result is ready, in microseconds.
+   * @return RUUVI_DRIVER_SUCCESS on success.
+   * @return RUUVI_DRIVER_ERROR_NULL if conversion_us is NULL.
+   * @return RUUVI_DRIVER_ERROR_INVALID_STATE if sensor is not initialized or is in
+   *         continuous mode.
+   */
+  typedef ruuvi_driver_status_t (*ruuvi_interface_environmental_measure_start_fp)(
+    uint32_t* const conversion_us);
+
+  /** @brief Maximum number of sources in one call to
+   *         @ref ruuvi_interface_environmental_sample. */
+#define RUUVI_INTERFACE_ENVIRONMENTAL_MAX_SOURCES (32U)
+
+  /** @brief Sensor sampled by @ref ruuvi_interface_environmental_sample. */
+  typedef struct
+  {
+    const ruuvi_driver_sensor_t* sensor; //!< Initialized sensor, data is read with data_get.
+    /** @brief Starts conversion of sensor. */
+    ruuvi_interface_environmental_measure_start_fp measure_start;
+  } ruuvi_interface_environmental_source_t;
+
+  /**
+   * @brief Take one sample from all given sensors in parallel.
+   *
+   * Data of sensors is merged to data in given order, later sources overwrite values
+   * of earlier sources. Sensors which are not initialized are skipped. Timestamp
+   * of data is the latest timestamp of sensors. If starting a sensor fails, the
+   * other sensors are still sampled and error is returned with their data.
+   *
+   * @param[in] sources Sensors to sample.
+   * @param[in] count Number of sources.
+   * @param[in,out] data Fields to fill as input, merged samples as output.
+   * @return RUUVI_DRIVER_SUCCESS on success.
+   * @return RUUVI_DRIVER_ERROR_NULL if sources or data is NULL.
+   * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if count is larger than
+   *         @ref RUUVI_INTERFACE_ENVIRONMENTAL_MAX_SOURCES.
+   * @return error code from sensor if sampling a sensor fails.
+   */
+  ruuvi_driver_status_t ruuvi_interface_environmental_sample(
+    const ruuvi_interface_environmental_source_t* const sources, const size_t count,
+    ruuvi_driver_sensor_data_t* const data);
+
   /*@}*/
 #endif
 #endif
\ No newline at end of file
@@ -74,8 +74,16 @@ ruuvi_driver_status_t ruuvi_interface_environmental_mcu_dsp_get(uint8_t* dsp,
 ruuvi_driver_status_t ruuvi_interface_environmental_mcu_mode_set(uint8_t*);
 /** @brief @ref ruuvi_driver_sensor_setup_fp */
 ruuvi_driver_status_t ruuvi_interface_environmental_mcu_mode_get(uint8_t*);
-/** @brief @ref ruuvi_driver_sensor_data_fp */
+/**
+ * @brief @ref ruuvi_driver_sensor_data_fp
+ *
+ * In continuous mode returns the last completed conversion and starts the next one,
+ * which completes in background.
+ */
 ruuvi_driver_status_t ruuvi_interface_environmental_mcu_data_get(
   ruuvi_driver_sensor_data_t* const data);
+/** @brief @ref ruuvi_interface_environmental_measure_start_fp */
+ruuvi_driver_status_t ruuvi_interface_environmental_mcu_measure_start(
+  uint32_t* const conversion_us);
 /*@}*/
 #endif
\ No newline at end of file
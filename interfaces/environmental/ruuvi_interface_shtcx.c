@@ -49,8 +49,18 @@
 
 
 
+/** @brief Maximum conversion time in normal measurement mode, SHTC3 datasheet. */
+#define SHTCX_MEAS_TIME_NORMAL_US (12100U)
+/** @brief Maximum conversion time in low-power measurement mode, SHTC3 datasheet. */
+#define SHTCX_MEAS_TIME_LOW_POWER_US (800U)
+/** @brief Margin for truncation of millisecond timestamps. */
+#define SHTCX_TIMESTAMP_MARGIN_US (1000U)
+
 static uint64_t m_tsample;           //!< Timestamp of sample.
+static uint64_t m_tmeasure;          //!< Timestamp of started conversion.
 static bool m_autorefresh;           //!< Flag to refresh data on data_get.
+static bool m_low_power;             //!< Flag, use low-power measurement mode.
+static bool m_pending;               //!< Flag, single conversion started but not read.
 static int32_t m_temperature;        //!< Last measured temperature.
 static int32_t m_humidity;           //!< Last measured humidity.
 static bool m_is_init;               //!< Flag, is sensor init.
@@ -84,6 +94,47 @@ static ruuvi_driver_status_t SHTCX_TO_RUUVI_ERROR(const int16_t rslt)
   return err_code;
 }
 
+/**
+ * @brief Maximum conversion time of current measurement mode.
+ */
+static uint32_t shtcx_meas_time_us(void)
+{
+  return m_low_power ? SHTCX_MEAS_TIME_LOW_POWER_US : SHTCX_MEAS_TIME_NORMAL_US;
+}
+
+/**
+ * @brief Time until started conversion is ready to be read.
+ *
+ * @return Remaining time in microseconds, 0 if conversion is ready or none has
+ *         been started, maximum conversion time if conversion cannot be timed.
+ */
+static uint32_t shtcx_conversion_remaining_us(void)
+{
+  const uint64_t now = ruuvi_driver_sensor_timestamp_get();
+  const uint32_t ready_us = shtcx_meas_time_us() + SHTCX_TIMESTAMP_MARGIN_US;
+
+  if(RUUVI_DRIVER_UINT64_INVALID == now || RUUVI_DRIVER_UINT64_INVALID == m_tmeasure)
+  {
+    return shtcx_meas_time_us();
+  }
+
+  const uint64_t elapsed_us = (now - m_tmeasure) * 1000;
+  return (elapsed_us >= ready_us) ? 0 : (uint32_t)(ready_us - elapsed_us);
+}
+
+/**
+ * @brief Start a conversion without clock stretching and store start time.
+ *
+ * Result is read with @ref shtc1_read once conversion time has passed.
+ */
+static ruuvi_driver_status_t shtcx_conversion_start(void)
+{
+  ruuvi_driver_status_t err_code = SHTCX_TO_RUUVI_ERROR(shtc1_measure());
+  m_tmeasure = (RUUVI_DRIVER_SUCCESS == err_code) ? ruuvi_driver_sensor_timestamp_get() :
+               RUUVI_DRIVER_UINT64_INVALID;
+  return err_code;
+}
+
 ruuvi_driver_status_t ruuvi_interface_shtcx_init(ruuvi_driver_sensor_t*
     environmental_sensor, ruuvi_driver_bus_t bus, uint8_t handle)
 {
@@ -114,8 +165,9 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_init(ruuvi_driver_sensor_t*
 
   if(RUUVI_DRIVER_SUCCESS == err_code)
   {
-    // Sensirion driver delays high-power mode time in any case.
-    // Explicitly entering low-power mode has no effect.
+    // Blocking read of Sensirion driver delays high-power mode time in any case,
+    // low-power mode shortens conversion in continuous mode.
+    m_low_power = false;
     shtc1_enable_low_power_mode(0);
     environmental_sensor->init              = ruuvi_interface_shtcx_init;
     environmental_sensor->uninit            = ruuvi_interface_shtcx_uninit;
@@ -136,6 +188,7 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_init(ruuvi_driver_sensor_t*
     environmental_sensor->provides.datas.temperature_c = 1;
     environmental_sensor->provides.datas.humidity_rh = 1;
     m_tsample = RUUVI_DRIVER_UINT64_INVALID;
+    m_pending = false;
     m_is_init = true;
   }
 
@@ -153,6 +206,7 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_uninit(ruuvi_driver_sensor_t* sensor
   m_tsample = RUUVI_DRIVER_UINT64_INVALID;
   m_temperature = RUUVI_DRIVER_INT32_INVALID;
   m_humidity = RUUVI_DRIVER_INT32_INVALID;
+  m_pending = false;
   m_is_init = false;
   return err_code;
 }
@@ -255,6 +309,17 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_mode_set(uint8_t* mode)
   // Enter sleep by default and by explicit sleep commmand
   if(RUUVI_DRIVER_SENSOR_CFG_SLEEP == *mode || RUUVI_DRIVER_SENSOR_CFG_DEFAULT == *mode)
   {
+    if(m_autorefresh)
+    {
+      // Sleep command is ignored while converting, wait for conversion in flight.
+      // SHTC1 does not support sleep, error is ignored.
+      const uint32_t remaining_us = shtcx_conversion_remaining_us();
+
+      if(remaining_us) { ruuvi_interface_delay_us(remaining_us); }
+
+      shtc1_sleep();
+    }
+
     m_autorefresh = false;
     *mode = RUUVI_DRIVER_SENSOR_CFG_SLEEP;
     return RUUVI_DRIVER_SUCCESS;
@@ -269,13 +334,12 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_mode_set(uint8_t* mode)
     if(RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS == current_mode)
     {
       *mode = RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS;
-      // Start first measurement
-      shtc1_measure();
       return RUUVI_DRIVER_ERROR_INVALID_STATE;
     }
 
     // Enter sleep after measurement
     m_autorefresh = false;
+    m_pending = false;
     *mode = RUUVI_DRIVER_SENSOR_CFG_SLEEP;
     m_tsample = ruuvi_driver_sensor_timestamp_get();
     return SHTCX_TO_RUUVI_ERROR(shtc1_measure_blocking_read(&m_temperature, &m_humidity));
@@ -283,8 +347,14 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_mode_set(uint8_t* mode)
 
   if(RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS == *mode)
   {
+    if(m_autorefresh) { return RUUVI_DRIVER_SUCCESS; }
+
+    // Sensor is kept awake in continuous mode, SHTC1 does not support sleep
+    // and returns an error which is ignored.
+    shtc1_wake_up();
     m_autorefresh = true;
-    return RUUVI_DRIVER_SUCCESS;
+    m_pending = false;
+    return shtcx_conversion_start();
   }
 
   return RUUVI_DRIVER_ERROR_INVALID_PARAM;
@@ -316,15 +386,42 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_data_get(ruuvi_driver_sensor_data_t*
 
   if(m_autorefresh)
   {
-    /* Sensor sleep clears measured values, blocking read required.
-    // read sensor values
+    const uint64_t now = ruuvi_driver_sensor_timestamp_get();
+
+    if(RUUVI_DRIVER_UINT64_INVALID == now || RUUVI_DRIVER_UINT64_INVALID == m_tmeasure)
+    {
+      // Conversion cannot be timed, wait for it.
+      ruuvi_interface_delay_us(shtcx_meas_time_us());
+      err_code |= SHTCX_TO_RUUVI_ERROR(shtc1_read(&m_temperature, &m_humidity));
+      m_tsample = now;
+      err_code |= shtcx_conversion_start();
+    }
+    else if(0 == shtcx_conversion_remaining_us())
+    {
+      // Read completed conversion and start next one right away,
+      // previous sample is returned until next conversion is ready.
+      // On error conversion is kept pending so that caller can retry the read.
+      err_code |= SHTCX_TO_RUUVI_ERROR(shtc1_read(&m_temperature, &m_humidity));
+
+      if(RUUVI_DRIVER_SUCCESS == err_code)
+      {
+        m_tsample = m_tmeasure + (shtcx_meas_time_us() + 999) / 1000;
+        err_code |= shtcx_conversion_start();
+      }
+    }
+  }
+  else if(m_pending)
+  {
+    // Result of conversion started by ruuvi_interface_shtcx_measure_start.
     err_code |= SHTCX_TO_RUUVI_ERROR(shtc1_read(&m_temperature, &m_humidity));
-    // Start next measurement
-    err_code |= SHTCX_TO_RUUVI_ERROR(shtc1_measure());
-    */
-    err_code |= SHTCX_TO_RUUVI_ERROR(shtc1_measure_blocking_read(&m_temperature,
-                                     &m_humidity));
-    m_tsample = ruuvi_driver_sensor_timestamp_get();
+
+    if(RUUVI_DRIVER_SUCCESS == err_code)
+    {
+      m_tsample = (RUUVI_DRIVER_UINT64_INVALID == m_tmeasure) ? m_tmeasure :
+                  m_tmeasure + (shtcx_meas_time_us() + 999) / 1000;
+      m_pending = false;
+      shtc1_sleep();
+    }
   }
 
   if(RUUVI_DRIVER_SUCCESS == err_code && RUUVI_DRIVER_UINT64_INVALID != m_tsample)
@@ -348,6 +445,36 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_data_get(ruuvi_driver_sensor_data_t*
   return err_code;
 }
 
+ruuvi_driver_status_t ruuvi_interface_shtcx_measure_start(uint32_t* const conversion_us)
+{
+  if(NULL == conversion_us) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(!m_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  VERIFY_SENSOR_SLEEPS();
+  // SHTC1 does not support sleep, error is ignored.
+  shtc1_wake_up();
+  m_pending = true;
+  *conversion_us = shtcx_meas_time_us();
+  return shtcx_conversion_start();
+}
+
+ruuvi_driver_status_t ruuvi_interface_shtcx_low_power_set(const bool enable)
+{
+  VERIFY_SENSOR_SLEEPS();
+  m_low_power = enable;
+  shtc1_enable_low_power_mode(enable);
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_shtcx_low_power_get(bool* const enabled)
+{
+  if(NULL == enabled) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  *enabled = m_low_power;
+  return RUUVI_DRIVER_SUCCESS;
+}
+
 /**
  * @brief Implement sleep function for SHTC driver.
  *
@@ -11,8 +11,9 @@
  * @defgroup SHTCX SHTCX Interface
  * @brief Implement @ref ruuvi_driver_sensor_t functions on SHTCX
  *
- * The implementation supports taking single-samples and a pseudo-continuous mode
- * by taking a new sample when data is polled in continuous mode
+ * The implementation supports taking single-samples and a continuous mode
+ * where next conversion is started when the previous one is read, so data is
+ * read without waiting for conversion. SHTC3 low-power measurement mode can be selected.
  */
 /*@}*/
 /**
@@ -72,5 +73,40 @@ ruuvi_driver_status_t ruuvi_interface_shtcx_mode_get(uint8_t*);
 /** @brief @ref ruuvi_driver_sensor_data_fp */
 ruuvi_driver_status_t ruuvi_interface_shtcx_data_get(ruuvi_driver_sensor_data_t* const
     p_data);
+
+/**
+ * @brief Start a conversion without waiting for it.
+ *
+ * Data can be read with @ref ruuvi_interface_shtcx_data_get after conversion time,
+ * sensor is put to sleep after the read.
+ * Conforms to @ref ruuvi_interface_environmental_measure_start_fp.
+ *
+ * @param[out] conversion_us Maximum conversion time in current measurement mode.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if conversion_us is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if sensor is not initialized or not in sleep.
+ */
+ruuvi_driver_status_t ruuvi_interface_shtcx_measure_start(uint32_t* const conversion_us);
+
+/**
+ * @brief Select SHTC3 low-power measurement mode.
+ *
+ * Low-power mode shortens conversion from 12.1 ms to 0.8 ms at the cost of
+ * repeatability. Mode is used on following conversions.
+ *
+ * @param[in] enable True to use low-power measurement mode, false to use normal mode.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if sensor is not in sleep mode.
+ */
+ruuvi_driver_status_t ruuvi_interface_shtcx_low_power_set(const bool enable);
+
+/**
+ * @brief Check if SHTC3 low-power measurement mode is in use.
+ *
+ * @param[out] enabled True if low-power measurement mode is used.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if enabled is NULL.
+ */
+ruuvi_driver_status_t ruuvi_interface_shtcx_low_power_get(bool* const enabled);
 /*@}*/
 #endif
\ No newline at end of file
@@ -2,8 +2,12 @@
 #include "ruuvi_driver_error.h"
 #include "ruuvi_driver_sensor.h"
 #include "ruuvi_interface_tmp117.h"
+#include "ruuvi_interface_gpio_interrupt.h"
 #include "ruuvi_interface_i2c_tmp117.h"
+#include "ruuvi_interface_scheduler.h"
 #include "ruuvi_interface_yield.h"
+#include <math.h>
+#include <string.h>
 
 #if (RUUVI_INTERFACE_ENVIRONMENTAL_TMP117_ENABLED || DOXYGEN)
 
@@ -20,6 +24,9 @@
  *
  * TMP117 temperature sensor driver.
  *
+ * If ALERT pin is configured with @ref ruuvi_interface_tmp117_alert_use
+ * completed conversions are read in scheduler context after data-ready interrupt,
+ * otherwise single samples wait for the conversion time.
  */
 
 /** @brief Macro for checking "ignored" parameters NO_CHANGE, MIN, MAX, DEFAULT */
@@ -38,6 +45,24 @@ static float    m_temperature;
 static uint64_t m_timestamp;
 static const char m_sensor_name[] = "TMP117";
 static bool m_continuous = false;
+static bool m_pending = false;  //!< Single conversion started but not read.
+static uint64_t m_tstart;       //!< Start time of pending conversion.
+/** @brief ALERT pin in data-ready mode. */
+static ruuvi_interface_gpio_id_t m_alert_pin = { .pin = RUUVI_INTERFACE_GPIO_ID_UNUSED };
+static ruuvi_interface_tmp117_data_ready_fp_t m_on_data; //!< Called on new data.
+
+/** @brief Averaging setting and its conversion time, longest first. */
+static const struct
+{
+  uint16_t os;
+  uint16_t ms;
+} m_os_table[] =
+{
+  { TMP117_VALUE_OS_64, 1000 },
+  { TMP117_VALUE_OS_32, 500  },
+  { TMP117_VALUE_OS_8,  125  },
+  { TMP117_VALUE_OS_1,  16   }
+};
 
 static ruuvi_driver_status_t tmp117_soft_reset(void)
 {
@@ -104,75 +129,29 @@ static ruuvi_driver_status_t tmp117_oversampling_set(const uint8_t num_os)
   return err_code;
 }
 
-static ruuvi_driver_status_t tmp117_samplerate_set(const uint16_t num_os)
+/**
+ * @brief Set conversion cycle and the highest averaging which fits in the cycle.
+ *
+ * @param[in] cc TMP117_VALUE_CC_ value to set.
+ * @param[in] cc_ms Length of the conversion cycle in milliseconds.
+ */
+static ruuvi_driver_status_t tmp117_cycle_set(const uint16_t cc, const uint16_t cc_ms)
 {
   uint16_t reg_val;
   ruuvi_driver_status_t err_code;
+  size_t os = 0;
   err_code = ruuvi_interface_i2c_tmp117_read(m_address, TMP117_REG_CONFIGURATION, &reg_val);
-  reg_val &= ~TMP117_MASK_CC;
+  reg_val &= ~(TMP117_MASK_CC | TMP117_MASK_OS);
 
-  switch(num_os)
+  while(m_os_table[os].ms > cc_ms
+        && os < (sizeof(m_os_table) / sizeof(m_os_table[0])) - 1)
   {
-    case TMP117_VALUE_CC_16_MS:
-      if(16 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_16_MS;
-      ms_per_cc = 16;
-      break;
-
-    case TMP117_VALUE_CC_125_MS:
-      if(125 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_125_MS;
-      ms_per_cc = 125;
-      break;
-
-    case TMP117_VALUE_CC_250_MS:
-      if(250 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_250_MS;
-      ms_per_cc = 250;
-      break;
-
-    case TMP117_VALUE_CC_500_MS:
-      if(500 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_500_MS;
-      ms_per_cc = 500;
-      break;
-
-    case TMP117_VALUE_CC_1000_MS:
-      if(1000 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_1000_MS;
-      ms_per_cc = 1000;
-      break;
-
-    case TMP117_VALUE_CC_4000_MS:
-      if(4000 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_4000_MS;
-      ms_per_cc = 4000;
-      break;
-
-    case TMP117_VALUE_CC_8000_MS:
-      if(8000 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_8000_MS;
-      ms_per_cc = 8000;
-      break;
-
-    case TMP117_VALUE_CC_16000_MS:
-      if(16000 < ms_per_sample) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
-
-      reg_val |= TMP117_VALUE_CC_16000_MS;
-      ms_per_cc = 16000;
-      break;
-
-    default:
-      return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+    os++;
   }
 
+  reg_val |= cc | m_os_table[os].os;
+  ms_per_cc = cc_ms;
+  ms_per_sample = m_os_table[os].ms;
   err_code |= ruuvi_interface_i2c_tmp117_write(m_address, TMP117_REG_CONFIGURATION,
               reg_val);
   return err_code;
@@ -199,7 +178,6 @@ static ruuvi_driver_status_t tmp117_sample(void)
   reg_val |= TMP117_VALUE_MODE_SINGLE;
   err_code |= ruuvi_interface_i2c_tmp117_write(m_address, TMP117_REG_CONFIGURATION,
               reg_val);
-  m_timestamp = ruuvi_driver_sensor_timestamp_get();
   return  err_code;
 }
 
@@ -228,6 +206,66 @@ static float tmp117_read(void)
   return temperature;
 }
 
+static ruuvi_driver_status_t tmp117_alert_configure(const bool data_ready)
+{
+  uint16_t reg_val;
+  ruuvi_driver_status_t err_code;
+  err_code = ruuvi_interface_i2c_tmp117_read(m_address, TMP117_REG_CONFIGURATION, &reg_val);
+  // ALERT is active low open-drain output.
+  reg_val &= ~(TMP117_MASK_DR_ALERT | TMP117_MASK_POL);
+
+  if(data_ready) { reg_val |= TMP117_MASK_DR_ALERT; }
+
+  err_code |= ruuvi_interface_i2c_tmp117_write(m_address, TMP117_REG_CONFIGURATION,
+              reg_val);
+  return err_code;
+}
+
+/**
+ * @brief Read completed conversion in scheduler context.
+ *
+ * Reading the result clears the data-ready flag and releases ALERT pin.
+ *
+ * @param[in] p_event_data Timestamp of the data-ready interrupt.
+ * @param[in] event_size Size of timestamp.
+ */
+static void tmp117_alert_handler(void* p_event_data, uint16_t event_size)
+{
+  // Sensor might have been uninitialized after interrupt.
+  if(RUUVI_INTERFACE_GPIO_ID_UNUSED == m_alert_pin.pin) { return; }
+
+  uint64_t timestamp = RUUVI_DRIVER_UINT64_INVALID;
+
+  if(NULL != p_event_data && sizeof(timestamp) == event_size)
+  {
+    memcpy(&timestamp, p_event_data, sizeof(timestamp));
+  }
+
+  // Cached sample is returned by data_get, conversion must not be read again.
+  m_temperature = tmp117_read();
+  m_timestamp = timestamp;
+  m_pending = false;
+
+  if(NULL != m_on_data)
+  {
+    float temperature = m_temperature;
+    ruuvi_driver_sensor_data_t data = {0};
+    data.data = &temperature;
+    data.fields.datas.temperature_c = 1;
+    data.valid.datas.temperature_c = !isnan(temperature);
+    data.timestamp_ms = m_timestamp;
+    m_on_data(&data);
+  }
+}
+
+/** @brief Timestamp data-ready interrupt and defer the read to scheduler. */
+static void tmp117_alert_isr(const ruuvi_interface_gpio_evt_t event)
+{
+  const uint64_t timestamp = ruuvi_driver_sensor_timestamp_get();
+  ruuvi_interface_scheduler_event_put(&timestamp, sizeof(timestamp),
+                                      tmp117_alert_handler);
+}
+
 ruuvi_driver_status_t ruuvi_interface_tmp117_init(ruuvi_driver_sensor_t*
     environmental_sensor, ruuvi_driver_bus_t bus, uint8_t handle)
 {
@@ -280,8 +318,12 @@ ruuvi_driver_status_t ruuvi_interface_tmp117_init(ruuvi_driver_sensor_t*
     m_timestamp = RUUVI_DRIVER_UINT64_INVALID;
     m_temperature = NAN;
     ms_per_cc = 1000;
-    ms_per_sample = 16;
     m_continuous = false;
+    m_pending = false;
+    m_alert_pin.pin = RUUVI_INTERFACE_GPIO_ID_UNUSED;
+    m_on_data = NULL;
+    // Reset value has 8x averaging, use single sample to match single mode timing.
+    err_code |= tmp117_oversampling_set(TMP117_VALUE_OS_1);
     err_code |= tmp117_sleep();
   }
 
@@ -295,6 +337,14 @@ ruuvi_driver_status_t ruuvi_interface_tmp117_uninit(ruuvi_driver_sensor_t* senso
 
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
   tmp117_sleep();
+
+  if(RUUVI_INTERFACE_GPIO_ID_UNUSED != m_alert_pin.pin)
+  {
+    ruuvi_interface_gpio_interrupt_disable(m_alert_pin);
+    m_alert_pin.pin = RUUVI_INTERFACE_GPIO_ID_UNUSED;
+  }
+
+  m_on_data = NULL;
   ruuvi_driver_sensor_uninitialize(sensor);
   m_timestamp = RUUVI_DRIVER_UINT64_INVALID;
   m_temperature = NAN;
@@ -321,42 +371,42 @@ ruuvi_driver_status_t ruuvi_interface_tmp117_samplerate_set(uint8_t* samplerate)
       1 >= *samplerate)
   {
     *samplerate = 1;
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_1000_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_1000_MS, 1000);
   }
   else if(2 >= *samplerate)
   {
     *samplerate = 2;
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_500_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_500_MS, 500);
   }
   else if(4 >= *samplerate)
   {
     *samplerate = 4;
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_250_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_250_MS, 250);
   }
   else if(8 >= *samplerate)
   {
     *samplerate = 8;
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_125_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_125_MS, 125);
   }
   else if(64 >= *samplerate ||
           RUUVI_DRIVER_SENSOR_CFG_MAX == *samplerate)
   {
     *samplerate = 64;
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_16_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_16_MS, 16);
   }
   else if(RUUVI_DRIVER_SENSOR_CFG_CUSTOM_1 == *samplerate)
   {
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_4000_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_4000_MS, 4000);
   }
   else if(RUUVI_DRIVER_SENSOR_CFG_CUSTOM_2 == *samplerate)
   {
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_8000_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_8000_MS, 8000);
   }
   else if(RUUVI_DRIVER_SENSOR_CFG_CUSTOM_3 == *samplerate ||
           RUUVI_DRIVER_SENSOR_CFG_MIN == *samplerate)
   {
     *samplerate = RUUVI_DRIVER_SENSOR_CFG_CUSTOM_3;
-    err_code |= tmp117_samplerate_set(TMP117_VALUE_CC_16000_MS);
+    err_code |= tmp117_cycle_set(TMP117_VALUE_CC_16000_MS, 16000);
   }
   else { err_code |= RUUVI_DRIVER_ERROR_NOT_SUPPORTED; }
 
@@ -557,7 +607,16 @@ ruuvi_driver_status_t ruuvi_interface_tmp117_mode_set(uint8_t* mode)
       }
 
       err_code |= tmp117_sample();
-      ruuvi_interface_delay_ms(ms_per_sample);
+      m_pending = false;
+
+      // Result is read after data-ready interrupt.
+      if(RUUVI_INTERFACE_GPIO_ID_UNUSED == m_alert_pin.pin)
+      {
+        ruuvi_interface_delay_ms(ms_per_sample);
+        m_temperature = tmp117_read();
+        m_timestamp = ruuvi_driver_sensor_timestamp_get();
+      }
+
       *mode = RUUVI_DRIVER_SENSOR_CFG_SLEEP;
       break;
 
@@ -588,11 +647,22 @@ ruuvi_driver_status_t ruuvi_interface_tmp117_data_get(ruuvi_driver_sensor_data_t
 
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
 
-  if(m_continuous)
+  // With ALERT pin in use conversions are read by alert handler, return cached sample.
+  const bool alert = (RUUVI_INTERFACE_GPIO_ID_UNUSED != m_alert_pin.pin);
+
+  if(!alert && m_continuous)
   {
     m_temperature = tmp117_read();
     m_timestamp = ruuvi_driver_sensor_timestamp_get();
   }
+  else if(!alert && m_pending)
+  {
+    // Result of conversion started by ruuvi_interface_tmp117_measure_start.
+    m_temperature = tmp117_read();
+    m_timestamp = (RUUVI_DRIVER_UINT64_INVALID == m_tstart) ? m_tstart :
+                  m_tstart + ms_per_sample;
+    m_pending = false;
+  }
 
   if(RUUVI_DRIVER_SUCCESS == err_code && RUUVI_DRIVER_UINT64_INVALID != m_timestamp)
   {
@@ -606,5 +676,55 @@ ruuvi_driver_status_t ruuvi_interface_tmp117_data_get(ruuvi_driver_sensor_data_t
 
   return err_code;
 }
+
+ruuvi_driver_status_t ruuvi_interface_tmp117_measure_start(uint32_t* const conversion_us)
+{
+  if(NULL == conversion_us) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(!m_address || m_continuous) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  ruuvi_driver_status_t err_code = tmp117_sample();
+  *conversion_us = ms_per_sample * 1000U;
+  m_tstart = ruuvi_driver_sensor_timestamp_get();
+  m_pending = true;
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_tmp117_alert_use(const bool enable,
+    const ruuvi_interface_gpio_id_t pin,
+    const ruuvi_interface_tmp117_data_ready_fp_t handler)
+{
+  if(!m_address) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+
+  if(RUUVI_INTERFACE_GPIO_ID_UNUSED != m_alert_pin.pin)
+  {
+    err_code |= ruuvi_interface_gpio_interrupt_disable(m_alert_pin);
+    m_alert_pin.pin = RUUVI_INTERFACE_GPIO_ID_UNUSED;
+  }
+
+  if(enable)
+  {
+    if(RUUVI_INTERFACE_GPIO_ID_UNUSED == pin.pin) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+    err_code |= tmp117_alert_configure(true);
+    err_code |= ruuvi_interface_gpio_interrupt_enable(pin, RUUVI_INTERFACE_GPIO_SLOPE_HITOLO,
+                RUUVI_INTERFACE_GPIO_MODE_INPUT_PULLUP, tmp117_alert_isr);
+
+    if(RUUVI_DRIVER_SUCCESS == err_code)
+    {
+      m_alert_pin = pin;
+      m_on_data = handler;
+    }
+  }
+  else
+  {
+    err_code |= tmp117_alert_configure(false);
+    m_on_data = NULL;
+  }
+
+  return err_code;
+}
 /*@}*/
 #endif
\ No newline at end of file
@@ -8,7 +8,8 @@
  * @defgroup TMP117 TMP117 Interface
  * @brief Implement @ref ruuvi_driver_sensor_t functions on TMP117
  *
- * The implementation supports taking single-samples and a continuous mode
+ * The implementation supports taking single-samples and a continuous mode.
+ * Completed conversions can be signalled on ALERT pin in data-ready mode.
  */
 /*@}*/
 /**
@@ -39,6 +40,11 @@ ADDRESS TYPE RESET ACRONYM       REGISTER NAME
 0Fh     R    0117h Device_ID     Device ID register
 */
 
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_sensor.h"
+#include "ruuvi_interface_gpio.h"
+#include <stdbool.h>
+
 #define TMP117_REG_TEMP_RESULT   0x00
 #define TMP117_REG_CONFIGURATION 0x01
 #define TMP117_REG_THIGH_LIMIT   0x02
@@ -51,8 +57,11 @@ ADDRESS TYPE RESET ACRONYM       REGISTER NAME
 #define TMP117_REG_DEVICE_ID     0x0F
 
 #define TMP117_MASK_RESET        0x0002
+#define TMP117_MASK_DR_ALERT     0x0004
+#define TMP117_MASK_POL          0x0008
+#define TMP117_MASK_DATA_READY   0x2000
 #define TMP117_MASK_ID           0x01FF
-#define TMP117_MASK_OS           0x0030
+#define TMP117_MASK_OS           0x0060
 #define TMP117_MASK_MODE         0x0C00
 #define TMP117_MASK_CC           0x0380
 
@@ -110,5 +119,50 @@ ruuvi_driver_status_t ruuvi_interface_tmp117_mode_get(uint8_t*);
 /** @brief @ref ruuvi_driver_sensor_data_fp */
 ruuvi_driver_status_t ruuvi_interface_tmp117_data_get(ruuvi_driver_sensor_data_t* const
     data);
+
+/**
+ * @brief Start a single conversion without waiting for it.
+ *
+ * Data can be read with @ref ruuvi_interface_tmp117_data_get after conversion time,
+ * or after data-ready handler if ALERT pin is in use. Conforms to @ref ruuvi_interface_environmental_measure_start_fp.
+ *
+ * @param[out] conversion_us Conversion time with current averaging.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if conversion_us is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if sensor is not initialized or is in
+ *         continuous mode.
+ */
+ruuvi_driver_status_t ruuvi_interface_tmp117_measure_start(uint32_t* const conversion_us);
+
+/**
+ * @brief Function called with new sample after data-ready interrupt.
+ *
+ * Called in scheduler context.
+ *
+ * @param[in] data Temperature sample, timestamped at the interrupt.
+ */
+typedef void (*ruuvi_interface_tmp117_data_ready_fp_t)(const ruuvi_driver_sensor_data_t*
+    const data);
+
+/**
+ * @brief Use ALERT pin of TMP117 as data-ready interrupt.
+ *
+ * Completed conversions are read in scheduler context and @ref ruuvi_interface_tmp117_data_get
+ * returns latest read sample without bus access. Setting mode to
+ * @ref RUUVI_DRIVER_SENSOR_CFG_SINGLE returns immediately, sample is available after
+ * handler has been called.
+ *
+ * GPIO interrupts and scheduler must be initialized.
+ *
+ * @param[in] enable True to use ALERT pin as data-ready signal, false to release the pin.
+ * @param[in] pin GPIO connected to ALERT pin.
+ * @param[in] handler Function to call with new sample, may be NULL.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if sensor or GPIO interrupts are not initialized.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if pin is RUUVI_INTERFACE_GPIO_ID_UNUSED and enable is true.
+ */
+ruuvi_driver_status_t ruuvi_interface_tmp117_alert_use(const bool enable,
+    const ruuvi_interface_gpio_id_t pin,
+    const ruuvi_interface_tmp117_data_ready_fp_t handler);
 /*@}*/
 #endif
\ No newline at end of file
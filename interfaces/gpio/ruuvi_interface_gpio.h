@@ -2,6 +2,8 @@
 #define RUUVI_INTERFACE_GPIO_H
 #include "ruuvi_driver_error.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 /**
  * @defgroup GPIO GPIO functions
  * @brief Functions for digitally reading and actuating GPIO pins.
@@ -64,6 +66,18 @@ typedef union
   ruuvi_interface_gpio_port_pin_t port_pin; //!< Explicit port + pin
 } ruuvi_interface_gpio_id_t;
 
+/**
+ * @brief Set of pins on one port.
+ *
+ * Resolve once with @ref ruuvi_interface_gpio_port_mask_get and reuse, port
+ * operations then access all pins of the set with a single register write.
+ */
+typedef struct
+{
+  uint32_t mask; //!< Bit n is set for pin n of port.
+  uint8_t  port; //!< Port of the pins.
+} ruuvi_interface_gpio_port_mask_t;
+
 /**
  * @brief Initializes GPIO module. Call this before other GPIO functions.
  * After initialization all GPIO pins shall be in High-Z mode.
@@ -144,5 +158,88 @@ ruuvi_driver_status_t ruuvi_interface_gpio_write(const ruuvi_interface_gpio_id_t
  */
 ruuvi_driver_status_t ruuvi_interface_gpio_read(const ruuvi_interface_gpio_id_t pin,
     ruuvi_interface_gpio_state_t* const p_state);
+
+/**
+ * @brief Resolve pins into a port mask.
+ *
+ * Pins which are @ref RUUVI_INTERFACE_GPIO_ID_UNUSED are skipped.
+ *
+ * @param[in]  pins Pins to include.
+ * @param[in]  count Number of pins.
+ * @param[out] mask Mask of pins.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if pins or mask is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if pins are on different ports or a pin
+ *         does not exist.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_port_mask_get(const ruuvi_interface_gpio_id_t*
+    const pins, const size_t count, ruuvi_interface_gpio_port_mask_t* const mask);
+
+/**
+ * @brief Configure all pins of a mask into a mode.
+ *
+ * @param[in] mask Pins to configure.
+ * @param[in] mode Mode to set the pins to.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if port or mode is invalid.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_port_configure(const
+    ruuvi_interface_gpio_port_mask_t mask, const ruuvi_interface_gpio_mode_t mode);
+
+/**
+ * @brief Set all pins of a mask high at once. Other pins of port are not affected.
+ *
+ * @param[in] mask Pins to set.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if port is invalid.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_port_set(const ruuvi_interface_gpio_port_mask_t
+    mask);
+
+/**
+ * @brief Set all pins of a mask low at once. Other pins of port are not affected.
+ *
+ * @param[in] mask Pins to clear.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if port is invalid.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_port_clear(const
+    ruuvi_interface_gpio_port_mask_t mask);
+
+/**
+ * @brief Toggle all pins of a mask at once. Other pins of port are not affected.
+ *
+ * @param[in] mask Pins to toggle.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if port is invalid.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_port_toggle(const
+    ruuvi_interface_gpio_port_mask_t mask);
+
+/**
+ * @brief Write pins of a mask at once, some high and some low.
+ *
+ * All pins of mask change state simultaneously, i.e. one power domain can be
+ * switched off while another is switched on. Other pins of port are not affected.
+ *
+ * @param[in] mask Pins to write.
+ * @param[in] value Bit n is state of pin n of port, bits outside mask are ignored.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if port is invalid.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_port_write(const
+    ruuvi_interface_gpio_port_mask_t mask, const uint32_t value);
+
+/**
+ * @brief Read pins of a mask at once.
+ *
+ * @param[in]  mask Pins to read.
+ * @param[out] value Bit n is state of pin n of port, bits outside mask are 0.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if value is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if port is invalid.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_port_read(const
+    ruuvi_interface_gpio_port_mask_t mask, uint32_t* const value);
 /*@}*/
 #endif
\ No newline at end of file
@@ -38,6 +38,32 @@ typedef struct
 
 typedef void(*ruuvi_interface_gpio_interrupt_fp_t)(const ruuvi_interface_gpio_evt_t);
 
+/**
+ * @brief Context in which interrupt handler of a pin is called.
+ */
+typedef enum
+{
+  RUUVI_INTERFACE_GPIO_INTERRUPT_DISPATCH_IMMEDIATE, //!< Handler is called in interrupt context.
+  RUUVI_INTERFACE_GPIO_INTERRUPT_DISPATCH_DEFERRED,  //!< Handler is called in scheduler, once per edge.
+  RUUVI_INTERFACE_GPIO_INTERRUPT_DISPATCH_COALESCED  //!< Handler is called in scheduler, edges until handler runs are merged.
+} ruuvi_interface_gpio_interrupt_dispatch_t;
+
+/**
+ * @brief Counters of GPIO interrupts.
+ *
+ * Latency is the time from interrupt to start of deferred handler.
+ */
+typedef struct
+{
+  uint32_t events;          //!< Edges detected on enabled pins.
+  uint32_t deferred;        //!< Handlers called in scheduler.
+  uint32_t coalesced;       //!< Edges merged into an event already waiting for scheduler.
+  uint32_t dropped;         //!< Edges lost on full scheduler queue.
+  uint32_t latency_last_us; //!< Latency of latest deferred handler.
+  uint32_t latency_max_us;  //!< Largest latency of deferred handler.
+  uint64_t latency_sum_us;  //!< Sum of latencies, divide by deferred for average.
+} ruuvi_interface_gpio_interrupt_stats_t;
+
 /**
  * @brief Initialize interrupt functionality to GPIO.
  * Takes address of interrupt table as a pointer to avoid tying driver into a specific board with a specific number of GPIO
@@ -76,6 +102,10 @@ bool ruuvi_interface_gpio_interrupt_is_init(void);
  *
  * Underlying implementation is allowed to use same interrupt channel for all pin interrupts, i.e.
  * simultaneous interrupts might get detected as one and the priority of interrupts is undefined.
+ * Implementation should prefer low-power level sensing over high-accuracy edge detection,
+ * pulses shorter than interrupt latency may be missed.
+ * Handler is called in interrupt context unless selected otherwise with
+ * @ref ruuvi_interface_gpio_interrupt_dispatch_set.
  *
  * - Return RUUVI_DRIVER_ERROR_INVALID_STATE if GPIO or GPIO_INTERRUPT are not initialized
  * - Interrupt function shall be called exactly once when input is configured as low-to-high while input is low and
@@ -102,6 +132,48 @@ ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_enable(const
     const ruuvi_interface_gpio_mode_t mode,
     const ruuvi_interface_gpio_interrupt_fp_t handler);
 
+/**
+ * @brief Select context in which handler of a pin is called.
+ *
+ * Deferred handlers are called from scheduler, which keeps interrupt short and
+ * allows handler to use blocking drivers. Coalesced dispatch keeps at most one event
+ * of a pin waiting for scheduler, edges until the handler runs only increment
+ * @ref ruuvi_interface_gpio_interrupt_stats_t coalesced. Event carries the slope of the
+ * first edge, read the pin in handler for the current state.
+ *
+ * Dispatch is kept until interrupt of the pin is disabled, after which pin is
+ * dispatched immediately. Can be called before or after
+ * @ref ruuvi_interface_gpio_interrupt_enable. Deferred event takes 12 bytes of
+ * scheduler event data, nRF5 SDK15 build fails if scheduler event size is smaller.
+ *
+ * @param[in] pin Interrupt pin.
+ * @param[in] dispatch Context of handler.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if GPIO interrupts are not initialized.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if pin is outside interrupt table or
+ *         dispatch is unknown.
+ * @return RUUVI_DRIVER_ERROR_NOT_SUPPORTED if deferred dispatch is requested without
+ *         scheduler.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_dispatch_set(
+  const ruuvi_interface_gpio_id_t pin,
+  const ruuvi_interface_gpio_interrupt_dispatch_t dispatch);
+
+/**
+ * @brief Get counters of GPIO interrupts.
+ *
+ * @param[out] stats Counters since initialization or reset.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if stats is NULL.
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_stats_get(
+  ruuvi_interface_gpio_interrupt_stats_t* const stats);
+
+/**
+ * @brief Clear counters of GPIO interrupts.
+ */
+void ruuvi_interface_gpio_interrupt_stats_reset(void);
+
 /**
  * @brief Disable interrupt on a pin.
  *
@@ -184,4 +184,63 @@ ruuvi_driver_status_t ruuvi_interface_gpio_test_toggle(const ruuvi_interface_gpi
   ruuvi_driver_test_register(true);
   return RUUVI_DRIVER_SUCCESS;
 }
+
+ruuvi_driver_status_t ruuvi_interface_gpio_test_port(const ruuvi_interface_gpio_id_t
+    input,
+    const ruuvi_interface_gpio_id_t output)
+{
+  if(input.port_pin.port != output.port_pin.port) { return RUUVI_DRIVER_SUCCESS; }
+
+  ruuvi_driver_status_t status = RUUVI_DRIVER_SUCCESS;
+  ruuvi_interface_gpio_port_mask_t in_mask;
+  ruuvi_interface_gpio_port_mask_t out_mask;
+  uint32_t value = 0;
+  bool pass = true;
+  // - Mask of pins on different ports must return RUUVI_DRIVER_ERROR_INVALID_PARAM.
+  ruuvi_interface_gpio_id_t pins[2] = {input, input};
+  pins[1].port_pin.port++;
+
+  if(RUUVI_DRIVER_ERROR_INVALID_PARAM != ruuvi_interface_gpio_port_mask_get(pins, 2,
+      &in_mask))
+  {
+    pass = false;
+  }
+
+  status |= ruuvi_interface_gpio_init();
+  status |= ruuvi_interface_gpio_port_mask_get(&input, 1, &in_mask);
+  status |= ruuvi_interface_gpio_port_mask_get(&output, 1, &out_mask);
+  status |= ruuvi_interface_gpio_configure(input, RUUVI_INTERFACE_GPIO_MODE_INPUT_NOPULL);
+  status |= ruuvi_interface_gpio_port_configure(out_mask,
+            RUUVI_INTERFACE_GPIO_MODE_OUTPUT_STANDARD);
+  // - Input must read as HIGH after output mask is set and LOW after it is cleared.
+  status |= ruuvi_interface_gpio_port_set(out_mask);
+  status |= ruuvi_interface_gpio_port_read(in_mask, &value);
+  pass = pass && (in_mask.mask == value);
+  status |= ruuvi_interface_gpio_port_clear(out_mask);
+  status |= ruuvi_interface_gpio_port_read(in_mask, &value);
+  pass = pass && (0 == value);
+  // - Input must read as HIGH after output mask is toggled from LOW.
+  status |= ruuvi_interface_gpio_port_toggle(out_mask);
+  status |= ruuvi_interface_gpio_port_read(in_mask, &value);
+  pass = pass && (in_mask.mask == value);
+  // - Input must follow the output bit written with port write.
+  status |= ruuvi_interface_gpio_port_write(out_mask, ~out_mask.mask);
+  status |= ruuvi_interface_gpio_port_read(in_mask, &value);
+  pass = pass && (0 == value);
+  status |= ruuvi_interface_gpio_port_write(out_mask, out_mask.mask);
+  // - Port read must not return bits outside mask.
+  status |= ruuvi_interface_gpio_port_read(in_mask, &value);
+  pass = pass && (in_mask.mask == value);
+  status |= ruuvi_interface_gpio_uninit();
+
+  if(RUUVI_DRIVER_SUCCESS != status || !pass)
+  {
+    RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+    ruuvi_driver_test_register(false);
+    return RUUVI_DRIVER_ERROR_SELFTEST;
+  }
+
+  ruuvi_driver_test_register(true);
+  return RUUVI_DRIVER_SUCCESS;
+}
 #endif
\ No newline at end of file
@@ -65,5 +65,25 @@ ruuvi_driver_status_t ruuvi_interface_gpio_test_toggle(const ruuvi_interface_gpi
     input,
     const ruuvi_interface_gpio_id_t output);
 
+/**
+ * @brief Test port mask operations.
+ *
+ * Input is in High-Z mode. Test is skipped if pins are on different ports.
+ *
+ * - Mask of pins on different ports must return RUUVI_DRIVER_ERROR_INVALID_PARAM.
+ * - Input must read as HIGH after output mask is set and LOW after it is cleared.
+ * - Input must read as HIGH after output mask is toggled from LOW.
+ * - Input must follow the output bit written with port write.
+ * - Port read must not return bits outside mask.
+ *
+ * @param input[in]  Pin used to check the state of output pin.
+ * @param output[in] Pin being written through port.
+ *
+ * @return @c RUUVI_DRIVER_SUCCESS if all tests pass, error code on failure
+ */
+ruuvi_driver_status_t ruuvi_interface_gpio_test_port(const ruuvi_interface_gpio_id_t
+    input,
+    const ruuvi_interface_gpio_id_t output);
+
 /*@}*/
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef RUUVI_INTERFACE_I2C_H
 #define RUUVI_INTERFACE_I2C_H
 #include "ruuvi_driver_error.h"
+#include "ruuvi_interface_bus_stats.h"
 #include "ruuvi_interface_gpio.h"
 #include <stdbool.h>
 #include <stddef.h>
@@ -42,6 +43,58 @@ typedef struct
   frequency; //!< Frequency of I2C Bus, see @ref ruuvi_interface_i2c_frequency_t
 } ruuvi_interface_i2c_init_config_t;
 
+/** @brief Maximum number of jobs waiting for the bus. */
+#ifndef RUUVI_INTERFACE_I2C_QUEUE_SIZE
+  #define RUUVI_INTERFACE_I2C_QUEUE_SIZE 8
+#endif
+
+/** @brief Direction of transaction segment. */
+typedef enum
+{
+  RUUVI_INTERFACE_I2C_SEGMENT_WRITE, //!< Write data to device.
+  RUUVI_INTERFACE_I2C_SEGMENT_READ   //!< Read data from device.
+} ruuvi_interface_i2c_direction_t;
+
+/** @brief One write or read of a transaction. */
+typedef struct
+{
+  ruuvi_interface_i2c_direction_t direction; //!< Write or read.
+  uint8_t* data;                             //!< Data to write or buffer to read into.
+  size_t length;                             //!< Number of bytes, at most 255.
+} ruuvi_interface_i2c_segment_t;
+
+typedef struct ruuvi_interface_i2c_job_t ruuvi_interface_i2c_job_t;
+
+/**
+ * @brief Function called when job is complete. Called in interrupt context.
+ *
+ * Next job is already running when function is called, job may be scheduled again.
+ *
+ * @param[in] job Completed job.
+ * @param[in] status RUUVI_DRIVER_SUCCESS if all segments were transferred,
+ *                   error code of the failed segment otherwise.
+ */
+typedef void(*ruuvi_interface_i2c_job_fp_t)(ruuvi_interface_i2c_job_t* const job,
+    const ruuvi_driver_status_t status);
+
+/**
+ * @brief I2C transaction to one device.
+ *
+ * Segments are transferred back to back. Write followed by write or read continues
+ * with a repeated start, STOP is generated after the last segment.
+ * Write followed by read is one transfer in hardware with a single interrupt.
+ * Job, segments and data are owned by the I2C driver until callback is called.
+ */
+struct ruuvi_interface_i2c_job_t
+{
+  uint8_t address;                                //!< 7-bit address, without R/W bit.
+  const ruuvi_interface_i2c_segment_t* segments;  //!< Segments to transfer.
+  size_t segment_count;                           //!< Number of segments.
+  bool no_stop;                                   //!< Hold bus after last write.
+  ruuvi_interface_i2c_job_fp_t callback;          //!< Called on completion, may be NULL.
+  void* p_context;                                //!< Passed on to callback in job.
+};
+
 /**
  * @brief Initialize I2C driver with given settings
  *
@@ -58,10 +111,26 @@ ruuvi_driver_status_t ruuvi_interface_i2c_init(const ruuvi_interface_i2c_init_co
  **/
 bool ruuvi_interface_i2c_is_init();
 
+/**
+ * @brief Queue a job to run on the bus.
+ *
+ * Jobs are run in order of scheduling by EasyDMA without CPU involvement between bytes.
+ * Safe to call from interrupt context.
+ *
+ * @param[in] job Job to run.
+ * @return RUUVI_DRIVER_SUCCESS if job was queued.
+ * @return RUUVI_DRIVER_ERROR_NULL if job or segments is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if job has no segments.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if I2C is not initialized.
+ * @return RUUVI_DRIVER_ERROR_NO_MEM if queue is full.
+ **/
+ruuvi_driver_status_t ruuvi_interface_i2c_job_schedule(ruuvi_interface_i2c_job_t* const
+    job);
+
 /**
  * @brief I2C read function.
  *
- * Function is blocking and will not sleep while transaction is ongoing.
+ * Function is blocking and yields while transaction is ongoing.
  *
  * @param[in] address 7-bit I2C address of the device, without R/W bit.
  * @param[out] p_rx pointer to data to be received
@@ -71,9 +140,9 @@ ruuvi_driver_status_t ruuvi_interface_i2c_read_blocking(const uint8_t address,
     uint8_t* const p_rx, const size_t rx_len);
 
 /**
- * @brief I2C read function.
+ * @brief I2C write function.
  *
- * Function is blocking and will not sleep while transaction is ongoing.
+ * Function is blocking and yields while transaction is ongoing.
  *
  * @param[in] address 7-bit I2C address of the device, without R/W bit.
  * @param[out] p_tx pointer to data to be transmitted
@@ -82,5 +151,34 @@ ruuvi_driver_status_t ruuvi_interface_i2c_read_blocking(const uint8_t address,
  **/
 ruuvi_driver_status_t ruuvi_interface_i2c_write_blocking(const uint8_t address,
     uint8_t* const p_tx, const size_t tx_len, const bool stop);
+
+/**
+ * @brief I2C write followed by read with repeated start.
+ *
+ * Typically writes register address and reads register contents in one transaction.
+ * Function is blocking and yields while transaction is ongoing.
+ *
+ * @param[in] address 7-bit I2C address of the device, without R/W bit.
+ * @param[in] p_tx pointer to data to be transmitted
+ * @param[in] tx_len length of data to be transmitted
+ * @param[out] p_rx pointer to data to be received
+ * @param[in] rx_len length of data to be received
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if either pointer is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if I2C is not initialized.
+ * @return error code from stack on error.
+ **/
+ruuvi_driver_status_t ruuvi_interface_i2c_write_read(const uint8_t address,
+    uint8_t* const p_tx, const size_t tx_len, uint8_t* const p_rx, const size_t rx_len);
+
+/**
+ * @brief Get statistics of devices on I2C bus, keyed by 7-bit address.
+ *
+ * Every job is recorded on completion with bytes of all segments and time from
+ * start of first segment. Jobs rejected on full queue are counted as busy.
+ *
+ * @return Statistics table, NULL if RUUVI_INTERFACE_BUS_STATS_ENABLED is not set.
+ */
+ruuvi_interface_bus_stats_table_t* ruuvi_interface_i2c_stats_get(void);
 /* @} */
 #endif
\ No newline at end of file
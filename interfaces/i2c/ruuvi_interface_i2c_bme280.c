@@ -57,8 +57,8 @@ int8_t ruuvi_interface_i2c_bme280_write(uint8_t dev_id, uint8_t reg_addr,
  * |------------+---------------------|
  * | Start      | -                   |
  * | Write      | (reg_addr)          |
- * | Stop       | -                   |
- * | Start      | -                   |
+ * | Repeated   | -                   |
+ * | start      |                     |
  * | Read       | (reg_data[0])       |
  * | Read       | (....)              |
  * | Read       | (reg_data[len - 1]) |
@@ -70,8 +70,7 @@ int8_t ruuvi_interface_i2c_bme280_read(uint8_t dev_id, uint8_t reg_addr,
                                        uint8_t* reg_data, uint16_t len)
 {
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
-  err_code |= ruuvi_interface_i2c_write_blocking(dev_id, &reg_addr, 1, true);
-  err_code |= ruuvi_interface_i2c_read_blocking(dev_id, reg_data, len);
+  err_code |= ruuvi_interface_i2c_write_read(dev_id, &reg_addr, 1, reg_data, len);
   return (RUUVI_DRIVER_SUCCESS == err_code) ? 0 : -1;
 }
 #endif
\ No newline at end of file
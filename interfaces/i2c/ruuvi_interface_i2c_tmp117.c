@@ -11,7 +11,7 @@
  *
  */
 #include "ruuvi_driver_enabled_modules.h"
-#if RUUVI_INTERFACE_ENVIRONMENTAL_SHTCX_ENABLED || DOXYGEN
+#if RUUVI_INTERFACE_ENVIRONMENTAL_TMP117_ENABLED || DOXYGEN
 #include "ruuvi_driver_error.h"
 #include "ruuvi_interface_i2c.h"
 #include "ruuvi_interface_i2c_tmp117.h"
@@ -33,8 +33,8 @@ ruuvi_driver_status_t ruuvi_interface_i2c_tmp117_read(const uint8_t dev_id,
   ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
   uint8_t command[3] = {0};
   command[0] = reg_addr;
-  err_code |= ruuvi_interface_i2c_write_blocking(dev_id, command, 1, false);
-  err_code |= ruuvi_interface_i2c_read_blocking(dev_id, &(command[1]), sizeof(command));
+  err_code |= ruuvi_interface_i2c_write_read(dev_id, command, 1, &(command[1]),
+              sizeof(command) - 1);
   *reg_val = (command[1] << 8) + command[2];
   return err_code;
 }
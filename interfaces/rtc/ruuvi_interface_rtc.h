@@ -17,6 +17,7 @@
 #ifndef RUUVI_INTERFACE_RTC_H
 #define RUUVI_INTERFACE_RTC_H
 #include "ruuvi_driver_error.h"
+#include <stdint.h>
 
 /**
  * @brief Initializes RTC at 0 ms.
@@ -35,11 +36,42 @@ ruuvi_driver_status_t ruuvi_interface_rtc_uninit(void);
 /**
  * @brief Get milliseconds since init.
  *
+ * Safe to call from interrupts and with interrupts disabled.
+ *
  * @return number of milliseconds since RTC init.
  * @return @c RUUVI_DRIVER_UINT64_INVALID if RTC is not running
   **/
 uint64_t ruuvi_interface_rtc_millis(void);
 
+/**
+ * @brief Get microseconds since init.
+ *
+ * Resolution is one RTC tick, see @ref ruuvi_interface_rtc_ticks_per_second.
+ * Safe to call from interrupts and with interrupts disabled.
+ *
+ * @return number of microseconds since RTC init.
+ * @return @c RUUVI_DRIVER_UINT64_INVALID if RTC is not running
+ **/
+uint64_t ruuvi_interface_rtc_micros(void);
+
+/**
+ * @brief Get RTC ticks since init.
+ *
+ * Cheapest timestamp, convert differences of ticks with
+ * @ref ruuvi_interface_rtc_ticks_per_second.
+ *
+ * @return number of ticks since RTC init.
+ * @return @c RUUVI_DRIVER_UINT64_INVALID if RTC is not running
+ **/
+uint64_t ruuvi_interface_rtc_ticks(void);
+
+/**
+ * @brief Get frequency of RTC ticks.
+ *
+ * @return number of ticks in a second.
+ **/
+uint32_t ruuvi_interface_rtc_ticks_per_second(void);
+
 /*@}*/
 
 #endif
\ No newline at end of file
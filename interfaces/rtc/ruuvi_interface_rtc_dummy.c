@@ -70,4 +70,34 @@ uint64_t ruuvi_interface_rtc_millis(void)
   return m_dummy++;
 }
 
+/**
+ * @brief Get microseconds since init, resolution of dummy counter is 1 ms.
+ *
+ * @return number of microseconds since RTC init.
+ **/
+uint64_t ruuvi_interface_rtc_micros(void)
+{
+  return ruuvi_interface_rtc_millis() * 1000;
+}
+
+/**
+ * @brief Get ticks since init, ticks of dummy counter are milliseconds.
+ *
+ * @return number of ticks since RTC init.
+ **/
+uint64_t ruuvi_interface_rtc_ticks(void)
+{
+  return ruuvi_interface_rtc_millis();
+}
+
+/**
+ * @brief Get frequency of RTC ticks.
+ *
+ * @return 1000.
+ **/
+uint32_t ruuvi_interface_rtc_ticks_per_second(void)
+{
+  return 1000U;
+}
+
 #endif
\ No newline at end of file
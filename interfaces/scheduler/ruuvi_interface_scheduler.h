@@ -11,6 +11,7 @@
 #define RUUVI_INTERFACE_SCHEDULER_H
 
 #include "ruuvi_driver_error.h"
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -49,6 +50,21 @@ ruuvi_driver_status_t ruuvi_interface_scheduler_execute(void);
 ruuvi_driver_status_t ruuvi_interface_scheduler_event_put(const void* const p_event_data,
     const uint16_t event_size, const ruuvi_scheduler_event_handler_t handler);
 
+/**
+ * Check if there are no scheduled tasks. Safe to call from interrupt context.
+ *
+ * Returns true if queue is empty or scheduler is not initialized, false otherwise.
+ */
+bool ruuvi_interface_scheduler_is_empty(void);
+
+/**
+ * Check if a scheduled task is running. Tasks queued meanwhile, including the running
+ * task itself, are executed only after the running task returns.
+ *
+ * Returns true if called from a task executed by ruuvi_interface_scheduler_execute.
+ */
+bool ruuvi_interface_scheduler_is_executing(void);
+
 
 
 #endif
\ No newline at end of file
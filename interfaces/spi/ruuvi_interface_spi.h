@@ -1,6 +1,7 @@
 #ifndef RUUVI_INTERFACE_SPI_H
 #define RUUVI_INTERFACE_SPI_H
 #include "ruuvi_driver_error.h"
+#include "ruuvi_interface_bus_stats.h"
 #include "ruuvi_interface_gpio.h"
 #include <stdbool.h>
 #include <stddef.h>
@@ -60,6 +61,50 @@ typedef struct
   mode;           //!< Mode of SPI Bus, see @ref ruuvi_interface_spi_mode_t
 } ruuvi_interface_spi_init_config_t;
 
+/** @brief Maximum number of jobs waiting for the bus. */
+#ifndef RUUVI_INTERFACE_SPI_QUEUE_SIZE
+  #define RUUVI_INTERFACE_SPI_QUEUE_SIZE 8
+#endif
+
+/** @brief Bus settings of one device. */
+typedef struct
+{
+  ruuvi_interface_gpio_id_t ss;              //!< Slave select pin, active low.
+  ruuvi_interface_spi_mode_t mode;           //!< Clock polarity and phase of device.
+  ruuvi_interface_spi_frequency_t frequency; //!< Clock speed of device.
+} ruuvi_interface_spi_device_t;
+
+typedef struct ruuvi_interface_spi_job_t ruuvi_interface_spi_job_t;
+
+/**
+ * @brief Function called when job is complete. Called in interrupt context.
+ *
+ * Next job is already running when function is called, job may be scheduled again.
+ *
+ * @param[in] job Completed job.
+ * @param[in] status RUUVI_DRIVER_SUCCESS on success, error code otherwise.
+ */
+typedef void(*ruuvi_interface_spi_job_fp_t)(ruuvi_interface_spi_job_t* const job,
+    const ruuvi_driver_status_t status);
+
+/**
+ * @brief One transfer to a device, framed by slave select.
+ *
+ * Full-duplex like @ref ruuvi_interface_spi_xfer_blocking. Job, device and buffers
+ * are owned by the SPI driver until callback is called.
+ */
+struct ruuvi_interface_spi_job_t
+{
+  const ruuvi_interface_spi_device_t* device; //!< Device to transfer with.
+  const uint8_t* p_tx;                        //!< Data to send, NULL if tx_len is 0.
+  size_t tx_len;                              //!< Length of data to send.
+  uint8_t* p_rx;                              //!< Buffer to receive, NULL if rx_len is 0.
+  size_t rx_len;                              //!< Length of data to receive.
+  uint8_t priority;                           //!< Jobs with higher priority run first.
+  ruuvi_interface_spi_job_fp_t callback;      //!< Called on completion, may be NULL.
+  void* p_context;                            //!< Passed on to callback in job.
+};
+
 /**
  * @brief Initialize SPI driver with given settings
  *
@@ -98,15 +143,97 @@ ruuvi_driver_status_t ruuvi_interface_spi_uninit();
  * length transactions, tx will clock out @c 0xFF if there is
  * less bytes in TX than RX. Does not use slave select pins.
  * RX will start at the same time as TX, i.e. one byte address + read commands will generally have
- * {0x00, data} in rx buffer. Function is blocking and will not sleep while transaction is ongoing.
+ * {0x00, data} in rx buffer. Function is blocking and yields while transaction is ongoing.
+ * Slave select is controlled by caller, do not mix with jobs to other devices.
  *
  * @param p_tx pointer to data to be sent, can be NULL if tx_len is 0.
  * @param tx_len length of data to be sent
  * @param p_rx pointer to data to be received, can be NULL if rx_len is 0.
  * @param rx_len length of data to be received
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if a buffer is NULL with non-zero length.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if SPI is not initialized or caller runs
+ *         at or above priority of SPI interrupt, or with interrupts disabled.
+ * @return RUUVI_DRIVER_ERROR_TIMEOUT if transfer did not complete.
  * @warning First byte in RX is generally @c 0x00 if you're reading external sensor.
  **/
 ruuvi_driver_status_t ruuvi_interface_spi_xfer_blocking(const uint8_t* const p_tx,
     const size_t tx_len, uint8_t* const p_rx, const size_t rx_len);
+
+/**
+ * @brief Queue a job to run on the bus.
+ *
+ * Running job is always completed, after that the pending job with highest priority
+ * runs next, jobs of equal priority run in order of scheduling. A sequence of jobs
+ * from a lower priority source is therefore preempted at job boundaries.
+ * Bus is reconfigured to mode and frequency of device if needed.
+ * Safe to call from interrupt context.
+ *
+ * @param[in] job Job to run.
+ * @return RUUVI_DRIVER_SUCCESS if job was queued.
+ * @return RUUVI_DRIVER_ERROR_NULL if job or device is NULL or buffer is NULL
+ *         with non-zero length.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if SPI is not initialized.
+ * @return RUUVI_DRIVER_ERROR_NO_MEM if queue is full.
+ **/
+ruuvi_driver_status_t ruuvi_interface_spi_job_schedule(ruuvi_interface_spi_job_t* const
+    job);
+
+/** @brief Maximum payload of register transfer, one DMA transfer including command. */
+#define RUUVI_INTERFACE_SPI_REGISTER_MAX_LEN 254
+
+/**
+ * @brief Read registers of a device in one transfer.
+ *
+ * Selects device, clocks out command byte and clocks in payload in a single DMA
+ * transaction and deselects device. Function is blocking and yields while transaction
+ * is ongoing. Transfer is queued like a job, with bus mode and frequency given at init.
+ *
+ * @param[in] ss Slave select pin of device, active low.
+ * @param[in] command Command byte, i.e. register address with read and increment bits.
+ * @param[out] p_rx Register contents, without the byte clocked in during command.
+ * @param[in] rx_len Number of bytes to read, at most
+ *                   @ref RUUVI_INTERFACE_SPI_REGISTER_MAX_LEN.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if p_rx is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if SPI is not initialized or caller runs
+ *         at or above priority of SPI interrupt, or with interrupts disabled.
+ * @return RUUVI_DRIVER_ERROR_TIMEOUT if transfer did not complete.
+ * @return RUUVI_DRIVER_ERROR_INVALID_LENGTH if rx_len is too large.
+ **/
+ruuvi_driver_status_t ruuvi_interface_spi_register_read(const ruuvi_interface_gpio_id_t ss,
+    const uint8_t command, uint8_t* const p_rx, const size_t rx_len);
+
+/**
+ * @brief Write registers of a device in one transfer.
+ *
+ * Selects device, clocks out command byte and payload in a single DMA
+ * transaction and deselects device. Function is blocking and yields while transaction
+ * is ongoing. Transfer is queued like a job, with bus mode and frequency given at init.
+ *
+ * @param[in] ss Slave select pin of device, active low.
+ * @param[in] command Command byte, i.e. register address with write and increment bits.
+ * @param[in] p_tx Register contents to write.
+ * @param[in] tx_len Number of bytes to write, at most
+ *                   @ref RUUVI_INTERFACE_SPI_REGISTER_MAX_LEN.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if p_tx is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if SPI is not initialized or caller runs
+ *         at or above priority of SPI interrupt, or with interrupts disabled.
+ * @return RUUVI_DRIVER_ERROR_TIMEOUT if transfer did not complete.
+ * @return RUUVI_DRIVER_ERROR_INVALID_LENGTH if tx_len is too large.
+ **/
+ruuvi_driver_status_t ruuvi_interface_spi_register_write(const ruuvi_interface_gpio_id_t ss,
+    const uint8_t command, const uint8_t* const p_tx, const size_t tx_len);
+/**
+ * @brief Get statistics of devices on SPI bus, keyed by slave select pin.
+ *
+ * Every job is recorded on completion with number of bytes clocked and transfer time.
+ * Jobs rejected on full queue are counted as busy. SPI has no acknowledge, NACK
+ * counters stay at zero.
+ *
+ * @return Statistics table, NULL if RUUVI_INTERFACE_BUS_STATS_ENABLED is not set.
+ */
+ruuvi_interface_bus_stats_table_t* ruuvi_interface_spi_stats_get(void);
 /* @} */
 #endif
\ No newline at end of file
@@ -30,10 +30,7 @@ int32_t ruuvi_interface_spi_lis2dh12_write(void* dev_ptr, uint8_t reg_addr,
 
   ruuvi_interface_gpio_id_t ss;
   ss.pin = RUUVI_DRIVER_HANDLE_TO_GPIO(dev_id);
-  err_code |= ruuvi_interface_gpio_write(ss, RUUVI_INTERFACE_GPIO_LOW);
-  err_code |= ruuvi_interface_spi_xfer_blocking(&reg_addr, 1, NULL, 0);
-  err_code |= ruuvi_interface_spi_xfer_blocking(reg_data, len, NULL, 0);
-  err_code |= ruuvi_interface_gpio_write(ss, RUUVI_INTERFACE_GPIO_HIGH);
+  err_code |= ruuvi_interface_spi_register_write(ss, reg_addr, reg_data, len);
   return err_code;
 }
 
@@ -51,10 +48,7 @@ int32_t ruuvi_interface_spi_lis2dh12_read(void* dev_ptr, uint8_t reg_addr,
 
   ruuvi_interface_gpio_id_t ss;
   ss.pin = RUUVI_DRIVER_HANDLE_TO_GPIO(dev_id);
-  err_code |= ruuvi_interface_gpio_write(ss, RUUVI_INTERFACE_GPIO_LOW);
-  err_code |= ruuvi_interface_spi_xfer_blocking(&reg_addr, 1, NULL, 0);
-  err_code |= ruuvi_interface_spi_xfer_blocking(NULL, 0, reg_data, len);
-  err_code |= ruuvi_interface_gpio_write(ss, RUUVI_INTERFACE_GPIO_HIGH);
+  err_code |= ruuvi_interface_spi_register_read(ss, reg_addr, reg_data, len);
   return err_code;
 }
 #endif
\ No newline at end of file
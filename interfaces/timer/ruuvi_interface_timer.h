@@ -9,6 +9,7 @@
 
 #include "ruuvi_driver_error.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef enum
 {
@@ -61,4 +62,80 @@ ruuvi_driver_status_t ruuvi_interface_timer_start(ruuvi_interface_timer_id_t tim
  */
 ruuvi_driver_status_t ruuvi_interface_timer_stop(ruuvi_interface_timer_id_t timer_id);
 
+/**
+ * @brief Stop a timer and return it to the pool.
+ *
+ * Timer id must not be used after deletion, it may be handed out again by
+ * @ref ruuvi_interface_timer_create.
+ *
+ * @param[in] timer_id id of timer to delete.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if timer was not created by this module or
+ *         was already deleted.
+ */
+ruuvi_driver_status_t ruuvi_interface_timer_delete(ruuvi_interface_timer_id_t timer_id);
+
+/**
+ * @brief Soft timer, multiplexed onto a single hardware timer.
+ *
+ * Memory is owned by the caller, any number of soft timers can run at once.
+ * Soft timers are kept in order of deadline and hardware timer is armed only for
+ * the nearest deadline, timers which expire on the same tick are handled in one
+ * interrupt. Fields are private to the timer module.
+ */
+typedef struct ruuvi_interface_timer_soft_t
+{
+  struct ruuvi_interface_timer_soft_t* p_next; //!< Next timer in order of deadline.
+  ruuvi_timer_timeout_handler_t handler;       //!< Function to call on expiry.
+  void* p_context;                             //!< Parameter of handler.
+  uint32_t deadline;                           //!< Expiry time in timer ticks.
+  uint32_t period;                             //!< Interval in ticks, 0 for single shot.
+  bool running;                                //!< True while timer is queued.
+} ruuvi_interface_timer_soft_t;
+
+/**
+ * @brief Start a soft timer.
+ *
+ * Timer is restarted if it is already running. Handler is called in the same context
+ * as handlers of other timers. Repeated timers do not drift, next deadline is counted
+ * from the previous deadline.
+ *
+ * @param[in] timer Timer memory, must stay valid while timer is running.
+ * @param[in] mode Single shot or repeated.
+ * @param[in] ms Timeout or interval in milliseconds, at least 1.
+ * @param[in] handler Function to call on expiry.
+ * @param[in] p_context Parameter of handler.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if timer or handler is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if timers have not been initialized.
+ * @return RUUVI_DRIVER_ERROR_INVALID_PARAM if ms is 0 or too long for timer.
+ * @return RUUVI_DRIVER_ERROR_RESOURCES if hardware timer could not be allocated.
+ */
+ruuvi_driver_status_t ruuvi_interface_timer_soft_start(
+  ruuvi_interface_timer_soft_t* const timer, const ruuvi_interface_timer_mode_t mode,
+  const uint32_t ms, const ruuvi_timer_timeout_handler_t handler, void* const p_context);
+
+/**
+ * @brief Stop a soft timer. Stopping a stopped timer is allowed.
+ *
+ * @param[in] timer Timer to stop.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if timer is NULL.
+ */
+ruuvi_driver_status_t ruuvi_interface_timer_soft_stop(
+  ruuvi_interface_timer_soft_t* const timer);
+
+/**
+ * @brief Get time to the nearest soft timer deadline.
+ *
+ * Used by idle management to know how long the device may sleep.
+ *
+ * @param[out] us Microseconds until nearest deadline, 0 if deadline has passed
+ *                and handler has not run yet.
+ * @return RUUVI_DRIVER_SUCCESS if a soft timer is running.
+ * @return RUUVI_DRIVER_ERROR_NULL if us is NULL.
+ * @return RUUVI_DRIVER_ERROR_NOT_FOUND if no soft timer is running.
+ */
+ruuvi_driver_status_t ruuvi_interface_timer_soft_next_us(uint32_t* const us);
+
 #endif
\ No newline at end of file
@@ -27,7 +27,8 @@
 typedef enum
 {
   RUUVI_INTERFACE_UART_BAUD_9600,   //!< 9600 bauds
-  RUUVI_INTERFACE_UART_BAUD_115200 //!< 2 Mbps
+  RUUVI_INTERFACE_UART_BAUD_115200, //!< 115200 bauds
+  RUUVI_INTERFACE_UART_BAUD_1M      //!< 1 Mbaud, requires flow control to be reliable
 } ruuvi_interface_uart_baud_t;
 
 /**
@@ -44,10 +45,36 @@ typedef struct
   bool hwfc;                        //!< True -> Hardware flow control enabled. False -> disabled.
 } ruuvi_interface_uart_init_config_t;
 
+/** @brief Size of transmit ring, bytes. */
+#ifndef RUUVI_INTERFACE_UART_TX_RING_SIZE
+  #define RUUVI_INTERFACE_UART_TX_RING_SIZE 512
+#endif
+
+/** @brief Size of receive ring, bytes. */
+#ifndef RUUVI_INTERFACE_UART_RX_RING_SIZE
+  #define RUUVI_INTERFACE_UART_RX_RING_SIZE 256
+#endif
+
 /**
- * @brief Callback function for received data.
+ * @brief Callback function for received data. Called in interrupt context.
+ *
+ * Called when a receive buffer fills or line goes idle after data.
+ *
+ * @param[in] available Number of bytes which can be read with
+ *            @ref ruuvi_interface_uart_read.
+ */
+typedef void (*ruuvi_interface_uart_rx_cb_t)(const size_t available);
+
+/**
+ * @brief Callback function for transmitted data. Called in interrupt context.
+ *
+ * Called after each completed DMA transfer.
+ *
+ * @param[in] free Number of bytes which can be queued with
+ *            @ref ruuvi_interface_uart_send. Transmit ring is empty if free equals
+ *            @ref ruuvi_interface_uart_tx_capacity.
  */
-//typedef void (*ruuvi_interface_uart_cb_t)(const uint8_t* const data, const size_t data_length);
+typedef void (*ruuvi_interface_uart_tx_cb_t)(const size_t free);
 
 /**
  * @brief Initialize UART driver with given settings
@@ -82,21 +109,74 @@ ruuvi_driver_status_t ruuvi_interface_uart_uninit();
 
 /**
  * @brief UART write function.
- * Function is blocking and will not sleep while transaction is ongoing.
+ * Function is blocking and sleeps until transaction is complete or timed out.
+ * Data is queued through transmit ring after any data queued before.
  *
- * @param p_tx pointer to data to be sent. Must be in RAM.
+ * @param p_tx pointer to data to be sent.
  * @param tx_len length of data to be sent.
  * @return RUUVI_DRIVER_SUCCSS when data was sent.
  * @return RUUVI_DRIVER_ERROR_NULL if p_tx is NULL.
- * @return RUUVI_DRIVER_ERROR_INVALID_ADDRESS if p_tx is not in RAM
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if UART is not initialized.
+ * @return RUUVI_DRIVER_ERROR_TIMEOUT if transmission did not complete in time.
  * @return error code from stack on other error.
  **/
 ruuvi_driver_status_t ruuvi_interface_uart_send_blocking(const uint8_t* const p_tx,
     const size_t tx_len);
 
+/**
+ * @brief Queue data for transmission and return.
+ *
+ * Data is copied into transmit ring, which is drained by chained DMA transfers.
+ * Either all of data is queued or none of it. Safe to call from interrupt context.
+ *
+ * @param[in] p_tx Data to send.
+ * @param[in] tx_len Length of data.
+ * @return RUUVI_DRIVER_SUCCESS if data was queued.
+ * @return RUUVI_DRIVER_ERROR_NULL if p_tx is NULL.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if UART is not initialized.
+ * @return RUUVI_DRIVER_ERROR_NO_MEM if there is not enough room in transmit ring.
+ **/
+ruuvi_driver_status_t ruuvi_interface_uart_send(const uint8_t* const p_tx,
+    const size_t tx_len);
+
+/**
+ * @brief Get free space in transmit ring.
+ *
+ * @return Number of bytes which can be queued.
+ */
+size_t ruuvi_interface_uart_tx_free(void);
+
+/**
+ * @brief Get total space of transmit ring.
+ *
+ * @return Number of bytes which can be queued into empty ring.
+ */
+size_t ruuvi_interface_uart_tx_capacity(void);
+
+/**
+ * @brief Read received data from receive ring.
+ *
+ * Reception runs continuously from initialization. If the ring is full, newly
+ * received bytes are dropped.
+ *
+ * @param[out] p_rx Buffer for data.
+ * @param[in] max_len Size of buffer.
+ * @return Number of bytes read, 0 if there is no data or p_rx is NULL.
+ */
+size_t ruuvi_interface_uart_read(uint8_t* const p_rx, const size_t max_len);
+
 /**
  * @brief Configure a callback to be called once data is received.
+ *
+ * @param[in] cb Callback, NULL to disable.
+ */
+void ruuvi_interface_uart_rx_cb_set(const ruuvi_interface_uart_rx_cb_t cb);
+
+/**
+ * @brief Configure a callback to be called once data is transmitted.
+ *
+ * @param[in] cb Callback, NULL to disable.
  */
-//void ruuvi_interface_uart_rx_cb_set(const ruuvi_interface_uart_cb_t cb);
+void ruuvi_interface_uart_tx_cb_set(const ruuvi_interface_uart_tx_cb_t cb);
 /* @} */
 #endif
\ No newline at end of file
@@ -20,6 +20,26 @@
 
 #include "ruuvi_driver_error.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Sleep accounting of yield.
+ *
+ * Times are measured with RTC and have resolution of one RTC tick.
+ * Device wakes up at the deadline of the nearest timer or by another interrupt.
+ */
+typedef struct
+{
+  uint64_t sleep_us;       //!< Total time in sleep.
+  uint64_t active_us;      //!< Total time awake between sleeps.
+  uint32_t active_ppm;     //!< Share of time awake, parts per million.
+  uint32_t sleeps;         //!< Number of times device has slept.
+  uint32_t skipped;        //!< Number of yields which returned without sleep due to
+                           //!< pending work.
+  uint32_t wake_timer;     //!< Wakeups at timer deadline.
+  uint32_t wake_scheduler; //!< Wakeups by interrupt which scheduled work.
+  uint32_t wake_other;     //!< Wakeups by other interrupts.
+} ruuvi_interface_yield_stats_t;
 
 /** Function which gets called when entering / exiting sleep, configured by application.
  *
@@ -53,6 +73,7 @@ ruuvi_driver_status_t ruuvi_interface_yield_init(void);
  * @param[in] enable true to enable low-power mode, false to disable.
  *
  * @return RUUVI_DRIVER_SUCCESS on success, error code from stack on error.
+ * @return RUUVI_DRIVER_ERROR_INVALID_STATE if enabling before timers are initialized.
  */
 ruuvi_driver_status_t ruuvi_interface_yield_low_power_enable(const bool enable);
 
@@ -60,13 +81,50 @@ ruuvi_driver_status_t ruuvi_interface_yield_low_power_enable(const bool enable);
   * @brief Function which will release execution.
   *
   * The program execution will not continue until some external event
-  * continues the program.
+  * continues the program. Device sleeps until the deadline of the nearest timer
+  * or until an interrupt occurs, no periodic tick is used. If scheduler has work
+  * queued or a timer deadline has passed, returns right away without sleeping.
   *
   * @return RUUVI_DRIVER_SUCCESS on success, error code from stack on error.
   * @warning This function will never return unless external event occurs.
   **/
 ruuvi_driver_status_t ruuvi_interface_yield(void);
 
+/**
+ * @brief Get sleep accounting since init or since previous reset.
+ *
+ * Share of time awake is the duty cycle of the CPU.
+ *
+ * @param[out] stats Accounted time and wakeup reasons.
+ * @return RUUVI_DRIVER_SUCCESS on success.
+ * @return RUUVI_DRIVER_ERROR_NULL if stats is NULL.
+ */
+ruuvi_driver_status_t ruuvi_interface_yield_stats_get(ruuvi_interface_yield_stats_t*
+    const stats);
+
+/**
+ * @brief Reset sleep accounting.
+ */
+void ruuvi_interface_yield_stats_reset(void);
+
+/**
+  * @brief Sleep until flag is set by an interrupt or timeout elapses.
+  *
+  * CPU sleeps between interrupts. Timeout is kept by a soft timer, so CPU wakes
+  * up even if the interrupt never arrives. If low-power mode has not been enabled,
+  * or caller is an interrupt which timer interrupt cannot preempt, CPU waits in a
+  * delay loop instead of sleeping. May be called from interrupt while another wait
+  * or delay is in progress.
+  *
+  * @param[in] flag Flag to wait for, set in interrupt context.
+  * @param[in] timeout_ms Maximum time to wait. Actual timeout may be up to 1 ms longer.
+  * @return RUUVI_DRIVER_SUCCESS if flag was set.
+  * @return RUUVI_DRIVER_ERROR_NULL if flag is NULL.
+  * @return RUUVI_DRIVER_ERROR_TIMEOUT if flag was not set in time.
+  **/
+ruuvi_driver_status_t ruuvi_interface_yield_wait(const volatile bool* const flag,
+    const uint32_t timeout_ms);
+
 /**
   * @brief Delay a given number of milliseconds.
   *
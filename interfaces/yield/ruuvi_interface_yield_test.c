@@ -0,0 +1,85 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_RUN_TESTS
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_test.h"
+#include "ruuvi_interface_rtc.h"
+#include "ruuvi_interface_scheduler.h"
+#include "ruuvi_interface_timer.h"
+#include "ruuvi_interface_yield.h"
+#include "ruuvi_interface_yield_test.h"
+#include <stdbool.h>
+
+static volatile bool m_task_run; //!< Scheduled task has run.
+/** @brief Sleep accounting before and after delay in scheduled task. */
+static ruuvi_interface_yield_stats_t m_before;
+static ruuvi_interface_yield_stats_t m_after;
+
+static ruuvi_interface_timer_soft_t m_nested_timer; //!< Timer interrupting delay.
+static volatile bool m_nested_flag;                 //!< Flag which is never set.
+static volatile ruuvi_driver_status_t m_nested_status;
+
+/** @brief Wait in timer interrupt like a blocking bus transfer would. */
+static void nested_wait_handler(void* p_context)
+{
+  m_nested_status = ruuvi_interface_yield_wait(&m_nested_flag,
+                    RUUVI_INTERFACE_YIELD_TEST_NESTED_MS);
+}
+
+static void delay_task(void* p_event_data, uint16_t event_size)
+{
+  ruuvi_interface_yield_stats_get(&m_before);
+  ruuvi_interface_delay_ms(RUUVI_INTERFACE_YIELD_TEST_DELAY_MS);
+  ruuvi_interface_yield_stats_get(&m_after);
+  m_task_run = true;
+}
+
+ruuvi_driver_status_t ruuvi_interface_yield_test(void)
+{
+  ruuvi_driver_status_t err_code = ruuvi_interface_yield_low_power_enable(true);
+
+  if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
+
+  if(RUUVI_DRIVER_UINT64_INVALID == ruuvi_interface_rtc_micros())
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_STATE;
+  }
+
+  m_task_run = false;
+  err_code = ruuvi_interface_scheduler_event_put(NULL, 0, delay_task);
+
+  if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
+
+  err_code = ruuvi_interface_scheduler_execute();
+  // - Delay in a scheduled task must sleep instead of skipping sleep for the queued task
+  //   itself.
+  const uint32_t sleeps = m_after.sleeps - m_before.sleeps;
+  const uint32_t skipped = m_after.skipped - m_before.skipped;
+  const uint64_t sleep_us = m_after.sleep_us - m_before.sleep_us;
+  // Expired deadline may skip a sleep, busy loop skips thousands.
+  bool pass = (RUUVI_DRIVER_SUCCESS == err_code) && m_task_run && (0 < sleeps)
+              && (skipped <= sleeps)
+              && (sleep_us >= (RUUVI_INTERFACE_YIELD_TEST_DELAY_MS * 500U));
+  ruuvi_driver_test_register(pass);
+  bool fail = !pass;
+  // - Delay must last its time when a wait with timeout runs in an interrupt during it.
+  const uint64_t start_us = ruuvi_interface_rtc_micros();
+  m_nested_flag = false;
+  m_nested_status = RUUVI_DRIVER_SUCCESS;
+  err_code = ruuvi_interface_timer_soft_start(&m_nested_timer,
+             RUUVI_INTERFACE_TIMER_MODE_SINGLE_SHOT, RUUVI_INTERFACE_YIELD_TEST_DELAY_MS / 4,
+             nested_wait_handler, NULL);
+  err_code |= ruuvi_interface_delay_ms(RUUVI_INTERFACE_YIELD_TEST_DELAY_MS);
+  const uint64_t elapsed_us = ruuvi_interface_rtc_micros() - start_us;
+  ruuvi_interface_timer_soft_stop(&m_nested_timer);
+  // Nested wait delays timer interrupt, delay may end late by its timeout and a tick.
+  pass = (RUUVI_DRIVER_SUCCESS == err_code)
+         && (RUUVI_DRIVER_ERROR_TIMEOUT == m_nested_status)
+         && (elapsed_us >= (RUUVI_INTERFACE_YIELD_TEST_DELAY_MS * 1000U))
+         && (elapsed_us <= ((RUUVI_INTERFACE_YIELD_TEST_DELAY_MS
+                             + RUUVI_INTERFACE_YIELD_TEST_NESTED_MS + 2) * 1000U));
+  ruuvi_driver_test_register(pass);
+  fail |= !pass;
+  return fail ? RUUVI_DRIVER_ERROR_SELFTEST : RUUVI_DRIVER_SUCCESS;
+}
+
+#endif
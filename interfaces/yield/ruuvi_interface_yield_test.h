@@ -0,0 +1,42 @@
+#ifndef RUUVI_INTERFACE_YIELD_TEST_H
+#define RUUVI_INTERFACE_YIELD_TEST_H
+#include "ruuvi_driver_error.h"
+#include "ruuvi_driver_test.h"
+/**
+ * @addtogroup Yield
+ * @{
+ */
+/**
+* @file ruuvi_interface_yield_test.h
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-12-16
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Test @ref ruuvi_interface_yield.h together with scheduler and timers.
+*
+*/
+
+/** @brief Length of delay in scheduled task under test. */
+#define RUUVI_INTERFACE_YIELD_TEST_DELAY_MS 20
+/** @brief Timeout of wait nested in timer interrupt during delay. */
+#define RUUVI_INTERFACE_YIELD_TEST_NESTED_MS 2
+
+/**
+ * @brief Test sleeping in low-power mode.
+ *
+ * - Delay in a scheduled task must sleep instead of skipping sleep for the queued task
+ *   itself.
+ * - Delay must last its time when a wait with timeout runs in an interrupt during it.
+ *
+ * Requires initialized scheduler, timers and RTC, must not be called from a scheduled task.
+ * Low-power mode is left enabled after test.
+ *
+ * @return @c RUUVI_DRIVER_SUCCESS if all tests pass.
+ * @return @c RUUVI_DRIVER_ERROR_SELFTEST if a test fails.
+ * @return @c RUUVI_DRIVER_ERROR_INVALID_STATE if RTC is not running.
+ * @return Error code of low-power enable or scheduler if test could not be run.
+ */
+ruuvi_driver_status_t ruuvi_interface_yield_test(void);
+
+/*@}*/
+#endif
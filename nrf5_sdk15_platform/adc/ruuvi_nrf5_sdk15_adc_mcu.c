@@ -48,14 +48,24 @@
 #include "ruuvi_driver_error.h"
 #include "ruuvi_driver_sensor.h"
 #include "ruuvi_nrf5_sdk15_error.h"
+#include "ruuvi_nrf5_sdk15_timer_instances.h"
 #include "ruuvi_interface_adc.h"
 #include "ruuvi_interface_adc_mcu.h"
+#include "ruuvi_interface_yield.h"
 
 #include "nrf_drv_saadc.h"
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED || RUUVI_INTERFACE_ADC_DROOP_ENABLED
+#include "nrf_drv_ppi.h"
+#include "nrf_drv_timer.h"
+#endif
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+#include "ruuvi_interface_adc_stream.h"
+#endif
 
 #include <string.h>
 
 #define RUUVI_PLATFORM_ADC_NRF52832_DEFAULT_RESOLUTION 10
+#define ADC_SCAN_TIMEOUT_MS 100 // 8 channels * 256 oversamples * 42 us is 86 ms.
 
 #define ADC_REF_VOLTAGE_IN_VOLTS  0.600f  // Reference voltage (in milli volts) used by ADC while doing conversion.
 #define ADC_PRE_SCALING_COMPENSATION 6.0f    // The ADC is configured to use channel with prescaling as input. And hence the result of conversion is to be multiplied by prescaling to get the actual value of the voltage.
@@ -89,6 +99,35 @@ static nrf_drv_saadc_config_t adc_config =
 
 static const char m_adc_name[] = "nRF5ADC"; //!< Human-readable name
 
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+#define ADC_STREAM_MIN_INTERVAL_US 5      // Conversion + shortest acquisition time.
+#define ADC_STREAM_MAX_SAMPLES     32767  // Maximum size of SAADC EasyDMA buffer.
+static const nrf_drv_timer_t m_adc_timer = NRF_DRV_TIMER_INSTANCE(ADC_TIMER_INSTANCE);
+static nrf_ppi_channel_t m_adc_ppi;      // PPI channel from timer compare to sample task.
+static size_t m_stream_samples;          // Number of samples in one stream buffer.
+#endif
+static bool m_streaming = false;         // Flag, samples are streamed to buffers.
+
+#if RUUVI_INTERFACE_ADC_DROOP_ENABLED
+static const nrf_drv_timer_t m_droop_timer = NRF_DRV_TIMER_INSTANCE(
+      ADC_DROOP_TIMER_INSTANCE);
+static nrf_ppi_channel_t m_droop_ppi;         // PPI channel from timer compare to sample task.
+static nrf_saadc_value_t m_droop_buf;         // Buffer for sample under load.
+static float m_droop_idle;                    // Idle voltage of ongoing measurement.
+static volatile bool m_droop_armed = false;   // Loaded sample is pending.
+static volatile uint32_t m_droop_seq = 0;     // Incremented before and after update.
+static ruuvi_interface_adc_droop_t m_droop =
+{
+  .timestamp_ms = RUUVI_DRIVER_UINT64_INVALID,
+  .idle_v       = RUUVI_INTERFACE_ADC_INVALID,
+  .loaded_v     = RUUVI_INTERFACE_ADC_INVALID,
+  .droop_v      = RUUVI_INTERFACE_ADC_INVALID
+};
+#endif
+static bool m_droop_active = false;       // Flag, droop is measured on radio events.
+static nrf_saadc_value_t m_scan_buf[NRF_SAADC_CHANNEL_COUNT]; // Results of scan.
+static volatile bool m_scan_done = false; // Flag, scan buffer is filled.
+
 static float raw_adc_to_volts(nrf_saadc_value_t adc)
 {
   // Get ADC max value into counts
@@ -107,7 +146,8 @@ static void nrf52832_adc_sample(void)
 }
 
 /**@brief Function handling events from 'nrf_drv_saadc.c'.
- * No implementation needed
+ * In continuous mode filled buffer is passed on and next buffer is queued,
+ * other buffer is being filled meanwhile.
  *
  * @param[in] p_evt SAADC event.
  */
@@ -115,9 +155,86 @@ static void saadc_event_handler(nrf_drv_saadc_evt_t const* p_evt)
 {
   if(p_evt->type == NRF_DRV_SAADC_EVT_DONE)
   {
+    if(m_scan_buf == p_evt->data.done.p_buffer) { m_scan_done = true; }
+
+#if RUUVI_INTERFACE_ADC_DROOP_ENABLED
+
+    if(m_droop_armed && &m_droop_buf == p_evt->data.done.p_buffer)
+    {
+      m_droop_armed = false;
+      const float loaded = raw_adc_to_volts(m_droop_buf);
+      m_droop_seq++;
+      m_droop.timestamp_ms = ruuvi_driver_sensor_timestamp_get();
+      m_droop.idle_v       = m_droop_idle;
+      m_droop.loaded_v     = loaded;
+      m_droop.droop_v      = m_droop_idle - loaded;
+      m_droop_seq++;
+    }
+
+#endif
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+
+    if(m_streaming)
+    {
+      int16_t* next = ruuvi_interface_adc_stream_buffer_done(p_evt->data.done.p_buffer,
+                      p_evt->data.done.size, ruuvi_driver_sensor_timestamp_get());
+
+      if(NULL != next) { nrf_drv_saadc_buffer_convert(next, m_stream_samples); }
+    }
+
+#endif
   }
 }
 
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+// Timer only triggers samples through PPI, no interrupt is used.
+static void adc_timer_handler(nrf_timer_event_t event_type, void* p_context)
+{
+}
+
+// Release timer, PPI and stream buffers of continuous mode.
+static void adc_stream_teardown(void)
+{
+  nrf_drv_timer_disable(&m_adc_timer);
+  nrf_drv_ppi_channel_disable(m_adc_ppi);
+  nrf_drv_ppi_channel_free(m_adc_ppi);
+  nrf_drv_timer_uninit(&m_adc_timer);
+  m_streaming = false;
+  // Release queued buffers, event handler ignores buffers after streaming has stopped.
+  nrf_drv_saadc_abort();
+  ruuvi_interface_adc_stream_uninit();
+}
+#endif
+
+#if RUUVI_INTERFACE_ADC_DROOP_ENABLED
+// Timer only triggers loaded sample through PPI, no interrupt is used.
+static void droop_timer_handler(nrf_timer_event_t event_type, void* p_context)
+{
+}
+
+// Cancel loaded sample if radio activity ended or was cancelled before it was taken.
+static void droop_disarm(void)
+{
+  if(m_droop_armed)
+  {
+    m_droop_armed = false;
+    nrf_drv_timer_pause(&m_droop_timer);
+    nrf_drv_timer_clear(&m_droop_timer);
+    nrf_drv_saadc_abort();
+  }
+}
+
+// Release timer and PPI of droop measurement.
+static void droop_teardown(void)
+{
+  m_droop_active = false;
+  droop_disarm();
+  nrf_drv_ppi_channel_disable(m_droop_ppi);
+  nrf_drv_ppi_channel_free(m_droop_ppi);
+  nrf_drv_timer_uninit(&m_droop_timer);
+}
+#endif
+
 // Converts Ruuvi ADC channel to nRF adc channel
 static nrf_saadc_input_t ruuvi_to_nrf_adc_channel(ruuvi_interface_adc_channel_t channel)
 {
@@ -258,6 +375,119 @@ static nrf_saadc_oversample_t uint_to_nrf_os(uint8_t* const parameter)
   return oversample;
 }
 
+// Convert complex sample definition to nRF SAADC channel configuration.
+static ruuvi_driver_status_t scan_channel_config(const ruuvi_interface_adc_sample_t* const
+    sample, nrf_saadc_channel_config_t* const config)
+{
+  static const nrf_saadc_acqtime_t acq_times[] =
+  {
+    NRF_SAADC_ACQTIME_3US, NRF_SAADC_ACQTIME_5US, NRF_SAADC_ACQTIME_10US,
+    NRF_SAADC_ACQTIME_15US, NRF_SAADC_ACQTIME_20US, NRF_SAADC_ACQTIME_40US
+  };
+  static const uint16_t acq_us[] = {3, 5, 10, 15, 20, 40};
+  config->mode = (RUUVI_INTERFACE_ADC_AINGND == sample->negative) ?
+                 NRF_SAADC_MODE_SINGLE_ENDED : NRF_SAADC_MODE_DIFFERENTIAL;
+  config->pin_p = ruuvi_to_nrf_adc_channel(sample->positive);
+  config->pin_n = (NRF_SAADC_MODE_SINGLE_ENDED == config->mode) ?
+                  NRF_SAADC_INPUT_DISABLED : ruuvi_to_nrf_adc_channel(sample->negative);
+  config->burst = NRF_SAADC_BURST_DISABLED;
+
+  if(NRF_SAADC_INPUT_DISABLED == config->pin_p ||
+      (NRF_SAADC_MODE_DIFFERENTIAL == config->mode && NRF_SAADC_INPUT_DISABLED == config->pin_n))
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  if((sample->positive_pullup_active && sample->positive_pulldown_active) ||
+      (sample->negative_pullup_active && sample->negative_pulldown_active))
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  config->resistor_p = sample->positive_pullup_active ? NRF_SAADC_RESISTOR_PULLUP :
+                       sample->positive_pulldown_active ? NRF_SAADC_RESISTOR_PULLDOWN :
+                       NRF_SAADC_RESISTOR_DISABLED;
+  config->resistor_n = sample->negative_pullup_active ? NRF_SAADC_RESISTOR_PULLUP :
+                       sample->negative_pulldown_active ? NRF_SAADC_RESISTOR_PULLDOWN :
+                       NRF_SAADC_RESISTOR_DISABLED;
+
+  if(RUUVI_INTERFACE_ADC_VREF_INTERNAL == sample->reference)
+  {
+    config->reference = NRF_SAADC_REFERENCE_INTERNAL;
+  }
+  else if(RUUVI_INTERFACE_ADC_AINVDD == sample->reference)
+  {
+    config->reference = NRF_SAADC_REFERENCE_VDD4;
+  }
+  else { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  // Gain is rounded down, i.e. division is rounded up.
+  if(1 < sample->division && 1 != sample->gain)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  if(5 < sample->division)       { config->gain = NRF_SAADC_GAIN1_6; }
+  else if(4 < sample->division)  { config->gain = NRF_SAADC_GAIN1_5; }
+  else if(3 < sample->division)  { config->gain = NRF_SAADC_GAIN1_4; }
+  else if(2 < sample->division)  { config->gain = NRF_SAADC_GAIN1_3; }
+  else if(1 < sample->division)  { config->gain = NRF_SAADC_GAIN1_2; }
+  else if(4 <= sample->gain)     { config->gain = NRF_SAADC_GAIN4; }
+  else if(2 <= sample->gain)     { config->gain = NRF_SAADC_GAIN2; }
+  else                           { config->gain = NRF_SAADC_GAIN1; }
+
+  for(size_t ii = 0; ii < sizeof(acq_us) / sizeof(acq_us[0]); ii++)
+  {
+    if(sample->t_acquisition_us <= acq_us[ii])
+    {
+      config->acq_time = acq_times[ii];
+      return RUUVI_DRIVER_SUCCESS;
+    }
+  }
+
+  return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+}
+
+// Input voltage which corresponds to full scale of channel.
+static float scan_full_scale_volts(const nrf_saadc_channel_config_t* const config)
+{
+  // VDD/4 is not known without measuring VDD, only ratiometric result is valid.
+  if(NRF_SAADC_REFERENCE_INTERNAL != config->reference)
+  {
+    return RUUVI_INTERFACE_ADC_INVALID;
+  }
+
+  const float reference = ADC_REF_VOLTAGE_IN_VOLTS;
+
+  switch(config->gain)
+  {
+    case NRF_SAADC_GAIN1_6:
+      return reference * 6.0f;
+
+    case NRF_SAADC_GAIN1_5:
+      return reference * 5.0f;
+
+    case NRF_SAADC_GAIN1_4:
+      return reference * 4.0f;
+
+    case NRF_SAADC_GAIN1_3:
+      return reference * 3.0f;
+
+    case NRF_SAADC_GAIN1_2:
+      return reference * 2.0f;
+
+    case NRF_SAADC_GAIN2:
+      return reference / 2.0f;
+
+    case NRF_SAADC_GAIN4:
+      return reference / 4.0f;
+
+    case NRF_SAADC_GAIN1:
+    default:
+      return reference;
+  }
+}
+
 ruuvi_driver_status_t ruuvi_interface_adc_mcu_init(ruuvi_driver_sensor_t* adc_sensor,
     ruuvi_driver_bus_t bus, uint8_t handle)
 {
@@ -311,6 +541,8 @@ ruuvi_driver_status_t ruuvi_interface_adc_mcu_uninit(ruuvi_driver_sensor_t* adc_
 {
   if(NULL == adc_sensor) { return RUUVI_DRIVER_ERROR_NULL; }
 
+  ruuvi_interface_adc_mcu_stream_stop();
+  ruuvi_interface_adc_mcu_droop_stop();
   ruuvi_driver_sensor_uninitialize(adc_sensor);
   nrf_drv_saadc_uninit();
   adc_is_init = false;
@@ -503,7 +735,10 @@ ruuvi_driver_status_t ruuvi_interface_adc_mcu_mode_set(uint8_t* mode)
   {
     autorefresh = false;
     *mode = RUUVI_DRIVER_SENSOR_CFG_SLEEP;
-    return RUUVI_DRIVER_SUCCESS;
+    ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+    err_code |= ruuvi_interface_adc_mcu_stream_stop();
+    err_code |= ruuvi_interface_adc_mcu_droop_stop();
+    return err_code;
   }
 
   if(RUUVI_DRIVER_SENSOR_CFG_SINGLE == *mode)
@@ -540,12 +775,12 @@ ruuvi_driver_status_t ruuvi_interface_adc_mcu_mode_get(uint8_t* mode)
 {
   if(NULL == mode) { return RUUVI_DRIVER_ERROR_NULL; }
 
-  if(autorefresh)
+  if(autorefresh || m_streaming || m_droop_active)
   {
     *mode = RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS;
   }
 
-  if(!autorefresh)
+  if(!(autorefresh || m_streaming || m_droop_active))
   {
     *mode = RUUVI_DRIVER_SENSOR_CFG_SLEEP;
   }
@@ -600,32 +835,277 @@ ruuvi_driver_status_t ruuvi_interface_adc_mcu_data_get(ruuvi_driver_sensor_data_
 ruuvi_driver_status_t ruuvi_interface_adc_complex_sample(const
     ruuvi_interface_adc_sample_t* const sample, ruuvi_interface_adc_data_t* const data)
 {
-  if(NULL == data || NULL == sample) { return RUUVI_DRIVER_ERROR_NULL; }
+  return ruuvi_interface_adc_mcu_scan(sample, 1, data);
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_scan(const ruuvi_interface_adc_sample_t*
+    const samples, const size_t count, ruuvi_interface_adc_data_t* const data)
+{
+  if(NULL == data || NULL == samples) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(0 == count || NRF_SAADC_CHANNEL_COUNT < count)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
 
   if(true == adc_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
 
+  nrf_saadc_channel_config_t ch_configs[NRF_SAADC_CHANNEL_COUNT];
+  uint8_t os = 1;
+
+  for(size_t ii = 0; ii < count; ii++)
+  {
+    if(RUUVI_DRIVER_SUCCESS != scan_channel_config(&samples[ii], &ch_configs[ii]))
+    {
+      return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+    }
+
+    // Oversampling is common to all channels, use the largest requested.
+    if(samples[ii].oversamples > os) { os = samples[ii].oversamples; }
+  }
+
   // Initialize ADC
   nrf_drv_saadc_config_t adc_default = NRF_DRV_SAADC_DEFAULT_CONFIG;
   memcpy(&adc_config, &adc_default, sizeof(adc_config));
-  uint8_t os = sample->oversamples;
-  adc_config.oversample = uint_to_nrf_os(&os);
-  adc_config.resolution = NRF_SAADC_RESOLUTION_14BIT;
+  adc_config.oversample = (1 < os) ? uint_to_nrf_os(&os) : NRF_SAADC_OVERSAMPLE_DISABLED;
+  // 14 bits is meaningful only with oversampling.
+  adc_config.resolution = (1 < os) ? NRF_SAADC_RESOLUTION_14BIT :
+                          NRF_SAADC_RESOLUTION_12BIT;
   ret_code_t err_code = nrf_drv_saadc_init(&adc_config, saadc_event_handler);
-  // Initialize given channel. Only one ADC channel is supported at a time
-  nrf_saadc_channel_config_t ch_config =
-  {
-    \
-    .resistor_p = NRF_SAADC_RESISTOR_DISABLED,                       \
-    .resistor_n = NRF_SAADC_RESISTOR_DISABLED,                       \
-    .gain       = NRF_SAADC_GAIN1_6,                                 \
-    .reference  = NRF_SAADC_REFERENCE_INTERNAL,                      \
-    .acq_time   = NRF_SAADC_ACQTIME_10US,                            \
-    .mode       = (RUUVI_INTERFACE_ADC_AINGND == (sample->negative)) ? NRF_SAADC_MODE_SINGLE_ENDED : NRF_SAADC_MODE_DIFFERENTIAL, \
-    .pin_p      = ruuvi_to_nrf_adc_channel(sample->positive),        \
-    .pin_n      = ruuvi_to_nrf_adc_channel(sample->negative)
-  };
-  nrf_saadc_channel_init(0, &ch_config);
-  return err_code;
+
+  for(size_t ii = 0; ii < count; ii++)
+  {
+    // Burst takes all oversamples of a channel on one trigger, required in scan mode.
+    ch_configs[ii].burst = (1 < os) ? NRF_SAADC_BURST_ENABLED : NRF_SAADC_BURST_DISABLED;
+    err_code |= nrf_drv_saadc_channel_init((uint8_t) ii, &ch_configs[ii]);
+  }
+
+  // All enabled channels are converted on one sample task.
+  m_scan_done = false;
+  err_code |= nrf_drv_saadc_buffer_convert(m_scan_buf, (uint16_t) count);
+  err_code |= nrf_drv_saadc_sample();
+
+  ruuvi_driver_status_t status = ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
+
+  // END event may be lost, e.g. to an abort, do not wait for it forever.
+  if(RUUVI_DRIVER_SUCCESS == status
+      && RUUVI_DRIVER_SUCCESS != ruuvi_interface_yield_wait(&m_scan_done,
+          ADC_SCAN_TIMEOUT_MS))
+  {
+    nrf_drv_saadc_abort();
+    status = RUUVI_DRIVER_ERROR_TIMEOUT;
+  }
+
+  const uint64_t timestamp = ruuvi_driver_sensor_timestamp_get();
+
+  for(size_t ii = 0; ii < count; ii++)
+  {
+    const float counts = (float)(1 << nrf_to_ruuvi_resolution(adc_config.resolution));
+    // Differential result is signed and uses one bit for sign.
+    const float full_scale = (NRF_SAADC_MODE_DIFFERENTIAL == ch_configs[ii].mode) ?
+                             counts / 2.0f : counts;
+    const float ratio = (float)m_scan_buf[ii] / full_scale;
+    data[ii].timestamp_ms    = timestamp;
+    data[ii].adc_ratiometric = ratio;
+    data[ii].adc_v           = ratio * scan_full_scale_volts(&ch_configs[ii]);
+
+    if(RUUVI_DRIVER_SUCCESS != status)
+    {
+      data[ii].timestamp_ms    = RUUVI_DRIVER_UINT64_INVALID;
+      data[ii].adc_ratiometric = RUUVI_INTERFACE_ADC_INVALID;
+      data[ii].adc_v           = RUUVI_INTERFACE_ADC_INVALID;
+    }
+  }
+
+  nrf_drv_saadc_uninit();
+  return status;
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_stream_start(int16_t* const buffers,
+    const size_t buffer_count, const size_t samples, const uint32_t interval_us,
+    const ruuvi_interface_adc_batch_fp_t handler)
+{
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+
+  if(NULL == buffers || NULL == handler) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(!adc_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  VERIFY_SENSOR_SLEEPS();
+
+  // Each trigger would take only one of oversampled samples.
+  if(NRF_SAADC_OVERSAMPLE_DISABLED != adc_config.oversample)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_STATE;
+  }
+
+  if(ADC_STREAM_MIN_INTERVAL_US > interval_us || ADC_STREAM_MAX_SAMPLES < samples)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  ruuvi_driver_status_t status = ruuvi_interface_adc_stream_init(buffers, buffer_count,
+                                 samples, interval_us, raw_adc_to_volts(1), handler);
+
+  if(RUUVI_DRIVER_SUCCESS != status) { return status; }
+
+  ret_code_t err_code = NRF_SUCCESS;
+  nrf_drv_timer_config_t timer_config = NRF_DRV_TIMER_DEFAULT_CONFIG;
+  timer_config.frequency = NRF_TIMER_FREQ_1MHz;
+  timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+  err_code |= nrf_drv_timer_init(&m_adc_timer, &timer_config, adc_timer_handler);
+  nrf_drv_timer_extended_compare(&m_adc_timer, NRF_TIMER_CC_CHANNEL0,
+                                 nrf_drv_timer_us_to_ticks(&m_adc_timer, interval_us),
+                                 NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+  ret_code_t ppi_status = nrf_drv_ppi_init();
+
+  // PPI may be shared with other modules
+  if(NRF_ERROR_MODULE_ALREADY_INITIALIZED != ppi_status) { err_code |= ppi_status; }
+
+  const uint32_t compare_event = nrf_drv_timer_compare_event_address_get(&m_adc_timer,
+                                 NRF_TIMER_CC_CHANNEL0);
+  err_code |= nrf_drv_ppi_channel_alloc(&m_adc_ppi);
+  err_code |= nrf_drv_ppi_channel_assign(m_adc_ppi, compare_event,
+                                         nrf_drv_saadc_sample_task_get());
+  m_stream_samples = samples;
+  // Queue two buffers, SAADC switches to second one in hardware when first is full.
+  err_code |= nrf_drv_saadc_buffer_convert(ruuvi_interface_adc_stream_buffer_get(),
+              samples);
+  err_code |= nrf_drv_saadc_buffer_convert(ruuvi_interface_adc_stream_buffer_get(),
+              samples);
+
+  if(NRF_SUCCESS == err_code)
+  {
+    m_streaming = true;
+    err_code |= nrf_drv_ppi_channel_enable(m_adc_ppi);
+    nrf_drv_timer_enable(&m_adc_timer);
+  }
+  else { adc_stream_teardown(); }
+
+  return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
+#else
+  return RUUVI_DRIVER_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_stream_stop(void)
+{
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+
+  if(m_streaming) { adc_stream_teardown(); }
+
+#endif
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_droop_start(const uint32_t delay_us)
+{
+#if RUUVI_INTERFACE_ADC_DROOP_ENABLED
+
+  if(!adc_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  VERIFY_SENSOR_SLEEPS();
+
+  // Trigger would take only one of oversampled samples.
+  if(NRF_SAADC_OVERSAMPLE_DISABLED != adc_config.oversample)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_STATE;
+  }
+
+  if(0 == delay_us) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  ret_code_t err_code = NRF_SUCCESS;
+  nrf_drv_timer_config_t timer_config = NRF_DRV_TIMER_DEFAULT_CONFIG;
+  timer_config.frequency = NRF_TIMER_FREQ_1MHz;
+  timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+  err_code |= nrf_drv_timer_init(&m_droop_timer, &timer_config, droop_timer_handler);
+  // One-shot: timer stops and clears itself on compare.
+  nrf_drv_timer_extended_compare(&m_droop_timer, NRF_TIMER_CC_CHANNEL0,
+                                 nrf_drv_timer_us_to_ticks(&m_droop_timer, delay_us),
+                                 NRF_TIMER_SHORT_COMPARE0_STOP_MASK |
+                                 NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+  ret_code_t ppi_status = nrf_drv_ppi_init();
+
+  // PPI may be shared with other modules
+  if(NRF_ERROR_MODULE_ALREADY_INITIALIZED != ppi_status) { err_code |= ppi_status; }
+
+  const uint32_t compare_event = nrf_drv_timer_compare_event_address_get(&m_droop_timer,
+                                 NRF_TIMER_CC_CHANNEL0);
+  err_code |= nrf_drv_ppi_channel_alloc(&m_droop_ppi);
+  err_code |= nrf_drv_ppi_channel_assign(m_droop_ppi, compare_event,
+                                         nrf_drv_saadc_sample_task_get());
+  err_code |= nrf_drv_ppi_channel_enable(m_droop_ppi);
+  m_droop_active = true;
+
+  if(NRF_SUCCESS != err_code) { droop_teardown(); }
+
+  return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
+#else
+  return RUUVI_DRIVER_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_droop_stop(void)
+{
+#if RUUVI_INTERFACE_ADC_DROOP_ENABLED
+
+  if(m_droop_active) { droop_teardown(); }
+
+#endif
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+void ruuvi_interface_adc_mcu_radio_activity_handler(const
+    ruuvi_interface_communication_radio_activity_evt_t evt)
+{
+#if RUUVI_INTERFACE_ADC_DROOP_ENABLED
+
+  if(!m_droop_active) { return; }
+
+  if(RUUVI_INTERFACE_COMMUNICATION_RADIO_BEFORE == evt)
+  {
+    // Still armed if AFTER of previous activity never arrived, i.e. radio event was
+    // cancelled. Discard the stale sample rather than let it complete on this activity.
+    droop_disarm();
+    // Radio is not yet active, take idle sample right away.
+    nrf_saadc_value_t idle;
+
+    if(NRF_SUCCESS != nrf_drv_saadc_sample_convert(0, &idle)) { return; }
+
+    m_droop_idle = raw_adc_to_volts(idle);
+
+    // Queue buffer for the loaded sample which timer triggers during TX.
+    if(NRF_SUCCESS == nrf_drv_saadc_buffer_convert(&m_droop_buf, 1))
+    {
+      m_droop_armed = true;
+      nrf_drv_timer_resume(&m_droop_timer);
+    }
+  }
+
+  if(RUUVI_INTERFACE_COMMUNICATION_RADIO_AFTER == evt) { droop_disarm(); }
+
+#endif
+}
+
+ruuvi_driver_status_t ruuvi_interface_adc_mcu_droop_get(ruuvi_interface_adc_droop_t*
+    const data)
+{
+  if(NULL == data) { return RUUVI_DRIVER_ERROR_NULL; }
+
+#if RUUVI_INTERFACE_ADC_DROOP_ENABLED
+  uint32_t seq;
+
+  // Retry if measurement was updated in interrupt while copying.
+  do
+  {
+    seq = m_droop_seq;
+    memcpy(data, &m_droop, sizeof(m_droop));
+  } while((seq & 1U) || seq != m_droop_seq);
+
+  return RUUVI_DRIVER_SUCCESS;
+#else
+  return RUUVI_DRIVER_ERROR_NOT_SUPPORTED;
+#endif
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,10 @@
 #if RUUVI_NRF5_SDK15_ATOMIC_ENABLED
 #include "ruuvi_interface_atomic.h"
 #include "nrf_atomic.h"
+#include "app_util_platform.h"
+
+static uint8_t m_critical_nested = 0;  //!< SoftDevice nesting state of outermost region.
+static uint32_t m_critical_depth = 0;  //!< Number of entered regions.
 
 bool ruuvi_interface_atomic_flag(ruuvi_interface_atomic_ptr flag, const bool set)
 {
@@ -9,4 +13,21 @@ bool ruuvi_interface_atomic_flag(ruuvi_interface_atomic_ptr flag, const bool set
   return nrf_atomic_u32_cmp_exch((ruuvi_interface_atomic_t*) flag, &expected, set);
 }
 
+void ruuvi_interface_atomic_critical_enter(void)
+{
+  uint8_t nested = 0;
+  app_util_critical_region_enter(&nested);
+
+  if(0 == m_critical_depth) { m_critical_nested = nested; }
+
+  m_critical_depth++;
+}
+
+void ruuvi_interface_atomic_critical_exit(void)
+{
+  m_critical_depth--;
+  // Inner regions were entered inside outermost region and never re-enable interrupts.
+  app_util_critical_region_exit((0 == m_critical_depth) ? m_critical_nested : 1);
+}
+
 #endif
\ No newline at end of file
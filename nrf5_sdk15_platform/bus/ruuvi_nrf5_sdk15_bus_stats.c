@@ -0,0 +1,53 @@
+#include "ruuvi_driver_enabled_modules.h"
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED \
+    && (RUUVI_NRF5_SDK15_I2C_ENABLED || RUUVI_NRF5_SDK15_SPI_ENABLED)
+#include "ruuvi_nrf5_sdk15_bus_stats.h"
+#include "nrf_drv_timer.h"
+#include <stdbool.h>
+/**
+ * @addtogroup Bus
+ * @{
+ */
+/**
+* @file ruuvi_nrf5_sdk15_bus_stats.c
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-12-11
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Microsecond clock for bus statistics on nRF5 SDK15.
+*/
+
+static const nrf_drv_timer_t m_clock = NRF_DRV_TIMER_INSTANCE(BUS_STATS_TIMER_INSTANCE);
+static bool m_clock_running = false; //!< Clock is shared by I2C and SPI drivers.
+
+// Clock only runs and captures, no interrupt is used.
+static void clock_handler(nrf_timer_event_t event_type, void* p_context)
+{
+}
+
+ret_code_t ruuvi_nrf5_sdk15_bus_stats_clock_start(void)
+{
+  if(m_clock_running) { return NRF_SUCCESS; }
+
+  nrf_drv_timer_config_t config = NRF_DRV_TIMER_DEFAULT_CONFIG;
+  config.frequency = NRF_TIMER_FREQ_1MHz;
+  config.mode      = NRF_TIMER_MODE_TIMER;
+  config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+  // Fails if another module has initialized the instance.
+  ret_code_t err_code = nrf_drv_timer_init(&m_clock, &config, clock_handler);
+
+  if(NRF_SUCCESS == err_code)
+  {
+    nrf_drv_timer_enable(&m_clock);
+    m_clock_running = true;
+  }
+
+  return err_code;
+}
+
+uint32_t ruuvi_nrf5_sdk15_bus_stats_clock_us(const nrf_timer_cc_channel_t channel)
+{
+  return m_clock_running ? nrf_drv_timer_capture(&m_clock, channel) : 0;
+}
+/*@}*/
+#endif
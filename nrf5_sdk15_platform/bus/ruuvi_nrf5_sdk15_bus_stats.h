@@ -0,0 +1,46 @@
+#ifndef RUUVI_NRF5_SDK15_BUS_STATS_H
+#define RUUVI_NRF5_SDK15_BUS_STATS_H
+#include "ruuvi_nrf5_sdk15_timer_instances.h"
+#include "nrf_timer.h"
+#include "sdk_errors.h"
+#include <stdint.h>
+/**
+ * @addtogroup Bus
+ * @{
+ */
+/**
+* @file ruuvi_nrf5_sdk15_bus_stats.h
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-12-11
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Microsecond clock for bus statistics on nRF5 SDK15.
+*
+* CPU cycle counter stops while CPU sleeps in blocking transfers, so a free-running
+* TIMER is used instead. TIMER keeps high-frequency clock running, enable statistics
+* only in diagnostic builds. Each bus captures time on its own channel.
+* TIMER is allocated through nrf_drv_timer, BUS_STATS_TIMER_INSTANCE is selected in
+* ruuvi_nrf5_sdk15_timer_instances.h.
+*/
+
+#define BUS_STATS_CHANNEL_I2C NRF_TIMER_CC_CHANNEL0 //!< Capture channel of I2C driver.
+#define BUS_STATS_CHANNEL_SPI NRF_TIMER_CC_CHANNEL1 //!< Capture channel of SPI driver.
+
+/**
+ * @brief Start 32-bit 1 MHz clock, wraps after 71 minutes. Does nothing if running.
+ *
+ * @return NRF_SUCCESS if clock is running.
+ * @return NRF_ERROR_INVALID_STATE if TIMER instance is in use by another module.
+ */
+ret_code_t ruuvi_nrf5_sdk15_bus_stats_clock_start(void);
+
+/**
+ * @brief Get current time of clock.
+ *
+ * @param[in] channel Capture channel of calling bus.
+ * @return Time in microseconds, difference of two values is valid across wrap.
+ *         0 if clock is not running.
+ */
+uint32_t ruuvi_nrf5_sdk15_bus_stats_clock_us(const nrf_timer_cc_channel_t channel);
+/*@}*/
+#endif
@@ -12,6 +12,7 @@
 #if RUUVI_NRF5_SDK15_COMMUNICATION_BLE4_STACK_ENABLED
 #include "ruuvi_driver_error.h"
 #include "ruuvi_nrf5_sdk15_error.h"
+#include "ruuvi_interface_adc_mcu.h"
 #include "ruuvi_interface_communication_ble4_advertising.h"
 #include "ruuvi_interface_communication_ble4_gatt.h"
 #include "ruuvi_interface_communication_radio.h"
@@ -51,6 +52,9 @@ static void on_radio_evt(bool active)
   // Call module event handlers
   ruuvi_interface_communication_ble4_advertising_activity_handler(evt);
   //ruuvi_interface_communication_ble4_gatt_activity_handler(evt); - TODO
+#if RUUVI_NRF5_SDK15_NRF52832_ADC_ENABLED && RUUVI_INTERFACE_ADC_DROOP_ENABLED
+  ruuvi_interface_adc_mcu_radio_activity_handler(evt);
+#endif
 
   // Call common event handler if set
   if(NULL != on_radio_activity_callback) { on_radio_activity_callback(evt); }
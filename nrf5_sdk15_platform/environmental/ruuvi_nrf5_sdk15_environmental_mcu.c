@@ -51,6 +51,8 @@
 #include "ruuvi_interface_environmental.h"
 #include "ruuvi_interface_environmental_mcu.h"
 
+#include "app_util_platform.h"
+#include "nrf_delay.h"
 #include "nrf_sdm.h"
 #include "nrf_temp.h"
 
@@ -79,40 +81,109 @@ static float temperature;
 static uint64_t tsample;
 static const char m_tmp_name[] = "nRF5TMP"; //!< Human-readable name
 
-static void nrf52832_temperature_sample(void)
+/** @brief Maximum conversion time of TEMP peripheral, nRF52832 PS. */
+#define NRF52832_TEMP_CONVERSION_US (36U)
+/** @brief Longest wait for a pending conversion before giving up. */
+#define NRF52832_TEMP_TIMEOUT_US (1000U)
+
+// Flag to keep track if a conversion was started and not yet completed in interrupt.
+static volatile bool m_pending = false;
+
+/**
+ * @brief Complete conversion if result is ready.
+ *
+ * Stores result and timestamp of the conversion. Application reads the values
+ * only while no conversion is pending.
+ */
+static void nrf52832_temperature_complete(void)
+{
+  if(NRF_TEMP->EVENTS_DATARDY)
+  {
+    NRF_TEMP->EVENTS_DATARDY = 0;
+    /**@note Workaround for PAN_028 rev2.0A anomaly 29 - TEMP: Stop task clears the TEMP register. */
+    int32_t raw_temp = nrf_temp_read();
+    /**@note Workaround for PAN_028 rev2.0A anomaly 30 - TEMP: Temp module analog front end does not power down when DATARDY event occurs. */
+    NRF_TEMP->TASKS_STOP = 1; /** Stop the temperature measurement. */
+    temperature = raw_temp / 4.0f;
+    tsample = ruuvi_driver_sensor_timestamp_get();
+    m_pending = false;
+  }
+}
+
+/**
+ * @brief Complete conversion in background.
+ */
+void TEMP_IRQHandler(void)
+{
+  nrf52832_temperature_complete();
+}
+
+static void nrf52832_temperature_start(void)
 {
   uint8_t sd_enabled;
   int32_t raw_temp;
   // Check if softdevice is enabled
   sd_softdevice_is_enabled(&sd_enabled);
 
-  // If Nordic softdevice is enabled, we cannot use temperature peripheral directly
+  // If Nordic softdevice is enabled, we cannot use temperature peripheral directly.
+  // SoftDevice has no event for temperature, sd_temp_get blocks until conversion is done.
   if(sd_enabled)
   {
     sd_temp_get(&raw_temp);
+    temperature = raw_temp / 4.0f;
+    tsample = ruuvi_driver_sensor_timestamp_get();
   }
 
-  // If SD is not enabled, call the peripheral directly.
-  if(!sd_enabled)
+  // If SD is not enabled, call the peripheral directly and complete in interrupt.
+  if(!sd_enabled && !m_pending)
   {
+    m_pending = true;
+    NRF_TEMP->EVENTS_DATARDY = 0;
+    NRF_TEMP->INTENSET = TEMP_INTENSET_DATARDY_Msk;
+    NVIC_SetPriority(TEMP_IRQn, APP_IRQ_PRIORITY_LOW);
+    NVIC_ClearPendingIRQ(TEMP_IRQn);
+    NVIC_EnableIRQ(TEMP_IRQn);
     NRF_TEMP->TASKS_START = 1; /** Start the temperature measurement. */
+  }
+}
 
-    /* Busy wait while temperature measurement is not finished, you can skip waiting if you enable interrupt for DATARDY event and read the result in the interrupt. */
-    /*lint -e{845} // A zero has been given as right argument to operator '|'" */
-    while(NRF_TEMP->EVENTS_DATARDY == 0)
-    {
-      // Do nothing.
-    }
+/**
+ * @brief Wait for pending conversion.
+ *
+ * Conversion has usually completed in interrupt while other sensors were started.
+ * If caller runs at or above priority of TEMP interrupt, or interrupts are disabled,
+ * the interrupt cannot run and the result is polled instead.
+ *
+ * @return RUUVI_DRIVER_SUCCESS if no conversion is pending.
+ * @return RUUVI_DRIVER_ERROR_TIMEOUT if conversion did not complete, it is stopped.
+ */
+static ruuvi_driver_status_t nrf52832_temperature_read(void)
+{
+  const bool irq_can_run = (0 == __get_PRIMASK())
+                           && (APP_IRQ_PRIORITY_LOW < current_int_priority_get());
 
-    NRF_TEMP->EVENTS_DATARDY = 0;
-    /**@note Workaround for PAN_028 rev2.0A anomaly 29 - TEMP: Stop task clears the TEMP register. */
-    raw_temp = nrf_temp_read();
-    /**@note Workaround for PAN_028 rev2.0A anomaly 30 - TEMP: Temp module analog front end does not power down when DATARDY event occurs. */
-    NRF_TEMP->TASKS_STOP = 1; /** Stop the temperature measurement. */
+  for(uint32_t waited_us = 0; m_pending && waited_us < NRF52832_TEMP_TIMEOUT_US;
+      waited_us++)
+  {
+    if(!irq_can_run) { nrf52832_temperature_complete(); }
+
+    nrf_delay_us(1);
+  }
+
+  if(m_pending)
+  {
+    NRF_TEMP->TASKS_STOP = 1;
+    m_pending = false;
+    return RUUVI_DRIVER_ERROR_TIMEOUT;
   }
 
-  temperature = raw_temp / 4.0f;
-  tsample = ruuvi_driver_sensor_timestamp_get();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+static ruuvi_driver_status_t nrf52832_temperature_sample(void)
+{
+  nrf52832_temperature_start();
+  return nrf52832_temperature_read();
 }
 
 ruuvi_driver_status_t ruuvi_interface_environmental_mcu_init(ruuvi_driver_sensor_t*
@@ -160,6 +231,10 @@ ruuvi_driver_status_t ruuvi_interface_environmental_mcu_uninit(
 
   sensor_is_init = false;
   autorefresh = false;
+  // Let conversion which might have been left unread complete.
+  nrf52832_temperature_read();
+  NRF_TEMP->INTENCLR = TEMP_INTENCLR_DATARDY_Msk;
+  NVIC_DisableIRQ(TEMP_IRQn);
   ruuvi_driver_sensor_uninitialize(environmental_sensor);
   tsample     = RUUVI_DRIVER_UINT64_INVALID;
   return RUUVI_DRIVER_SUCCESS;
@@ -297,13 +372,14 @@ ruuvi_driver_status_t ruuvi_interface_environmental_mcu_mode_set(uint8_t* mode)
     autorefresh = false;
     *mode = RUUVI_DRIVER_SENSOR_CFG_SLEEP;
     // Global float is updated by sample
-    nrf52832_temperature_sample();
-    return RUUVI_DRIVER_SUCCESS;
+    return nrf52832_temperature_sample();
   }
 
   if(RUUVI_DRIVER_SENSOR_CFG_CONTINUOUS == *mode)
   {
     autorefresh = true;
+    // Sample is ready in background by next data_get.
+    nrf52832_temperature_start();
     return RUUVI_DRIVER_SUCCESS;
   }
 
@@ -332,9 +408,10 @@ ruuvi_driver_status_t ruuvi_interface_environmental_mcu_data_get(
 {
   if(NULL == p_data) { return RUUVI_DRIVER_ERROR_NULL; }
 
-  if(autorefresh) { nrf52832_temperature_sample(); }
+  // Conversion completes in interrupt, only waits if called right after previous call.
+  ruuvi_driver_status_t err_code = nrf52832_temperature_read();
 
-  if(!isnan(temperature))
+  if(RUUVI_DRIVER_SUCCESS == err_code && !isnan(temperature))
   {
     ruuvi_driver_sensor_data_t d_environmental;
     ruuvi_driver_sensor_data_fields_t env_fields = {.bitfield = 0};
@@ -350,6 +427,21 @@ ruuvi_driver_status_t ruuvi_interface_environmental_mcu_data_get(
     p_data->timestamp_ms = tsample;
   }
 
+  // Start next conversion, result is returned on next call.
+  if(autorefresh) { nrf52832_temperature_start(); }
+
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_environmental_mcu_measure_start(
+  uint32_t* const conversion_us)
+{
+  if(NULL == conversion_us) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(!sensor_is_init || autorefresh) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  nrf52832_temperature_start();
+  *conversion_us = m_pending ? NRF52832_TEMP_CONVERSION_US : 0;
   return RUUVI_DRIVER_SUCCESS;
 }
 
@@ -4,6 +4,7 @@
 
 #include "ruuvi_interface_gpio.h"
 #include "ruuvi_driver_error.h"
+#include "app_util_platform.h"
 #include "nrf_gpio.h"
 #include "nrf_drv_gpiote.h"
 #include <stdbool.h>
@@ -153,5 +154,145 @@ ruuvi_driver_status_t ruuvi_interface_gpio_read(const ruuvi_interface_gpio_id_t
 
   return RUUVI_DRIVER_SUCCESS;
 }
+
+/**
+ * @brief Get registers of a port, NULL if port does not exist.
+ */
+static NRF_GPIO_Type* nrf_port_get(const uint8_t port)
+{
+  if(0 == port) { return NRF_P0; }
+
+  #if (GPIO_COUNT > 1)
+
+  if(1 == port) { return NRF_P1; }
+
+  #endif
+  return NULL;
+}
+
+/**
+ * @brief Get number of pins on a port.
+ */
+static uint8_t nrf_port_pins(const uint8_t port)
+{
+  #if (GPIO_COUNT > 1)
+
+  if(1 == port) { return P1_PIN_NUM; }
+
+  #endif
+  return (0 == port) ? P0_PIN_NUM : 0;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_port_mask_get(const ruuvi_interface_gpio_id_t*
+    const pins, const size_t count, ruuvi_interface_gpio_port_mask_t* const mask)
+{
+  if(NULL == pins || NULL == mask) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  ruuvi_interface_gpio_port_mask_t result = {.mask = 0, .port = 0};
+  bool port_known = false;
+
+  for(size_t ii = 0; ii < count; ii++)
+  {
+    if(RUUVI_INTERFACE_GPIO_ID_UNUSED == pins[ii].pin) { continue; }
+
+    const uint8_t port = pins[ii].port_pin.port;
+
+    if((port_known && port != result.port)
+        || pins[ii].port_pin.pin >= nrf_port_pins(port))
+    {
+      return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+    }
+
+    result.port = port;
+    result.mask |= (1UL << pins[ii].port_pin.pin);
+    port_known = true;
+  }
+
+  *mask = result;
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_port_configure(const
+    ruuvi_interface_gpio_port_mask_t mask, const ruuvi_interface_gpio_mode_t mode)
+{
+  if(NULL == nrf_port_get(mask.port)) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+
+  for(uint8_t ii = 0; ii < nrf_port_pins(mask.port); ii++)
+  {
+    if(mask.mask & (1UL << ii))
+    {
+      ruuvi_interface_gpio_id_t pin = {.port_pin = {.pin = ii, .port = mask.port}};
+      err_code |= ruuvi_interface_gpio_configure(pin, mode);
+    }
+  }
+
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_port_set(const ruuvi_interface_gpio_port_mask_t
+    mask)
+{
+  NRF_GPIO_Type* const port = nrf_port_get(mask.port);
+
+  if(NULL == port) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  nrf_gpio_port_out_set(port, mask.mask);
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_port_clear(const
+    ruuvi_interface_gpio_port_mask_t mask)
+{
+  NRF_GPIO_Type* const port = nrf_port_get(mask.port);
+
+  if(NULL == port) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  nrf_gpio_port_out_clear(port, mask.mask);
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_port_toggle(const
+    ruuvi_interface_gpio_port_mask_t mask)
+{
+  NRF_GPIO_Type* const port = nrf_port_get(mask.port);
+
+  if(NULL == port) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  // OUT is read and written back, interrupt must not change other pins in between.
+  CRITICAL_REGION_ENTER();
+  nrf_gpio_port_out_write(port, nrf_gpio_port_out_read(port) ^ mask.mask);
+  CRITICAL_REGION_EXIT();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_port_write(const
+    ruuvi_interface_gpio_port_mask_t mask, const uint32_t value)
+{
+  NRF_GPIO_Type* const port = nrf_port_get(mask.port);
+
+  if(NULL == port) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  // Single OUT write changes set and cleared pins on the same clock cycle.
+  CRITICAL_REGION_ENTER();
+  const uint32_t out = nrf_gpio_port_out_read(port);
+  nrf_gpio_port_out_write(port, (out & ~mask.mask) | (value & mask.mask));
+  CRITICAL_REGION_EXIT();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_port_read(const
+    ruuvi_interface_gpio_port_mask_t mask, uint32_t* const value)
+{
+  if(NULL == value) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  NRF_GPIO_Type* const port = nrf_port_get(mask.port);
+
+  if(NULL == port) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  *value = nrf_gpio_port_in_read(port) & mask.mask;
+  return RUUVI_DRIVER_SUCCESS;
+}
 /*@}*/
 #endif
\ No newline at end of file
@@ -12,13 +12,43 @@
 #include "ruuvi_interface_gpio_interrupt.h"
 
 #include <stdbool.h>
+#include <string.h>
 #include "nrf.h"
 #include "nrf_drv_gpiote.h"
+#include "app_util_platform.h"
+#if RUUVI_NRF5_SDK15_SCHEDULER_ENABLED
+  #include "ruuvi_interface_scheduler.h"
+#endif
+#if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  #include "app_timer.h"
+#endif
+
+/** @brief Number of pins which can be dispatched to scheduler, 2 ports of 32 pins. */
+#define GPIO_INTERRUPT_DISPATCH_PINS 64
 
 //Pointer to look-up table for event handlers
 static ruuvi_interface_gpio_interrupt_fp_t* pin_event_handlers;
 static uint8_t max_interrupts = 0;
 
+// Masks of pins by nRF pin number. Written in interrupt and in critical region.
+static volatile uint64_t m_deferred;  //!< Pins dispatched to scheduler.
+static volatile uint64_t m_coalesced; //!< Pins which keep at most one event in scheduler.
+static volatile uint64_t m_pending;   //!< Coalesced pins with event in scheduler.
+static ruuvi_interface_gpio_interrupt_stats_t m_stats;
+
+/** @brief Event of a pin waiting for scheduler. */
+typedef struct
+{
+  uint32_t ticks;                     //!< RTC ticks at interrupt.
+  uint8_t pin;                        //!< nRF pin number.
+  ruuvi_interface_gpio_slope_t slope; //!< Slope of edge.
+} deferred_evt_t;
+
+#if RUUVI_NRF5_SDK15_SCHEDULER_ENABLED
+// Scheduler rejects larger events, every deferred interrupt would be dropped.
+STATIC_ASSERT(RUUVI_NRF5_SDK15_SCHEDULER_DATA_MAX_SIZE >= sizeof(deferred_evt_t));
+#endif
+
 static inline ruuvi_interface_gpio_id_t nrf_to_ruuvi_pin(nrf_drv_gpiote_pin_t pin)
 {
   ruuvi_interface_gpio_id_t rpin = {.pin = ((pin >> 5) << 8) + (pin & 0x1F)};
@@ -61,6 +91,10 @@ ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_init(
 
   pin_event_handlers = interrupt_table;
   max_interrupts = interrupt_table_size;
+  m_deferred = 0;
+  m_coalesced = 0;
+  m_pending = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
   return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
 }
 
@@ -70,6 +104,8 @@ ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_uninit(void)
 
   pin_event_handlers = NULL;
   max_interrupts = 0;
+  m_deferred = 0;
+  m_coalesced = 0;
   return RUUVI_DRIVER_SUCCESS;
 }
 
@@ -78,6 +114,87 @@ bool ruuvi_interface_gpio_interrupt_is_init()
   return (0 != max_interrupts);
 }
 
+#if RUUVI_NRF5_SDK15_SCHEDULER_ENABLED
+static uint32_t ticks_now(void)
+{
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  return app_timer_cnt_get();
+  #else
+  return 0;
+  #endif
+}
+
+// Microseconds since given RTC ticks, 0 if RTC is not available.
+static uint32_t latency_us_get(const uint32_t start_ticks)
+{
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  const uint32_t ticks = app_timer_cnt_diff_compute(app_timer_cnt_get(), start_ticks);
+  return (uint32_t)(((uint64_t) ticks * 1000000U * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))
+                    / 32768U);
+  #else
+  return 0;
+  #endif
+}
+
+static void deferred_handler(void* p_event_data, uint16_t event_size)
+{
+  deferred_evt_t evt;
+
+  if(sizeof(evt) != event_size) { return; }
+
+  memcpy(&evt, p_event_data, sizeof(evt));
+  const uint64_t mask = (1ULL << evt.pin);
+  // Edges from here on get a new event.
+  CRITICAL_REGION_ENTER();
+  m_pending &= ~mask;
+  CRITICAL_REGION_EXIT();
+  const uint32_t latency_us = latency_us_get(evt.ticks);
+  m_stats.deferred++;
+  m_stats.latency_last_us = latency_us;
+  m_stats.latency_sum_us += latency_us;
+
+  if(latency_us > m_stats.latency_max_us) { m_stats.latency_max_us = latency_us; }
+
+  // Interrupt may have been disabled while event waited in scheduler.
+  if(NULL != pin_event_handlers && evt.pin < max_interrupts
+      && NULL != pin_event_handlers[evt.pin])
+  {
+    ruuvi_interface_gpio_evt_t event =
+    {
+      .slope = evt.slope,
+      .pin   = nrf_to_ruuvi_pin(evt.pin)
+    };
+    (pin_event_handlers[evt.pin])(event);
+  }
+}
+
+/** @brief Queue event to scheduler. Called in interrupt context. */
+static void deferred_put(const uint8_t pin, const ruuvi_interface_gpio_slope_t slope)
+{
+  const uint64_t mask = (1ULL << pin);
+
+  if(m_coalesced & mask)
+  {
+    if(m_pending & mask)
+    {
+      m_stats.coalesced++;
+      return;
+    }
+
+    m_pending |= mask;
+  }
+
+  deferred_evt_t evt = {.ticks = ticks_now(), .pin = pin, .slope = slope};
+
+  if(RUUVI_DRIVER_SUCCESS != ruuvi_interface_scheduler_event_put(&evt, sizeof(evt),
+      deferred_handler))
+  {
+    m_pending &= ~mask;
+    m_stats.dropped++;
+  }
+}
+#endif
+
 static void in_pin_handler(const nrf_drv_gpiote_pin_t pin,
                            const nrf_gpiote_polarity_t action)
 {
@@ -103,6 +220,16 @@ static void in_pin_handler(const nrf_drv_gpiote_pin_t pin,
         break;
     }
 
+    m_stats.events++;
+    #if RUUVI_NRF5_SDK15_SCHEDULER_ENABLED
+
+    if(GPIO_INTERRUPT_DISPATCH_PINS > pin && (m_deferred & (1ULL << pin)))
+    {
+      deferred_put(pin, event.slope);
+      return;
+    }
+
+    #endif
     event.pin = nrf_to_ruuvi_pin(pin);
     (pin_event_handlers[pin])(event);
   }
@@ -161,7 +288,8 @@ ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_enable(const
       return RUUVI_DRIVER_ERROR_INVALID_PARAM;
   }
 
-  //  high-accuracy mode consumes excess power
+  //  high-accuracy mode consumes excess power, PORT event on pin SENSE is used instead.
+  //  Each pin takes one of GPIOTE_CONFIG_NUM_OF_LOW_POWER_EVENTS.
   //  is_watcher is used if we track an output pin.
   nrf_drv_gpiote_in_config_t in_config = { .is_watcher = false,  \
                                            .hi_accuracy = false, \
@@ -187,7 +315,78 @@ ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_disable(const
     pin_event_handlers[nrf_pin] = NULL;
   }
 
+  if(GPIO_INTERRUPT_DISPATCH_PINS > nrf_pin)
+  {
+    CRITICAL_REGION_ENTER();
+    m_deferred &= ~(1ULL << nrf_pin);
+    m_coalesced &= ~(1ULL << nrf_pin);
+    CRITICAL_REGION_EXIT();
+  }
+
   return err_code;
 }
 
+ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_dispatch_set(
+  const ruuvi_interface_gpio_id_t pin,
+  const ruuvi_interface_gpio_interrupt_dispatch_t dispatch)
+{
+  if(!ruuvi_interface_gpio_interrupt_is_init()) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  const uint8_t nrf_pin = ruuvi_to_nrf_pin(pin);
+
+  if(nrf_pin >= max_interrupts || GPIO_INTERRUPT_DISPATCH_PINS <= nrf_pin)
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  const uint64_t mask = (1ULL << nrf_pin);
+  uint64_t deferred = m_deferred & ~mask;
+  uint64_t coalesced = m_coalesced & ~mask;
+
+  switch(dispatch)
+  {
+    case RUUVI_INTERFACE_GPIO_INTERRUPT_DISPATCH_IMMEDIATE:
+      break;
+
+    case RUUVI_INTERFACE_GPIO_INTERRUPT_DISPATCH_COALESCED:
+      coalesced |= mask;
+
+    // fall through
+    case RUUVI_INTERFACE_GPIO_INTERRUPT_DISPATCH_DEFERRED:
+      #if RUUVI_NRF5_SDK15_SCHEDULER_ENABLED
+      deferred |= mask;
+      break;
+      #else
+      return RUUVI_DRIVER_ERROR_NOT_SUPPORTED;
+      #endif
+
+    default:
+      return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  CRITICAL_REGION_ENTER();
+  m_deferred = deferred;
+  m_coalesced = coalesced;
+  CRITICAL_REGION_EXIT();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_gpio_interrupt_stats_get(
+  ruuvi_interface_gpio_interrupt_stats_t* const stats)
+{
+  if(NULL == stats) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  CRITICAL_REGION_ENTER();
+  memcpy(stats, &m_stats, sizeof(m_stats));
+  CRITICAL_REGION_EXIT();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+void ruuvi_interface_gpio_interrupt_stats_reset(void)
+{
+  CRITICAL_REGION_ENTER();
+  memset(&m_stats, 0, sizeof(m_stats));
+  CRITICAL_REGION_EXIT();
+}
+
 #endif
\ No newline at end of file
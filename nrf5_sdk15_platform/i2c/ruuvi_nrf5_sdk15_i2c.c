@@ -43,6 +43,7 @@
 #include <string.h> //memcpy
 
 #include "ruuvi_boards.h"
+#include "app_util_platform.h"
 #include "nrf_drv_twi.h"
 #include "ruuvi_driver_error.h"
 #include "ruuvi_interface_gpio.h"
@@ -50,15 +51,39 @@
 #include "ruuvi_interface_yield.h"
 #include "ruuvi_nrf5_sdk15_gpio.h"
 #include "ruuvi_nrf5_sdk15_error.h"
-
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+#include "ruuvi_interface_bus_stats.h"
+#include "ruuvi_nrf5_sdk15_bus_stats.h"
+#endif
 
 
 static const nrf_drv_twi_t m_twi = NRF_DRV_TWI_INSTANCE(I2C_INSTANCE);
 static bool m_i2c_is_init        = false;
-static volatile bool m_tx_in_progress     = false;
-static volatile ret_code_t xfer_status    = NRF_SUCCESS;
 static uint16_t timeout_us_per_byte       = 400;
 
+/** @brief Jobs waiting for bus, job at head is running. */
+static ruuvi_interface_i2c_job_t* m_queue[RUUVI_INTERFACE_I2C_QUEUE_SIZE];
+static volatile uint8_t m_queue_head   = 0;
+static volatile uint8_t m_queue_tail   = 0;
+static volatile bool m_job_active      = false; //!< Job at head of queue is running.
+static size_t m_segment                = 0;     //!< Segment of running job in transfer.
+static size_t m_segment_step           = 1;     //!< Number of segments in transfer.
+static volatile uint32_t m_job_starts  = 0;     //!< Number of started jobs.
+static volatile uint32_t m_job_timeout_us = 0;  //!< Time limit of running job.
+
+/** @brief State of a blocking call waiting for its job. */
+typedef struct
+{
+  volatile bool done;
+  volatile ruuvi_driver_status_t status;
+} blocking_wait_t;
+
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+static ruuvi_interface_bus_stats_table_t m_stats;
+static uint32_t m_job_start_us = 0; //!< Start time of running job.
+static size_t m_job_bytes      = 0; //!< Bytes in running job.
+#endif
+
 static nrf_drv_twi_frequency_t ruuvi_to_nrf_frequency(const
     ruuvi_interface_i2c_frequency_t freq)
 {
@@ -83,9 +108,11 @@ static void byte_timeout_set(const
   {
     case RUUVI_INTERFACE_I2C_FREQUENCY_100k:
       timeout_us_per_byte = 1000;
+      break;
 
     case RUUVI_INTERFACE_I2C_FREQUENCY_250k:
       timeout_us_per_byte = 400;
+      break;
 
     case RUUVI_INTERFACE_I2C_FREQUENCY_400k:
     default:
@@ -93,13 +120,180 @@ static void byte_timeout_set(const
   }
 }
 
+static void segment_start(ruuvi_interface_i2c_job_t* const job);
+
+static void job_start(ruuvi_interface_i2c_job_t* const job)
+{
+  size_t len = 0;
+
+  for(size_t ii = 0; ii < job->segment_count; ii++)
+  {
+    len += job->segments[ii].length;
+  }
+
+  m_job_timeout_us = timeout_us_per_byte * len;
+  m_job_starts++;
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  m_job_bytes = len;
+  m_job_start_us = ruuvi_nrf5_sdk15_bus_stats_clock_us(BUS_STATS_CHANNEL_I2C);
+#endif
+  m_segment = 0;
+  segment_start(job);
+}
+
+// Remove running job from queue, call in critical region.
+// Next is set to job to start next, NULL if queue is empty.
+static ruuvi_interface_i2c_job_t* job_dequeue(ruuvi_interface_i2c_job_t** const next)
+{
+  ruuvi_interface_i2c_job_t* const job = m_queue[m_queue_head];
+  m_queue_head = (m_queue_head + 1) % RUUVI_INTERFACE_I2C_QUEUE_SIZE;
+  *next = NULL;
+
+  if(m_queue_head != m_queue_tail) { *next = m_queue[m_queue_head]; }
+  else { m_job_active = false; }
+
+  return job;
+}
+
+// Start next job and notify application of removed job, call outside critical region.
+static void job_finish(ruuvi_interface_i2c_job_t* const job,
+                       ruuvi_interface_i2c_job_t* const next, const ret_code_t status)
+{
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  const uint32_t latency_us = ruuvi_nrf5_sdk15_bus_stats_clock_us(BUS_STATS_CHANNEL_I2C)
+                              - m_job_start_us;
+  ruuvi_interface_bus_stats_record(&m_stats, job->address, m_job_bytes, latency_us,
+                                   ruuvi_nrf5_sdk15_to_ruuvi_error(status));
+#endif
+
+  // Keep bus busy while application processes the result.
+  if(NULL != next) { job_start(next); }
+
+  if(NULL != job->callback)
+  {
+    job->callback(job, ruuvi_nrf5_sdk15_to_ruuvi_error(status));
+  }
+}
+
+// Remove running job from queue, start next one and notify application.
+static void job_complete(const ret_code_t status)
+{
+  ruuvi_interface_i2c_job_t* job;
+  ruuvi_interface_i2c_job_t* next;
+  CRITICAL_REGION_ENTER();
+  job = job_dequeue(&next);
+  CRITICAL_REGION_EXIT();
+  job_finish(job, next, status);
+}
+
+static void segment_start(ruuvi_interface_i2c_job_t* const job)
+{
+  const ruuvi_interface_i2c_segment_t* const segment = &(job->segments[m_segment]);
+  const size_t remaining = job->segment_count - m_segment;
+  ret_code_t err_code = NRF_SUCCESS;
+  m_segment_step = 1;
+
+  if(RUUVI_INTERFACE_I2C_SEGMENT_WRITE == segment->direction
+      && 1 < remaining && RUUVI_INTERFACE_I2C_SEGMENT_READ == segment[1].direction)
+  {
+    // Register address write and read with repeated start in one transfer,
+    // peripheral switches from TX to RX in hardware.
+    nrf_drv_twi_xfer_desc_t xfer = NRF_DRV_TWI_XFER_DESC_TXRX(job->address,
+                                   segment->data, segment->length,
+                                   segment[1].data, segment[1].length);
+    m_segment_step = 2;
+    err_code = nrf_drv_twi_xfer(&m_twi, &xfer, 0);
+  }
+  else if(RUUVI_INTERFACE_I2C_SEGMENT_WRITE == segment->direction)
+  {
+    err_code = nrf_drv_twi_tx(&m_twi, job->address, segment->data, segment->length,
+                              (1 < remaining) || job->no_stop);
+  }
+  else
+  {
+    err_code = nrf_drv_twi_rx(&m_twi, job->address, segment->data, segment->length);
+  }
+
+  if(NRF_SUCCESS != err_code) { job_complete(err_code); }
+}
+
 static void on_complete(nrf_drv_twi_evt_t const* p_event, void* p_context)
 {
-  m_tx_in_progress = false;
+  ret_code_t status = NRF_SUCCESS;
+
+  if(p_event->type == NRF_DRV_TWI_EVT_ADDRESS_NACK) { status = NRF_ERROR_NOT_FOUND; }
+  else if(p_event->type == NRF_DRV_TWI_EVT_DATA_NACK) { status = NRF_ERROR_DRV_TWI_ERR_DNACK; }
+  else if(p_event->type != NRF_DRV_TWI_EVT_DONE) { status = NRF_ERROR_INTERNAL; }
 
-  if(p_event->type == NRF_DRV_TWI_EVT_ADDRESS_NACK) { xfer_status |= NRF_ERROR_NOT_FOUND; }
-  else if(p_event->type == NRF_DRV_TWI_EVT_DATA_NACK) { xfer_status |= NRF_ERROR_DRV_TWI_ERR_DNACK; }
-  else if(p_event->type != NRF_DRV_TWI_EVT_DONE) { xfer_status |= NRF_ERROR_INTERNAL; }
+  ruuvi_interface_i2c_job_t* const job = m_queue[m_queue_head];
+
+  if(NRF_SUCCESS == status && (m_segment + m_segment_step) < job->segment_count)
+  {
+    m_segment += m_segment_step;
+    segment_start(job);
+  }
+  else { job_complete(status); }
+}
+
+// Reset peripheral and fail the running job, i.e. if bus is held by device.
+static void job_abort(void)
+{
+  ruuvi_interface_i2c_job_t* job = NULL;
+  ruuvi_interface_i2c_job_t* next = NULL;
+  CRITICAL_REGION_ENTER();
+
+  // Peripheral is reset before interrupts are enabled, aborted job gets no late event.
+  if(m_job_active)
+  {
+    nrf_drv_twi_disable(&m_twi);
+    nrf_drv_twi_enable(&m_twi);
+    job = job_dequeue(&next);
+  }
+
+  CRITICAL_REGION_EXIT();
+
+  if(NULL != job) { job_finish(job, next, NRF_ERROR_TIMEOUT); }
+}
+
+static void blocking_complete(ruuvi_interface_i2c_job_t* const job,
+                              const ruuvi_driver_status_t status)
+{
+  blocking_wait_t* const wait = (blocking_wait_t*) job->p_context;
+  wait->status = status;
+  wait->done = true;
+}
+
+/**
+ * @brief Run a job and sleep until it completes.
+ *
+ * Timeout is counted from the start of the running job, which may be queued before
+ * this one. CPU is woken up by RTC if the running job hangs.
+ */
+static ruuvi_driver_status_t job_run_blocking(ruuvi_interface_i2c_job_t* const job)
+{
+  blocking_wait_t wait = { .done = false, .status = RUUVI_DRIVER_SUCCESS };
+  job->callback = blocking_complete;
+  job->p_context = &wait;
+  ruuvi_driver_status_t err_code = ruuvi_interface_i2c_job_schedule(job);
+
+  if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
+
+  while(!wait.done)
+  {
+    const uint32_t starts = m_job_starts;
+    // Round up, wait for at least one whole millisecond.
+    const uint32_t timeout_ms = (m_job_timeout_us / 1000U) + 1;
+
+    // Job at head of queue has hung if no job has been started while waiting,
+    // it might be another job before this one.
+    if(RUUVI_DRIVER_ERROR_TIMEOUT == ruuvi_interface_yield_wait(&wait.done, timeout_ms)
+        && starts == m_job_starts)
+    {
+      job_abort();
+    }
+  }
+
+  return wait.status;
 }
 
 ruuvi_driver_status_t ruuvi_interface_i2c_init(const ruuvi_interface_i2c_init_config_t*
@@ -130,10 +324,19 @@ ruuvi_driver_status_t ruuvi_interface_i2c_init(const ruuvi_interface_i2c_init_co
     return RUUVI_DRIVER_ERROR_INTERNAL;
   }
 
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  // TIMER of statistics may be taken by another module, report the conflict.
+  err_code = ruuvi_nrf5_sdk15_bus_stats_clock_start();
+
+  if(NRF_SUCCESS != err_code) { return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code); }
+
+#endif
   err_code = nrf_drv_twi_init(&m_twi, &twi_config, on_complete, NULL);
   nrf_drv_twi_enable(&m_twi);
   m_i2c_is_init = true;
-  m_tx_in_progress = false;
+  m_queue_head = 0;
+  m_queue_tail = 0;
+  m_job_active = false;
   return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
 }
 
@@ -152,6 +355,54 @@ ruuvi_driver_status_t i2c_uninit(void)
 }
 
 
+ruuvi_driver_status_t ruuvi_interface_i2c_job_schedule(ruuvi_interface_i2c_job_t* const
+    job)
+{
+  if(NULL == job || NULL == job->segments) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(0 == job->segment_count) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  if(!m_i2c_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  bool start = false;
+  CRITICAL_REGION_ENTER();
+  const uint8_t next_tail = (m_queue_tail + 1) % RUUVI_INTERFACE_I2C_QUEUE_SIZE;
+
+  if(next_tail == m_queue_head) { err_code = RUUVI_DRIVER_ERROR_NO_MEM; }
+  else
+  {
+    m_queue[m_queue_tail] = job;
+    m_queue_tail = next_tail;
+    start = !m_job_active;
+    m_job_active = true;
+  }
+
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+
+  // Stats are written in interrupt context while jobs are running.
+  if(RUUVI_DRIVER_ERROR_NO_MEM == err_code)
+  {
+    ruuvi_interface_bus_stats_record(&m_stats, job->address, 0, 0, err_code);
+  }
+
+#endif
+  CRITICAL_REGION_EXIT();
+
+  if(start) { job_start(job); }
+
+  return err_code;
+}
+
+ruuvi_interface_bus_stats_table_t* ruuvi_interface_i2c_stats_get(void)
+{
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  return &m_stats;
+#else
+  return NULL;
+#endif
+}
+
 /**
  * @breif I2C Write function
  *
@@ -168,24 +419,20 @@ ruuvi_driver_status_t ruuvi_interface_i2c_write_blocking(const uint8_t address,
 
   if(NULL == p_tx) { return RUUVI_DRIVER_ERROR_NULL; }
 
-  if(m_tx_in_progress) { return RUUVI_DRIVER_ERROR_BUSY; }
-
-  int32_t err_code = NRF_SUCCESS;
-  m_tx_in_progress = true;
-  err_code |= nrf_drv_twi_tx(&m_twi, address, p_tx, tx_len, !stop);
-  volatile uint32_t timeout = 0;
-
-  while(m_tx_in_progress && timeout < (timeout_us_per_byte * tx_len))
+  const ruuvi_interface_i2c_segment_t segment =
   {
-    timeout++;
-    ruuvi_interface_delay_us(1);
-  }
-
-  if(timeout >= (timeout_us_per_byte * tx_len)) { err_code |= NRF_ERROR_TIMEOUT; }
-
-  err_code |= xfer_status;
-  xfer_status = NRF_SUCCESS;
-  return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
+    .direction = RUUVI_INTERFACE_I2C_SEGMENT_WRITE,
+    .data      = p_tx,
+    .length    = tx_len
+  };
+  ruuvi_interface_i2c_job_t job =
+  {
+    .address       = address,
+    .segments      = &segment,
+    .segment_count = 1,
+    .no_stop       = !stop
+  };
+  return job_run_blocking(&job);
 }
 
 /**
@@ -203,22 +450,50 @@ ruuvi_driver_status_t ruuvi_interface_i2c_read_blocking(const uint8_t address,
 
   if(NULL == p_rx) { return RUUVI_DRIVER_ERROR_NULL; }
 
-  int32_t err_code = NRF_SUCCESS;
-  m_tx_in_progress = true;
-  err_code |= nrf_drv_twi_rx(&m_twi, address, p_rx, rx_len);
-  volatile uint32_t timeout = 0;
-
-  while(m_tx_in_progress && timeout < (timeout_us_per_byte * rx_len))
+  const ruuvi_interface_i2c_segment_t segment =
   {
-    timeout++;
-    ruuvi_interface_delay_us(1);
-  }
+    .direction = RUUVI_INTERFACE_I2C_SEGMENT_READ,
+    .data      = p_rx,
+    .length    = rx_len
+  };
+  ruuvi_interface_i2c_job_t job =
+  {
+    .address       = address,
+    .segments      = &segment,
+    .segment_count = 1,
+    .no_stop       = false
+  };
+  return job_run_blocking(&job);
+}
 
-  if(timeout >= (timeout_us_per_byte * rx_len)) { err_code |= NRF_ERROR_TIMEOUT; }
+ruuvi_driver_status_t ruuvi_interface_i2c_write_read(const uint8_t address,
+    uint8_t* const p_tx, const size_t tx_len, uint8_t* const p_rx, const size_t rx_len)
+{
+  if(!m_i2c_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
 
-  err_code |= xfer_status;
-  xfer_status = NRF_SUCCESS;
-  return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
+  if(NULL == p_tx || NULL == p_rx) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  const ruuvi_interface_i2c_segment_t segments[2] =
+  {
+    {
+      .direction = RUUVI_INTERFACE_I2C_SEGMENT_WRITE,
+      .data      = p_tx,
+      .length    = tx_len
+    },
+    {
+      .direction = RUUVI_INTERFACE_I2C_SEGMENT_READ,
+      .data      = p_rx,
+      .length    = rx_len
+    }
+  };
+  ruuvi_interface_i2c_job_t job =
+  {
+    .address       = address,
+    .segments      = segments,
+    .segment_count = 2,
+    .no_stop       = false
+  };
+  return job_run_blocking(&job);
 }
 
-#endif
\ No newline at end of file
+#endif
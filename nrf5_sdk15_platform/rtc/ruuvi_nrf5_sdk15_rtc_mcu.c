@@ -53,12 +53,14 @@
 #include "nrf.h"
 #include "nrf_drv_rtc.h"
 #include "nrf_drv_clock.h"
+#include "nrf_rtc.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 const nrf_drv_rtc_t rtc = NRF_DRV_RTC_INSTANCE(
                             NRF5_SDK15_RTC_INSTANCE); /**< RTC0 is reserved by the softdevice, use something else. */
-static uint64_t ticks = 0;
+/** @brief Number of counter overflows. 32-bit counter is written atomically by interrupt. */
+static volatile uint32_t m_overflows = 0;
 static bool m_is_init = false;
 
 /** @brief: Function for handling the RTC0 interrupts.
@@ -68,11 +70,42 @@ static void rtc_handler(nrf_drv_rtc_int_type_t int_type)
 {
   if(int_type == NRF_DRV_RTC_INT_OVERFLOW)
   {
-    // nRF RTC is 24 bits wide.
-    ticks += (1 << 24);
+    m_overflows++;
   }
 }
 
+/**
+ * @brief Read counter and overflows consistently.
+ *
+ * Overflow which has happened but is not yet handled, i.e. if caller has interrupts
+ * disabled, is detected from pending event. Counter read after overflow event is
+ * always paired with the overflow. Driver clears the event before calling
+ * rtc_handler, so interrupts with higher priority than RTC should not read the time.
+ */
+static uint64_t rtc_ticks_read(void)
+{
+  uint32_t overflows;
+  uint32_t counter;
+  bool pending;
+
+  do
+  {
+    overflows = m_overflows;
+    pending = nrf_rtc_event_pending(rtc.p_reg, NRF_RTC_EVENT_OVERFLOW);
+    counter = nrf_rtc_counter_get(rtc.p_reg);
+
+    // Counter may have wrapped between the event check and counter read.
+    if(!pending && nrf_rtc_event_pending(rtc.p_reg, NRF_RTC_EVENT_OVERFLOW))
+    {
+      pending = true;
+      counter = nrf_rtc_counter_get(rtc.p_reg);
+    }
+  } while(overflows != m_overflows);
+
+  // nRF RTC is 24 bits wide.
+  return (((uint64_t) overflows + pending) << 24) + counter;
+}
+
 /**
  * Initializes RTC at 0 ms.
  *
@@ -91,7 +124,7 @@ ruuvi_driver_status_t ruuvi_interface_rtc_init(void)
   nrf_drv_clock_lfclk_request(NULL);
   nrf_drv_rtc_config_t config = NRF_DRV_RTC_DEFAULT_CONFIG;
   config.prescaler = 0;
-  ticks = 0;
+  m_overflows = 0;
   err_code = nrf_drv_rtc_init(&rtc, &config, rtc_handler);
   //Power on RTC instance before clearing the counter and enabling overflow
   nrf_drv_rtc_enable(&rtc);
@@ -127,8 +160,28 @@ uint64_t ruuvi_interface_rtc_millis(void)
 {
   if(false == m_is_init) { return RUUVI_DRIVER_UINT64_INVALID; }
 
-  uint64_t ms = nrf_drv_rtc_counter_get(&rtc) + ticks;
-  return ((ms * 1000) / 32768);
+  // 1000 / 32768 == 125 / 4096, exact without division.
+  return (rtc_ticks_read() * 125U) >> 12;
+}
+
+uint64_t ruuvi_interface_rtc_micros(void)
+{
+  if(false == m_is_init) { return RUUVI_DRIVER_UINT64_INVALID; }
+
+  // 1000000 / 32768 == 15625 / 512, exact without division.
+  return (rtc_ticks_read() * 15625U) >> 9;
+}
+
+uint64_t ruuvi_interface_rtc_ticks(void)
+{
+  if(false == m_is_init) { return RUUVI_DRIVER_UINT64_INVALID; }
+
+  return rtc_ticks_read();
+}
+
+uint32_t ruuvi_interface_rtc_ticks_per_second(void)
+{
+  return 32768U;
 }
 
 
@@ -0,0 +1,98 @@
+#ifndef RUUVI_NRF5_SDK15_TIMER_INSTANCES_H
+#define RUUVI_NRF5_SDK15_TIMER_INSTANCES_H
+#include "ruuvi_driver_enabled_modules.h"
+/**
+ * @addtogroup Timer
+ * @{
+ */
+/**
+* @file ruuvi_nrf5_sdk15_timer_instances.h
+* @author Otso Jousimaa <otso@ojousima.net>
+* @date 2019-12-16
+* @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+*
+* Allocation of hardware TIMER instances to nRF5 SDK15 platform modules.
+*
+* nRF52832 has TIMER0 ... TIMER4 and TIMER0 is reserved by the SoftDevice.
+*
+* | TIMER | Owner                | Enabled by                         |
+* |-------|----------------------|------------------------------------|
+* | 0     | SoftDevice           |                                    |
+* | 1     | ADC stream sampling  | RUUVI_INTERFACE_ADC_STREAM_ENABLED |
+* | 2     | ADC droop sampling   | RUUVI_INTERFACE_ADC_DROOP_ENABLED  |
+* | 3     | UART receive idle    | RUUVI_NRF5_SDK15_UART_ENABLED      |
+* | 4     | UART receive counter | RUUVI_NRF5_SDK15_UART_ENABLED      |
+* | 1...3 | Bus statistics clock | RUUVI_INTERFACE_BUS_STATS_ENABLED  |
+*
+* Bus statistics are a diagnostic feature and take the first instance left free by
+* modules above. If every instance is taken, define BUS_STATS_TIMER_INSTANCE and move
+* the colliding module in application configuration. Any instance can be overridden,
+* collisions between enabled modules are rejected at compile time.
+* TIMERn_ENABLED of each used instance must be set in sdk_config.h.
+*/
+
+#define RUUVI_NRF5_SDK15_TIMER_ADC_STREAM_USED (RUUVI_NRF5_SDK15_NRF52832_ADC_ENABLED \
+    && RUUVI_INTERFACE_ADC_STREAM_ENABLED) //!< ADC stream owns a TIMER.
+#define RUUVI_NRF5_SDK15_TIMER_ADC_DROOP_USED (RUUVI_NRF5_SDK15_NRF52832_ADC_ENABLED \
+    && RUUVI_INTERFACE_ADC_DROOP_ENABLED) //!< ADC droop owns a TIMER.
+#define RUUVI_NRF5_SDK15_TIMER_UART_USED RUUVI_NRF5_SDK15_UART_ENABLED //!< UART owns two TIMERs.
+
+#ifndef ADC_TIMER_INSTANCE
+  #define ADC_TIMER_INSTANCE 1 //!< TIMER which triggers samples in continuous mode.
+#endif
+#ifndef ADC_DROOP_TIMER_INSTANCE
+  #define ADC_DROOP_TIMER_INSTANCE 2 //!< TIMER which triggers loaded sample after radio event.
+#endif
+#ifndef UART_RX_IDLE_TIMER_INSTANCE
+  #define UART_RX_IDLE_TIMER_INSTANCE 3    //!< TIMER detecting idle line.
+#endif
+#ifndef UART_RX_COUNTER_TIMER_INSTANCE
+  #define UART_RX_COUNTER_TIMER_INSTANCE 4 //!< TIMER counting received bytes.
+#endif
+
+#if RUUVI_NRF5_SDK15_TIMER_UART_USED \
+    && (UART_RX_IDLE_TIMER_INSTANCE == UART_RX_COUNTER_TIMER_INSTANCE)
+  #error "UART receive TIMERs must be separate instances."
+#endif
+#if RUUVI_NRF5_SDK15_TIMER_ADC_STREAM_USED && RUUVI_NRF5_SDK15_TIMER_ADC_DROOP_USED \
+    && (ADC_TIMER_INSTANCE == ADC_DROOP_TIMER_INSTANCE)
+  #error "ADC_TIMER_INSTANCE collides with ADC_DROOP_TIMER_INSTANCE."
+#endif
+#if RUUVI_NRF5_SDK15_TIMER_UART_USED && RUUVI_NRF5_SDK15_TIMER_ADC_STREAM_USED \
+    && ((UART_RX_IDLE_TIMER_INSTANCE == ADC_TIMER_INSTANCE) \
+        || (UART_RX_COUNTER_TIMER_INSTANCE == ADC_TIMER_INSTANCE))
+  #error "UART receive TIMER collides with ADC_TIMER_INSTANCE."
+#endif
+#if RUUVI_NRF5_SDK15_TIMER_UART_USED && RUUVI_NRF5_SDK15_TIMER_ADC_DROOP_USED \
+    && ((UART_RX_IDLE_TIMER_INSTANCE == ADC_DROOP_TIMER_INSTANCE) \
+        || (UART_RX_COUNTER_TIMER_INSTANCE == ADC_DROOP_TIMER_INSTANCE))
+  #error "UART receive TIMER collides with ADC_DROOP_TIMER_INSTANCE."
+#endif
+
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+#ifndef BUS_STATS_TIMER_INSTANCE
+  #if !RUUVI_NRF5_SDK15_TIMER_UART_USED
+    #define BUS_STATS_TIMER_INSTANCE UART_RX_IDLE_TIMER_INSTANCE //!< Free UART idle TIMER.
+  #elif !RUUVI_NRF5_SDK15_TIMER_ADC_STREAM_USED
+    #define BUS_STATS_TIMER_INSTANCE ADC_TIMER_INSTANCE          //!< Free ADC stream TIMER.
+  #elif !RUUVI_NRF5_SDK15_TIMER_ADC_DROOP_USED
+    #define BUS_STATS_TIMER_INSTANCE ADC_DROOP_TIMER_INSTANCE    //!< Free ADC droop TIMER.
+  #else
+    #error "No free TIMER for bus statistics, define BUS_STATS_TIMER_INSTANCE."
+  #endif
+#endif
+#if RUUVI_NRF5_SDK15_TIMER_UART_USED \
+    && ((UART_RX_IDLE_TIMER_INSTANCE == BUS_STATS_TIMER_INSTANCE) \
+        || (UART_RX_COUNTER_TIMER_INSTANCE == BUS_STATS_TIMER_INSTANCE))
+  #error "UART receive TIMER collides with BUS_STATS_TIMER_INSTANCE."
+#endif
+#if RUUVI_NRF5_SDK15_TIMER_ADC_STREAM_USED && (ADC_TIMER_INSTANCE == BUS_STATS_TIMER_INSTANCE)
+  #error "ADC_TIMER_INSTANCE collides with BUS_STATS_TIMER_INSTANCE."
+#endif
+#if RUUVI_NRF5_SDK15_TIMER_ADC_DROOP_USED && (ADC_DROOP_TIMER_INSTANCE == BUS_STATS_TIMER_INSTANCE)
+  #error "ADC_DROOP_TIMER_INSTANCE collides with BUS_STATS_TIMER_INSTANCE."
+#endif
+#endif
+
+/** @} */
+#endif
\ No newline at end of file
@@ -6,6 +6,10 @@
 #include "ruuvi_interface_scheduler.h"
 #include "sdk_errors.h"
 #include "app_scheduler.h"
+#include <stdbool.h>
+
+static bool m_is_init = false; //!< Flag keeping track on if scheduler is initialized.
+static volatile bool m_is_executing = false; //!< Flag set while tasks are executed.
 
 // Ignore give parameters to call the macro with #defined constants
 ruuvi_driver_status_t ruuvi_interface_scheduler_init(size_t event_size,
@@ -18,12 +22,15 @@ ruuvi_driver_status_t ruuvi_interface_scheduler_init(size_t event_size,
 
   APP_SCHED_INIT(RUUVI_NRF5_SDK15_SCHEDULER_DATA_MAX_SIZE,
                  RUUVI_NRF5_SDK15_SCHEDULER_QUEUE_MAX_LENGTH);
+  m_is_init = true;
   return RUUVI_DRIVER_SUCCESS;
 }
 
 ruuvi_driver_status_t ruuvi_interface_scheduler_execute(void)
 {
+  m_is_executing = true;
   app_sched_execute();
+  m_is_executing = false;
   return RUUVI_DRIVER_SUCCESS;
 }
 
@@ -35,4 +42,15 @@ ruuvi_driver_status_t ruuvi_interface_scheduler_event_put(void const* p_event_da
   return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
 }
 
+bool ruuvi_interface_scheduler_is_empty(void)
+{
+  return !m_is_init
+         || (RUUVI_NRF5_SDK15_SCHEDULER_QUEUE_MAX_LENGTH == app_sched_queue_space_get());
+}
+
+bool ruuvi_interface_scheduler_is_executing(void)
+{
+  return m_is_executing;
+}
+
 #endif
\ No newline at end of file
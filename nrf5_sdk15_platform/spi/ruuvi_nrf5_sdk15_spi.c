@@ -49,16 +49,60 @@
 #include "ruuvi_interface_spi.h"
 #include "ruuvi_interface_yield.h"
 #include "ruuvi_nrf5_sdk15_gpio.h"
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+#include "ruuvi_interface_bus_stats.h"
+#include "ruuvi_nrf5_sdk15_bus_stats.h"
+#endif
 
 #include "nrf_drv_spi.h"
 #include "app_util_platform.h"
 #include "nrf_gpio.h"
 
 
+/**
+ * @brief Time limit of running job in blocking call.
+ *
+ * SPI master cannot be held by device, 255 bytes take 2 ms at 1 MHz. Limit only
+ * catches a lost completion interrupt.
+ */
+#define SPI_JOB_TIMEOUT_MS 10
+
 static const nrf_drv_spi_t spi = NRF_DRV_SPI_INSTANCE(
                                    SPI_INSTANCE);  /**< SPI instance. */
 static bool  m_spi_init_done = false;
 
+static nrf_drv_spi_config_t m_spi_config;                   //!< Active configuration.
+static ruuvi_interface_spi_device_t m_bus;                  //!< Settings given at init.
+static ruuvi_interface_spi_mode_t m_mode;                   //!< Active mode.
+static ruuvi_interface_spi_frequency_t m_frequency;         //!< Active frequency.
+/** @brief Pending jobs, sorted by priority. */
+static ruuvi_interface_spi_job_t* m_pending[RUUVI_INTERFACE_SPI_QUEUE_SIZE];
+static size_t m_pending_count = 0;
+static ruuvi_interface_spi_job_t* volatile m_active = NULL; //!< Job in transfer.
+static volatile uint32_t m_job_starts = 0;                  //!< Number of started jobs.
+
+/** @brief State of a blocking call waiting for its job. */
+typedef struct
+{
+  volatile bool done;
+  volatile ruuvi_driver_status_t status;
+} blocking_wait_t;
+
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+static ruuvi_interface_bus_stats_table_t m_stats;
+static uint32_t m_job_start_us = 0; //!< Start time of active job.
+
+static void stats_record(const ruuvi_interface_spi_job_t* const job, const ret_code_t status)
+{
+  const uint32_t latency_us = ruuvi_nrf5_sdk15_bus_stats_clock_us(BUS_STATS_CHANNEL_SPI)
+                              - m_job_start_us;
+  // Full-duplex, shorter buffer is padded.
+  const size_t bytes = (job->tx_len > job->rx_len) ? job->tx_len : job->rx_len;
+  ruuvi_interface_bus_stats_record(&m_stats, job->device->ss.pin, bytes, latency_us,
+                                   ruuvi_nrf5_sdk15_to_ruuvi_error(status));
+}
+#endif
+
 static ruuvi_driver_status_t ruuvi_to_nrf_spi_mode(const ruuvi_interface_spi_mode_t
     ruuvi_mode, nrf_drv_spi_mode_t* nrf_mode)
 {
@@ -85,7 +129,7 @@ static ruuvi_driver_status_t ruuvi_to_nrf_spi_mode(const ruuvi_interface_spi_mod
   }
 }
 
-static ruuvi_driver_status_t ruuvi_to_nrf_spi_freq(const ruuvi_interface_spi_mode_t
+static ruuvi_driver_status_t ruuvi_to_nrf_spi_freq(const ruuvi_interface_spi_frequency_t
     ruuvi_freq, nrf_drv_spi_frequency_t* nrf_freq)
 {
   switch(ruuvi_freq)
@@ -112,6 +156,192 @@ static ruuvi_driver_status_t ruuvi_to_nrf_spi_freq(const ruuvi_interface_spi_mod
 }
 
 
+static void spi_event_handler(nrf_drv_spi_evt_t const* p_event, void* p_context);
+
+// Reinitialize peripheral if device uses other mode or frequency than previous one.
+static ret_code_t bus_configure(const ruuvi_interface_spi_device_t* const device)
+{
+  if(device->mode == m_mode && device->frequency == m_frequency) { return NRF_SUCCESS; }
+
+  nrf_drv_spi_mode_t mode;
+  nrf_drv_spi_frequency_t frequency;
+
+  if(RUUVI_DRIVER_SUCCESS != ruuvi_to_nrf_spi_mode(device->mode, &mode)
+      || RUUVI_DRIVER_SUCCESS != ruuvi_to_nrf_spi_freq(device->frequency, &frequency))
+  {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+
+  nrf_drv_spi_uninit(&spi);
+  m_spi_config.mode = mode;
+  m_spi_config.frequency = frequency;
+  m_mode = device->mode;
+  m_frequency = device->frequency;
+  return nrf_drv_spi_init(&spi, &m_spi_config, spi_event_handler, NULL);
+}
+
+static void ss_write(const ruuvi_interface_spi_job_t* const job,
+                     const ruuvi_interface_gpio_state_t state)
+{
+  if(RUUVI_INTERFACE_GPIO_ID_UNUSED != job->device->ss.pin)
+  {
+    ruuvi_interface_gpio_write(job->device->ss, state);
+  }
+}
+
+// Take highest priority job from queue, NULL if there is none. Call in critical region.
+static ruuvi_interface_spi_job_t* job_take(void)
+{
+  ruuvi_interface_spi_job_t* job = NULL;
+
+  if(m_pending_count > 0)
+  {
+    job = m_pending[0];
+    m_pending_count--;
+    memmove(&m_pending[0], &m_pending[1], m_pending_count * sizeof(m_pending[0]));
+  }
+
+  m_active = job;
+  return job;
+}
+
+static void job_complete(ruuvi_interface_spi_job_t* const job, const ret_code_t status);
+
+// Start given job and any following jobs which fail to start.
+static void job_start(ruuvi_interface_spi_job_t* job)
+{
+  while(NULL != job)
+  {
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+    m_job_start_us = ruuvi_nrf5_sdk15_bus_stats_clock_us(BUS_STATS_CHANNEL_SPI);
+#endif
+    ret_code_t err_code = bus_configure(job->device);
+    ss_write(job, RUUVI_INTERFACE_GPIO_LOW);
+
+    if(NRF_SUCCESS == err_code)
+    {
+      err_code = nrf_drv_spi_transfer(&spi, job->p_tx, job->tx_len, job->p_rx,
+                                      job->rx_len);
+    }
+
+    if(NRF_SUCCESS == err_code)
+    {
+      m_job_starts++;
+      return;
+    }
+
+    ss_write(job, RUUVI_INTERFACE_GPIO_HIGH);
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+    stats_record(job, err_code);
+#endif
+    ruuvi_interface_spi_job_t* next;
+    CRITICAL_REGION_ENTER();
+    next = job_take();
+    CRITICAL_REGION_EXIT();
+    job_complete(job, err_code);
+    job = next;
+  }
+}
+
+static void job_complete(ruuvi_interface_spi_job_t* const job, const ret_code_t status)
+{
+  if(NULL != job->callback)
+  {
+    job->callback(job, ruuvi_nrf5_sdk15_to_ruuvi_error(status));
+  }
+}
+
+static void spi_event_handler(nrf_drv_spi_evt_t const* p_event, void* p_context)
+{
+  ruuvi_interface_spi_job_t* const job = m_active;
+  ruuvi_interface_spi_job_t* next;
+
+  if(NULL == job) { return; }
+
+  ss_write(job, RUUVI_INTERFACE_GPIO_HIGH);
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  stats_record(job, NRF_SUCCESS);
+#endif
+  CRITICAL_REGION_ENTER();
+  next = job_take();
+  CRITICAL_REGION_EXIT();
+  // Keep bus busy while application processes the result.
+  job_start(next);
+  job_complete(job, NRF_SUCCESS);
+}
+
+static void blocking_complete(ruuvi_interface_spi_job_t* const job,
+                              const ruuvi_driver_status_t status)
+{
+  blocking_wait_t* const wait = (blocking_wait_t*) job->p_context;
+  wait->status = status;
+  wait->done = true;
+}
+
+// Stop the running job and fail it, i.e. if its completion interrupt was lost.
+// Job is not touched if another one has been started since starts was read.
+static void job_abort(const uint32_t starts)
+{
+  ruuvi_interface_spi_job_t* job;
+  ruuvi_interface_spi_job_t* next = NULL;
+  CRITICAL_REGION_ENTER();
+  job = (starts == m_job_starts) ? m_active : NULL;
+
+  if(NULL != job)
+  {
+    nrf_drv_spi_abort(&spi);
+    next = job_take();
+  }
+
+  CRITICAL_REGION_EXIT();
+
+  if(NULL == job) { return; }
+
+  ss_write(job, RUUVI_INTERFACE_GPIO_HIGH);
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  stats_record(job, NRF_ERROR_TIMEOUT);
+#endif
+  job_start(next);
+  job_complete(job, NRF_ERROR_TIMEOUT);
+}
+
+/**
+ * @brief Run a job and sleep until it completes.
+ *
+ * Completion is signaled by SPI interrupt, caller which it cannot preempt would
+ * wait forever. Timeout is counted from the start of the running job, which may be
+ * queued before this one.
+ */
+static ruuvi_driver_status_t job_run_blocking(ruuvi_interface_spi_job_t* const job)
+{
+  if(0 != __get_PRIMASK() || m_spi_config.irq_priority >= current_int_priority_get())
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_STATE;
+  }
+
+  blocking_wait_t wait = { .done = false, .status = RUUVI_DRIVER_SUCCESS };
+  job->callback = blocking_complete;
+  job->p_context = &wait;
+  ruuvi_driver_status_t err_code = ruuvi_interface_spi_job_schedule(job);
+
+  if(RUUVI_DRIVER_SUCCESS != err_code) { return err_code; }
+
+  while(!wait.done)
+  {
+    const uint32_t starts = m_job_starts;
+
+    // Running job has hung if no job has been started while waiting.
+    if(RUUVI_DRIVER_ERROR_TIMEOUT == ruuvi_interface_yield_wait(&wait.done,
+        SPI_JOB_TIMEOUT_MS)
+        && starts == m_job_starts)
+    {
+      job_abort(starts);
+    }
+  }
+
+  return wait.status;
+}
+
 ruuvi_driver_status_t ruuvi_interface_spi_init(const ruuvi_interface_spi_init_config_t*
     config)
 {
@@ -134,9 +364,24 @@ ruuvi_driver_status_t ruuvi_interface_spi_init(const ruuvi_interface_spi_init_co
   spi_config.frequency    = frequency;
   spi_config.mode         = mode;
   spi_config.bit_order    = NRF_DRV_SPI_BIT_ORDER_MSB_FIRST;
-  // Use blocking mode by using NULL as event handler
+  // Jobs are completed in interrupt, blocking calls wait for their job.
   ret_code_t err_code = NRF_SUCCESS;
-  err_code = nrf_drv_spi_init(&spi, &spi_config, NULL, NULL);
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  // TIMER of statistics may be taken by another module, report the conflict.
+  err_code = ruuvi_nrf5_sdk15_bus_stats_clock_start();
+
+  if(NRF_SUCCESS != err_code) { return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code); }
+
+#endif
+  err_code = nrf_drv_spi_init(&spi, &spi_config, spi_event_handler, NULL);
+  m_spi_config = spi_config;
+  m_bus.ss.pin = RUUVI_INTERFACE_GPIO_ID_UNUSED;
+  m_bus.mode = config->mode;
+  m_bus.frequency = config->frequency;
+  m_mode = config->mode;
+  m_frequency = config->frequency;
+  m_pending_count = 0;
+  m_active = NULL;
 
   for(size_t ii = 0; ii < config->ss_pins_number; ii++)
   {
@@ -166,6 +411,61 @@ ruuvi_driver_status_t ruuvi_interface_spi_uninit()
   return RUUVI_DRIVER_SUCCESS;
 }
 
+ruuvi_driver_status_t ruuvi_interface_spi_job_schedule(ruuvi_interface_spi_job_t* const
+    job)
+{
+  if(NULL == job || NULL == job->device) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if((NULL == job->p_tx && 0 != job->tx_len) || (NULL == job->p_rx && 0 != job->rx_len))
+  {
+    return RUUVI_DRIVER_ERROR_NULL;
+  }
+
+  if(!m_spi_init_done) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  ruuvi_interface_spi_job_t* start = NULL;
+  CRITICAL_REGION_ENTER();
+
+  if(RUUVI_INTERFACE_SPI_QUEUE_SIZE <= m_pending_count) { err_code = RUUVI_DRIVER_ERROR_NO_MEM; }
+  else
+  {
+    // Insert after jobs of equal or higher priority.
+    size_t index = m_pending_count;
+
+    while(index > 0 && m_pending[index - 1]->priority < job->priority) { index--; }
+
+    memmove(&m_pending[index + 1], &m_pending[index],
+            (m_pending_count - index) * sizeof(m_pending[0]));
+    m_pending[index] = job;
+    m_pending_count++;
+
+    if(NULL == m_active) { start = job_take(); }
+  }
+
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+
+  // Stats are written in interrupt context while jobs are running.
+  if(RUUVI_DRIVER_ERROR_NO_MEM == err_code)
+  {
+    ruuvi_interface_bus_stats_record(&m_stats, job->device->ss.pin, 0, 0, err_code);
+  }
+
+#endif
+  CRITICAL_REGION_EXIT();
+  job_start(start);
+  return err_code;
+}
+
+ruuvi_interface_bus_stats_table_t* ruuvi_interface_spi_stats_get(void)
+{
+#if RUUVI_INTERFACE_BUS_STATS_ENABLED
+  return &m_stats;
+#else
+  return NULL;
+#endif
+}
+
 ruuvi_driver_status_t ruuvi_interface_spi_xfer_blocking(const uint8_t* tx,
     const size_t tx_len, uint8_t* rx, const size_t rx_len)
 {
@@ -174,9 +474,69 @@ ruuvi_driver_status_t ruuvi_interface_spi_xfer_blocking(const uint8_t* tx,
 
   if((NULL == tx && 0 != tx_len) || (NULL == rx && 0 != rx_len)) { return RUUVI_DRIVER_ERROR_NULL; }
 
-  ret_code_t err_code = NRF_SUCCESS;
-  err_code |= nrf_drv_spi_transfer(&spi, tx, tx_len, rx, rx_len);
-  return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
+  ruuvi_interface_spi_job_t job =
+  {
+    .device = &m_bus,
+    .p_tx   = tx,
+    .tx_len = tx_len,
+    .p_rx   = rx,
+    .rx_len = rx_len
+  };
+  return job_run_blocking(&job);
+}
+
+// nRF52832 SPIM has no hardware slave select, pin is driven around the DMA transfer.
+ruuvi_driver_status_t ruuvi_interface_spi_register_read(const ruuvi_interface_gpio_id_t ss,
+    const uint8_t command, uint8_t* const p_rx, const size_t rx_len)
+{
+  if(!m_spi_init_done) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  if(NULL == p_rx) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(RUUVI_INTERFACE_SPI_REGISTER_MAX_LEN < rx_len) { return RUUVI_DRIVER_ERROR_INVALID_LENGTH; }
+
+  ruuvi_interface_spi_device_t device = m_bus;
+  device.ss = ss;
+  // Command and payload are contiguous for one DMA transaction. Buffer of each call
+  // is its own as calls may preempt each other, and lives until job completes.
+  // EasyDMA can only read RAM, command parameter might be in flash.
+  uint8_t buffer[RUUVI_INTERFACE_SPI_REGISTER_MAX_LEN + 1];
+  buffer[0] = command;
+  // Command is clocked out first, ORC fills TX while payload is clocked in.
+  ruuvi_interface_spi_job_t job =
+  {
+    .device = &device,
+    .p_tx   = buffer,
+    .tx_len = 1,
+    .p_rx   = buffer,
+    .rx_len = rx_len + 1
+  };
+  ruuvi_driver_status_t err_code = job_run_blocking(&job);
+  memcpy(p_rx, buffer + 1, rx_len);
+  return err_code;
+}
+
+ruuvi_driver_status_t ruuvi_interface_spi_register_write(const ruuvi_interface_gpio_id_t ss,
+    const uint8_t command, const uint8_t* const p_tx, const size_t tx_len)
+{
+  if(!m_spi_init_done) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  if(NULL == p_tx) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(RUUVI_INTERFACE_SPI_REGISTER_MAX_LEN < tx_len) { return RUUVI_DRIVER_ERROR_INVALID_LENGTH; }
+
+  ruuvi_interface_spi_device_t device = m_bus;
+  device.ss = ss;
+  uint8_t buffer[RUUVI_INTERFACE_SPI_REGISTER_MAX_LEN + 1];
+  buffer[0] = command;
+  memcpy(buffer + 1, p_tx, tx_len);
+  ruuvi_interface_spi_job_t job =
+  {
+    .device = &device,
+    .p_tx   = buffer,
+    .tx_len = tx_len + 1
+  };
+  return job_run_blocking(&job);
 }
 
-#endif
\ No newline at end of file
+#endif
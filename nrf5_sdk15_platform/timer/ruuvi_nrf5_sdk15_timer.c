@@ -9,110 +9,65 @@
 #include "nrf_drv_clock.h"
 #include "sdk_errors.h"
 #include "app_timer.h"
+#include "app_util_platform.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 
-#if APPLICATION_TIMER_MAX_INSTANCES > 10
-  #error "Allocating over 10 timers is not supported"
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 9
-  APP_TIMER_DEF(timer_9);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 8
-  APP_TIMER_DEF(timer_8);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 7
-  APP_TIMER_DEF(timer_7);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 6
-  APP_TIMER_DEF(timer_6);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 5
-  APP_TIMER_DEF(timer_5);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 4
-  APP_TIMER_DEF(timer_4);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 3
-  APP_TIMER_DEF(timer_3);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 2
-  APP_TIMER_DEF(timer_2);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 1
-  APP_TIMER_DEF(timer_1);
-#endif
-#if APPLICATION_TIMER_MAX_INSTANCES > 0
-  APP_TIMER_DEF(timer_0);
-#endif
 #if 0 >= APPLICATION_TIMER_MAX_INSTANCES
   #error "No instances enabled for application timer"
 #endif
 
-static uint8_t timer_idx = 0;  ///< Counter to next timer to allocate.
+/** @brief Longest hardware timeout of soft timers, keeps tick counter reads within
+ *         half of 24-bit RTC range. */
+#define SOFT_TIMER_MAX_ARM_TICKS (1UL << 22)
+/** @brief Longest soft timer interval, keeps signed deadline comparison valid. */
+#define SOFT_TIMER_MAX_TICKS     (1UL << 30)
+
+static app_timer_t m_timers[APPLICATION_TIMER_MAX_INSTANCES]; ///< Pool of timers.
+static bool m_timer_used[APPLICATION_TIMER_MAX_INSTANCES];    ///< Allocation flags of pool.
 static bool m_is_init = false; ///< Flag keeping track on if module is initialized.
 
+static app_timer_id_t m_soft_timer = NULL;               ///< Hardware timer of soft timers.
+static ruuvi_interface_timer_soft_t* m_soft_head = NULL; ///< Soft timer with nearest deadline.
+static uint32_t m_soft_ticks = 0; ///< Tick counter extended to 32 bits.
+static uint32_t m_soft_cnt = 0;   ///< RTC counter at last update of m_soft_ticks.
+
 /**
- * @brief return free timer ID
+ * @brief return free timer ID, NULL if pool is exhausted.
  */
 static app_timer_id_t get_timer_id(void)
 {
-  switch(timer_idx++)
+  app_timer_id_t tid = NULL;
+  CRITICAL_REGION_ENTER();
+
+  for(size_t ii = 0; ii < APPLICATION_TIMER_MAX_INSTANCES; ii++)
   {
-      #if APPLICATION_TIMER_MAX_INSTANCES > 0
-
-    case 0:
-      return timer_0;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 1
-
-    case 1:
-      return timer_1;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 2
-
-    case 2:
-      return timer_2;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 3
-
-    case 3:
-      return timer_3;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 4
-
-    case 4:
-      return timer_4;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 5
-
-    case 5:
-      return timer_5;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 6
-
-    case 6:
-      return timer_6;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 7
-
-    case 7:
-      return timer_7;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 8
-
-    case 8:
-      return timer_8;
-      #endif
-      #if APPLICATION_TIMER_MAX_INSTANCES > 9
-
-    case 9:
-      return timer_9;
-      #endif
-
-    default:
-      return NULL;
+    if(!m_timer_used[ii])
+    {
+      m_timer_used[ii] = true;
+      tid = &m_timers[ii];
+      break;
+    }
   }
+
+  CRITICAL_REGION_EXIT();
+  return tid;
+}
+
+/**
+ * @brief return index of timer in pool, APPLICATION_TIMER_MAX_INSTANCES if not in pool.
+ */
+static size_t timer_index(const ruuvi_interface_timer_id_t timer_id)
+{
+  const app_timer_t* const timer = (const app_timer_t*) timer_id;
+
+  if(timer < m_timers || timer >= (m_timers + APPLICATION_TIMER_MAX_INSTANCES))
+  {
+    return APPLICATION_TIMER_MAX_INSTANCES;
+  }
+
+  return (size_t)(timer - m_timers);
 }
 
 ruuvi_driver_status_t ruuvi_interface_timer_init(void)
@@ -147,11 +102,15 @@ ruuvi_driver_status_t ruuvi_interface_timer_create(ruuvi_interface_timer_id_t*
   if(RUUVI_INTERFACE_TIMER_MODE_REPEATED == mode) { nrf_mode = APP_TIMER_MODE_REPEATED; }
 
   app_timer_id_t tid = get_timer_id();
+
+  if(NULL == tid) { return RUUVI_DRIVER_ERROR_RESOURCES; }
+
   ret_code_t err_code = app_timer_create(&tid,
                                          nrf_mode,
                                          (app_timer_timeout_handler_t)timeout_handler);
 
   if(NRF_SUCCESS == err_code) {*p_timer_id = (void*)tid;}
+  else { ruuvi_interface_timer_delete(tid); }
 
   return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
 }
@@ -178,4 +137,222 @@ ruuvi_driver_status_t ruuvi_interface_timer_stop(ruuvi_interface_timer_id_t time
   return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
 }
 
+ruuvi_driver_status_t ruuvi_interface_timer_delete(ruuvi_interface_timer_id_t timer_id)
+{
+  const size_t index = timer_index(timer_id);
+
+  if(APPLICATION_TIMER_MAX_INSTANCES <= index || !m_timer_used[index])
+  {
+    return RUUVI_DRIVER_ERROR_INVALID_PARAM;
+  }
+
+  app_timer_stop((app_timer_id_t)timer_id);
+  CRITICAL_REGION_ENTER();
+  m_timer_used[index] = false;
+  CRITICAL_REGION_EXIT();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+/**
+ * @brief Get tick counter extended to 32 bits. Call in critical region.
+ *
+ * Counter must be read at least once per half RTC period, which armed hardware
+ * timer guarantees while any soft timer runs.
+ */
+static uint32_t soft_now(void)
+{
+  const uint32_t cnt = app_timer_cnt_get();
+  m_soft_ticks += app_timer_cnt_diff_compute(cnt, m_soft_cnt);
+  m_soft_cnt = cnt;
+  return m_soft_ticks;
+}
+
+/** @brief Insert timer in order of deadline, after timers of same deadline. */
+static void soft_insert(ruuvi_interface_timer_soft_t* const timer)
+{
+  ruuvi_interface_timer_soft_t** pp_next = &m_soft_head;
+
+  while(NULL != *pp_next && 0 <= (int32_t)(timer->deadline - (*pp_next)->deadline))
+  {
+    pp_next = &(*pp_next)->p_next;
+  }
+
+  timer->p_next = *pp_next;
+  *pp_next = timer;
+}
+
+static void soft_remove(ruuvi_interface_timer_soft_t* const timer)
+{
+  ruuvi_interface_timer_soft_t** pp_next = &m_soft_head;
+
+  while(NULL != *pp_next && timer != *pp_next)
+  {
+    pp_next = &(*pp_next)->p_next;
+  }
+
+  if(NULL != *pp_next) { *pp_next = timer->p_next; }
+
+  timer->p_next = NULL;
+}
+
+/** @brief Arm hardware timer for nearest deadline. Call in critical region. */
+static void soft_arm(void)
+{
+  app_timer_stop(m_soft_timer);
+
+  if(NULL == m_soft_head) { return; }
+
+  const int32_t remaining = (int32_t)(m_soft_head->deadline - soft_now());
+  uint32_t ticks = (uint32_t) remaining;
+
+  if(APP_TIMER_MIN_TIMEOUT_TICKS > remaining) { ticks = APP_TIMER_MIN_TIMEOUT_TICKS; }
+
+  if(SOFT_TIMER_MAX_ARM_TICKS < ticks) { ticks = SOFT_TIMER_MAX_ARM_TICKS; }
+
+  app_timer_start(m_soft_timer, ticks, NULL);
+}
+
+/** @brief Run handlers of all expired soft timers and rearm hardware timer. */
+static void soft_timeout_handler(void* p_context)
+{
+  bool expired;
+
+  do
+  {
+    ruuvi_timer_timeout_handler_t handler = NULL;
+    void* p_handler_context = NULL;
+    CRITICAL_REGION_ENTER();
+    const uint32_t now = soft_now();
+    ruuvi_interface_timer_soft_t* const timer = m_soft_head;
+    expired = (NULL != timer) && (0 >= (int32_t)(timer->deadline - now));
+
+    if(expired)
+    {
+      m_soft_head = timer->p_next;
+      handler = timer->handler;
+      p_handler_context = timer->p_context;
+
+      if(0 != timer->period)
+      {
+        timer->deadline += timer->period;
+
+        // Skip missed periods instead of calling handler in a burst.
+        if(0 >= (int32_t)(timer->deadline - now)) { timer->deadline = now + timer->period; }
+
+        soft_insert(timer);
+      }
+      else
+      {
+        timer->p_next = NULL;
+        timer->running = false;
+      }
+    }
+    else
+    {
+      soft_arm();
+    }
+
+    CRITICAL_REGION_EXIT();
+
+    if(NULL != handler) { handler(p_handler_context); }
+  } while(expired);
+}
+
+ruuvi_driver_status_t ruuvi_interface_timer_soft_start(
+  ruuvi_interface_timer_soft_t* const timer, const ruuvi_interface_timer_mode_t mode,
+  const uint32_t ms, const ruuvi_timer_timeout_handler_t handler, void* const p_context)
+{
+  if(NULL == timer || NULL == handler) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(!m_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  // APP_TIMER_TICKS truncates to 32 bits, convert in 64 bits to catch overlong timeouts.
+  const uint64_t ticks = ((uint64_t) ms * APP_TIMER_CLOCK_FREQ)
+                         / (1000U * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1));
+
+  if(0 == ms || SOFT_TIMER_MAX_TICKS < ticks) { return RUUVI_DRIVER_ERROR_INVALID_PARAM; }
+
+  if(NULL == m_soft_timer)
+  {
+    ruuvi_interface_timer_id_t tid = NULL;
+    ruuvi_driver_status_t err_code = ruuvi_interface_timer_create(&tid,
+                                     RUUVI_INTERFACE_TIMER_MODE_SINGLE_SHOT,
+                                     soft_timeout_handler);
+
+    if(RUUVI_DRIVER_SUCCESS != err_code) { return RUUVI_DRIVER_ERROR_RESOURCES; }
+
+    bool created = false;
+    CRITICAL_REGION_ENTER();
+
+    if(NULL == m_soft_timer)
+    {
+      m_soft_timer = (app_timer_id_t) tid;
+      created = true;
+    }
+
+    CRITICAL_REGION_EXIT();
+
+    // Another context allocated the timer first.
+    if(!created) { ruuvi_interface_timer_delete(tid); }
+  }
+
+  CRITICAL_REGION_ENTER();
+
+  if(timer->running) { soft_remove(timer); }
+
+  timer->handler = handler;
+  timer->p_context = p_context;
+  timer->period = (RUUVI_INTERFACE_TIMER_MODE_REPEATED == mode) ? (uint32_t) ticks : 0;
+  timer->deadline = soft_now() + (uint32_t) ticks;
+  timer->running = true;
+  soft_insert(timer);
+
+  if(m_soft_head == timer) { soft_arm(); }
+
+  CRITICAL_REGION_EXIT();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_timer_soft_stop(
+  ruuvi_interface_timer_soft_t* const timer)
+{
+  if(NULL == timer) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  CRITICAL_REGION_ENTER();
+
+  if(timer->running)
+  {
+    const bool was_head = (m_soft_head == timer);
+    soft_remove(timer);
+    timer->running = false;
+
+    if(was_head) { soft_arm(); }
+  }
+
+  CRITICAL_REGION_EXIT();
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+ruuvi_driver_status_t ruuvi_interface_timer_soft_next_us(uint32_t* const us)
+{
+  if(NULL == us) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_ERROR_NOT_FOUND;
+  CRITICAL_REGION_ENTER();
+
+  if(NULL != m_soft_head)
+  {
+    const int32_t remaining = (int32_t)(m_soft_head->deadline - soft_now());
+    const uint64_t ticks = (0 < remaining) ? (uint64_t) remaining : 0;
+    // 1 000 000 / 32768 Hz = 15625 / 512.
+    const uint64_t remaining_us = (ticks * 15625U * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))
+                                  >> 9;
+    *us = (UINT32_MAX < remaining_us) ? UINT32_MAX : (uint32_t) remaining_us;
+    err_code = RUUVI_DRIVER_SUCCESS;
+  }
+
+  CRITICAL_REGION_EXIT();
+  return err_code;
+}
+
 #endif
\ No newline at end of file
@@ -6,7 +6,34 @@
 #include "ruuvi_interface_yield.h"
 #include "ruuvi_nrf5_sdk15_error.h"
 #include "ruuvi_nrf5_sdk15_gpio.h"
+#include "ruuvi_nrf5_sdk15_timer_instances.h"
+#include "app_util_platform.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_drv_timer.h"
 #include "nrfx_uarte.h"
+#include <string.h>
+
+/**
+ * @addtogroup UART
+ */
+/** @{ */
+/**
+ * @file ruuvi_nrf5_sdk15_uart.c
+ * @author Otso Jousimaa <otso@ojousima.net>
+ * @date 2019-12-12
+ * @copyright Ruuvi Innovations Ltd, license BSD-3-Clause.
+ * @brief Asynchronous UART on nRF52832 UARTE.
+ *
+ * Transmit ring is drained by chained DMA transfers, each transfer sends the
+ * contiguous part of the ring up to the EasyDMA limit.
+ *
+ * Reception alternates between two DMA buffers and copies completed buffers into
+ * receive ring. UARTE has no idle line event, so received bytes are counted by
+ * a TIMER in counter mode and another TIMER is cleared on every byte through the
+ * same PPI channel. When the second TIMER reaches idle timeout, bytes already in the
+ * active DMA buffer are copied to the ring without stopping reception. Idle TIMER
+ * stops on timeout and next received byte starts it again.
+ */
 
 #ifndef RUUVI_NRF5_SDK15_UART_LOG_LEVEL
   #define LOG_LEVEL RUUVI_INTERFACE_LOG_INFO
@@ -16,8 +43,44 @@
 #define LOG(msg)  (ruuvi_interface_log(LOG_LEVEL, msg))
 #define LOGD(msg)  (ruuvi_interface_log(RUUVI_INTERFACE_LOG_DEBUG, msg))
 
+/** @brief Frame of start bit, 8 data bits, parity and stop bit. */
+#define UART_BITS_PER_BYTE 11
+/** @brief Maximum length of one DMA transfer, MAXCNT is 8 bits on nRF52832. */
+#define UART_DMA_MAX_LEN 255
+
+#ifndef UART_RX_DMA_SIZE
+  #define UART_RX_DMA_SIZE 64 //!< Size of one of the two receive DMA buffers.
+#endif
+#ifndef UART_RX_IDLE_BYTES
+  #define UART_RX_IDLE_BYTES 4 //!< Silence on line, in byte times, which flushes DMA buffer.
+#endif
+
 static bool m_uart_is_init = false;
 static nrfx_uarte_t m_uart = NRFX_UARTE_INSTANCE(0);
+static uint32_t m_bauds = 115200;
+static ruuvi_interface_uart_rx_cb_t m_on_rx = NULL;
+static ruuvi_interface_uart_tx_cb_t m_on_tx = NULL;
+
+static uint8_t m_tx_ring[RUUVI_INTERFACE_UART_TX_RING_SIZE];
+static volatile size_t m_tx_head = 0;     //!< Written by sender.
+static volatile size_t m_tx_tail = 0;     //!< Written in interrupt.
+static volatile bool m_tx_active = false; //!< DMA transfer is running.
+static volatile bool m_tx_done = false;   //!< A DMA transfer has completed.
+
+static uint8_t m_rx_dma[2][UART_RX_DMA_SIZE];
+static uint8_t m_rx_ring[RUUVI_INTERFACE_UART_RX_RING_SIZE];
+static volatile size_t m_rx_head = 0;    //!< Written in interrupt.
+static volatile size_t m_rx_tail = 0;    //!< Written by reader.
+static uint8_t m_rx_active = 0;          //!< DMA buffer being filled.
+static size_t m_rx_offset = 0;           //!< Bytes copied from active DMA buffer.
+static uint32_t m_rx_copied = 0;         //!< Bytes copied since reception started.
+
+static const nrf_drv_timer_t m_rx_counter = NRF_DRV_TIMER_INSTANCE(
+      UART_RX_COUNTER_TIMER_INSTANCE);
+static const nrf_drv_timer_t m_rx_idle = NRF_DRV_TIMER_INSTANCE(
+      UART_RX_IDLE_TIMER_INSTANCE);
+static nrf_ppi_channel_t m_rx_ppi; // PPI channel from received byte to count and idle clear.
+static nrf_ppi_channel_t m_rx_start_ppi; // PPI channel from received byte to idle start.
 
 // Convert constants from Ruuvi to nRF52 SDK
 static nrf_uarte_baudrate_t ruuvi_to_nrf_baudrate(const ruuvi_interface_uart_baud_t baud)
@@ -27,27 +90,163 @@ static nrf_uarte_baudrate_t ruuvi_to_nrf_baudrate(const ruuvi_interface_uart_bau
     case RUUVI_INTERFACE_UART_BAUD_9600:
       return NRF_UARTE_BAUDRATE_9600;
 
+    case RUUVI_INTERFACE_UART_BAUD_1M:
+      return NRF_UARTE_BAUDRATE_1000000;
+
     case RUUVI_INTERFACE_UART_BAUD_115200:
     default:
       return NRF_UARTE_BAUDRATE_115200;
   }
 }
 
+// Bits per second of a baudrate setting, used for timing.
+static uint32_t ruuvi_baud_to_bps(const ruuvi_interface_uart_baud_t baud)
+{
+  switch(baud)
+  {
+    case RUUVI_INTERFACE_UART_BAUD_9600:
+      return 9600;
+
+    case RUUVI_INTERFACE_UART_BAUD_1M:
+      return 1000000;
+
+    case RUUVI_INTERFACE_UART_BAUD_115200:
+    default:
+      return 115200;
+  }
+}
+
+static uint32_t ruuvi_to_nrf_uart_pin(const ruuvi_interface_gpio_id_t pin)
+{
+  if(RUUVI_INTERFACE_GPIO_ID_UNUSED == pin.pin) { return NRF_UARTE_PSEL_DISCONNECTED; }
+
+  return ruuvi_to_nrf_pin_map(pin);
+}
+
+static size_t tx_free(void)
+{
+  return (RUUVI_INTERFACE_UART_TX_RING_SIZE - 1)
+         - ((m_tx_head + RUUVI_INTERFACE_UART_TX_RING_SIZE - m_tx_tail)
+            % RUUVI_INTERFACE_UART_TX_RING_SIZE);
+}
+
+// Start DMA transfer of contiguous data at tail of ring. Call with interrupts disabled.
+static void tx_start(void)
+{
+  const size_t head = m_tx_head;
+  const size_t tail = m_tx_tail;
+
+  if(head == tail)
+  {
+    m_tx_active = false;
+    return;
+  }
+
+  size_t len = (head > tail) ? (head - tail) : (RUUVI_INTERFACE_UART_TX_RING_SIZE - tail);
+
+  if(UART_DMA_MAX_LEN < len) { len = UART_DMA_MAX_LEN; }
+
+  m_tx_active = (NRF_SUCCESS == nrfx_uarte_tx(&m_uart, m_tx_ring + tail, len));
+}
+
+static void rx_ring_put(const uint8_t* const data, const size_t len)
+{
+  size_t head = m_rx_head;
+
+  for(size_t ii = 0; ii < len; ii++)
+  {
+    const size_t next = (head + 1) % RUUVI_INTERFACE_UART_RX_RING_SIZE;
+
+    // Ring is full, drop the rest.
+    if(next == m_rx_tail) { break; }
+
+    m_rx_ring[head] = data[ii];
+    head = next;
+  }
+
+  m_rx_head = head;
+}
+
+static size_t rx_available(void)
+{
+  return (m_rx_head + RUUVI_INTERFACE_UART_RX_RING_SIZE - m_rx_tail)
+         % RUUVI_INTERFACE_UART_RX_RING_SIZE;
+}
+
+static void rx_notify(void)
+{
+  const size_t available = rx_available();
+
+  if(NULL != m_on_rx && 0 != available) { m_on_rx(available); }
+}
+
+// Queue both DMA buffers and restart byte count.
+static void rx_start(void)
+{
+  m_rx_active = 0;
+  m_rx_offset = 0;
+  m_rx_copied = 0;
+  nrf_drv_timer_clear(&m_rx_counter);
+  nrfx_uarte_rx(&m_uart, m_rx_dma[0], UART_RX_DMA_SIZE);
+  nrfx_uarte_rx(&m_uart, m_rx_dma[1], UART_RX_DMA_SIZE);
+}
+
+// Line idle, copy bytes received into active buffer so far. Same priority as UARTE.
+static void rx_idle_handler(nrf_timer_event_t event_type, void* p_context)
+{
+  const uint32_t received = nrf_drv_timer_capture(&m_rx_counter, NRF_TIMER_CC_CHANNEL0);
+  size_t pending = received - m_rx_copied;
+
+  // Rest of bytes are in next buffer, which is copied on its completion.
+  if(pending > (UART_RX_DMA_SIZE - m_rx_offset)) { pending = UART_RX_DMA_SIZE - m_rx_offset; }
+
+  if(0 == pending) { return; }
+
+  rx_ring_put(m_rx_dma[m_rx_active] + m_rx_offset, pending);
+  m_rx_offset += pending;
+  m_rx_copied += pending;
+  rx_notify();
+}
+
 // Handle UART events
 static void uart_handler(nrfx_uarte_event_t const* p_event, void* p_context)
 {
   switch(p_event->type)
   {
     case NRFX_UARTE_EVT_TX_DONE: ///< Requested TX transfer completed.
-      LOG("TX\r\n");
+      m_tx_tail = (m_tx_tail + p_event->data.rxtx.bytes) % RUUVI_INTERFACE_UART_TX_RING_SIZE;
+      // Keep line busy while application processes the event.
+      CRITICAL_REGION_ENTER();
+      tx_start();
+      CRITICAL_REGION_EXIT();
+      m_tx_done = true;
+
+      if(NULL != m_on_tx) { m_on_tx(tx_free()); }
+
       break;
 
     case NRFX_UARTE_EVT_RX_DONE: ///< Requested RX transfer completed.
-      LOG("RX\r\n");
+    {
+      const size_t bytes = p_event->data.rxtx.bytes;
+
+      if(bytes > m_rx_offset)
+      {
+        rx_ring_put(p_event->data.rxtx.p_data + m_rx_offset, bytes - m_rx_offset);
+        m_rx_copied += bytes - m_rx_offset;
+      }
+
+      // Driver has already switched to the other buffer, queue this one after it.
+      m_rx_active = (m_rx_dma[0] == p_event->data.rxtx.p_data) ? 1 : 0;
+      m_rx_offset = 0;
+      nrfx_uarte_rx(&m_uart, p_event->data.rxtx.p_data, UART_RX_DMA_SIZE);
+      rx_notify();
       break;
+    }
 
     case NRFX_UARTE_EVT_ERROR:   ///< Error reported by UART peripheral.
+      // Reception is aborted on error, data of current buffer is discarded.
       LOG("!\r\n");
+      rx_start();
       break;
 
     default:
@@ -56,27 +255,122 @@ static void uart_handler(nrfx_uarte_event_t const* p_event, void* p_context)
   }
 }
 
+static ruuvi_driver_status_t rx_idle_init(const uint8_t irq_priority)
+{
+  ret_code_t err_code = NRF_SUCCESS;
+  nrf_drv_timer_config_t timer_config = NRF_DRV_TIMER_DEFAULT_CONFIG;
+  timer_config.mode = NRF_TIMER_MODE_COUNTER;
+  timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+  // Counter has no interrupts enabled, handler is never called.
+  const ret_code_t counter_status = nrf_drv_timer_init(&m_rx_counter, &timer_config,
+                                    rx_idle_handler);
+  timer_config.mode = NRF_TIMER_MODE_TIMER;
+  timer_config.frequency = NRF_TIMER_FREQ_1MHz;
+  timer_config.interrupt_priority = irq_priority;
+  const ret_code_t idle_status = nrf_drv_timer_init(&m_rx_idle, &timer_config,
+                                 rx_idle_handler);
+  ret_code_t ppi_status = nrf_drv_ppi_init();
+
+  // PPI may be initialized by another module.
+  if(NRF_ERROR_MODULE_ALREADY_INITIALIZED == ppi_status) { ppi_status = NRF_SUCCESS; }
+
+  const ret_code_t rx_ppi_status = (NRF_SUCCESS == ppi_status) ?
+                                   nrf_drv_ppi_channel_alloc(&m_rx_ppi) : ppi_status;
+  // Channel has only one fork, start of idle timer needs a channel of its own.
+  const ret_code_t start_ppi_status = (NRF_SUCCESS == ppi_status) ?
+                                      nrf_drv_ppi_channel_alloc(&m_rx_start_ppi) : ppi_status;
+  err_code |= counter_status | idle_status | rx_ppi_status | start_ppi_status;
+
+  if(NRF_SUCCESS == err_code)
+  {
+    // Compare fires once per idle period, timer is cleared and started on every byte.
+    // Timer stops on compare to not wrap around and fire again on silent line.
+    const uint32_t idle_us = (UART_RX_IDLE_BYTES * UART_BITS_PER_BYTE * 1000000U) / m_bauds;
+    nrf_drv_timer_extended_compare(&m_rx_idle, NRF_TIMER_CC_CHANNEL0, idle_us,
+                                   NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK
+                                   | NRF_TIMER_SHORT_COMPARE0_STOP_MASK, true);
+    err_code |= nrf_drv_ppi_channel_assign(m_rx_ppi,
+                                           nrfx_uarte_event_address_get(&m_uart, NRF_UARTE_EVENT_RXDRDY),
+                                           nrf_drv_timer_task_address_get(&m_rx_counter, NRF_TIMER_TASK_COUNT));
+    err_code |= nrf_drv_ppi_channel_fork_assign(m_rx_ppi,
+                nrf_drv_timer_task_address_get(&m_rx_idle, NRF_TIMER_TASK_CLEAR));
+    err_code |= nrf_drv_ppi_channel_enable(m_rx_ppi);
+    err_code |= nrf_drv_ppi_channel_assign(m_rx_start_ppi,
+                                           nrfx_uarte_event_address_get(&m_uart, NRF_UARTE_EVENT_RXDRDY),
+                                           nrf_drv_timer_task_address_get(&m_rx_idle, NRF_TIMER_TASK_START));
+    err_code |= nrf_drv_ppi_channel_enable(m_rx_start_ppi);
+  }
+
+  if(NRF_SUCCESS == err_code)
+  {
+    nrf_drv_timer_enable(&m_rx_counter);
+    nrf_drv_timer_enable(&m_rx_idle);
+  }
+  // Release only what was allocated here, resources may belong to other modules.
+  else
+  {
+    if(NRF_SUCCESS == start_ppi_status)
+    {
+      nrf_drv_ppi_channel_disable(m_rx_start_ppi);
+      nrf_drv_ppi_channel_free(m_rx_start_ppi);
+    }
+
+    if(NRF_SUCCESS == rx_ppi_status)
+    {
+      nrf_drv_ppi_channel_disable(m_rx_ppi);
+      nrf_drv_ppi_channel_free(m_rx_ppi);
+    }
+
+    if(NRF_SUCCESS == idle_status) { nrf_drv_timer_uninit(&m_rx_idle); }
+
+    if(NRF_SUCCESS == counter_status) { nrf_drv_timer_uninit(&m_rx_counter); }
+  }
+
+  return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
+}
+
 ruuvi_driver_status_t ruuvi_interface_uart_init(const ruuvi_interface_uart_init_config_t*
     const config)
 {
+  if(NULL == config) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(m_uart_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
   nrfx_err_t nrf_status = NRF_SUCCESS;
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
   nrfx_uarte_config_t nrf_config = NRFX_UARTE_DEFAULT_CONFIG;
   nrf_config.baudrate = ruuvi_to_nrf_baudrate(config->baud);
-  nrf_config.pselcts = ruuvi_to_nrf_pin_map(config->cts);
-  nrf_config.pselcts = ruuvi_to_nrf_pin_map(config->rts);
-  nrf_config.pselcts = ruuvi_to_nrf_pin_map(config->tx);
-  nrf_config.pselcts = ruuvi_to_nrf_pin_map(config->rx);
+  m_bauds = ruuvi_baud_to_bps(config->baud);
+  nrf_config.pselcts = ruuvi_to_nrf_uart_pin(config->cts);
+  nrf_config.pselrts = ruuvi_to_nrf_uart_pin(config->rts);
+  nrf_config.pseltxd = ruuvi_to_nrf_uart_pin(config->tx);
+  nrf_config.pselrxd = ruuvi_to_nrf_uart_pin(config->rx);
   nrf_config.parity  = config->parity ? NRF_UARTE_PARITY_INCLUDED :
                        NRF_UARTE_PARITY_EXCLUDED;
   nrf_config.hwfc    = config->hwfc ? NRF_UARTE_HWFC_ENABLED : NRF_UARTE_HWFC_DISABLED;
+  m_tx_head = 0;
+  m_tx_tail = 0;
+  m_tx_active = false;
+  m_rx_head = 0;
+  m_rx_tail = 0;
   nrf_status |= nrfx_uarte_init(&m_uart, &nrf_config, uart_handler);
+  err_code |= ruuvi_nrf5_sdk15_to_ruuvi_error(nrf_status);
 
-  if(NRF_SUCCESS == nrf_status)
+  if(RUUVI_DRIVER_SUCCESS == err_code)
   {
+    err_code |= rx_idle_init(nrf_config.interrupt_priority);
+
+    // Receive path has released its resources, leave UARTE free for next init.
+    if(RUUVI_DRIVER_SUCCESS != err_code) { nrfx_uarte_uninit(&m_uart); }
+  }
+
+  if(RUUVI_DRIVER_SUCCESS == err_code)
+  {
+    rx_start();
     m_uart_is_init = true;
   }
 
-  return ruuvi_nrf5_sdk15_to_ruuvi_error(nrf_status);
+  return err_code;
 }
 
 bool ruuvi_interface_uart_is_init()
@@ -86,21 +380,131 @@ bool ruuvi_interface_uart_is_init()
 
 ruuvi_driver_status_t ruuvi_interface_uart_uninit()
 {
-  nrfx_uarte_uninit(&m_uart);
+  if(m_uart_is_init)
+  {
+    nrf_drv_ppi_channel_disable(m_rx_ppi);
+    nrf_drv_ppi_channel_free(m_rx_ppi);
+    nrf_drv_ppi_channel_disable(m_rx_start_ppi);
+    nrf_drv_ppi_channel_free(m_rx_start_ppi);
+    nrf_drv_timer_uninit(&m_rx_idle);
+    nrf_drv_timer_uninit(&m_rx_counter);
+    nrfx_uarte_uninit(&m_uart);
+  }
+
+  m_uart_is_init = false;
+  m_tx_active = false;
   return RUUVI_DRIVER_SUCCESS;
 }
 
+ruuvi_driver_status_t ruuvi_interface_uart_send(const uint8_t* const p_tx,
+    const size_t tx_len)
+{
+  if(NULL == p_tx) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  if(!m_uart_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  CRITICAL_REGION_ENTER();
+
+  if(tx_len > tx_free()) { err_code = RUUVI_DRIVER_ERROR_NO_MEM; }
+  else
+  {
+    const size_t head = m_tx_head;
+    const size_t first = RUUVI_INTERFACE_UART_TX_RING_SIZE - head;
+
+    if(tx_len <= first) { memcpy(m_tx_ring + head, p_tx, tx_len); }
+    else
+    {
+      memcpy(m_tx_ring + head, p_tx, first);
+      memcpy(m_tx_ring, p_tx + first, tx_len - first);
+    }
+
+    m_tx_head = (head + tx_len) % RUUVI_INTERFACE_UART_TX_RING_SIZE;
+
+    if(!m_tx_active) { tx_start(); }
+  }
+
+  CRITICAL_REGION_EXIT();
+  return err_code;
+}
+
 ruuvi_driver_status_t ruuvi_interface_uart_send_blocking(const uint8_t* const p_tx,
     const size_t tx_len)
 {
   if(NULL == p_tx) { return RUUVI_DRIVER_ERROR_NULL; }
 
-  nrfx_err_t err_code = NRF_SUCCESS;
-  err_code |= nrfx_uarte_tx(&m_uart, p_tx, tx_len);
+  if(!m_uart_is_init) { return RUUVI_DRIVER_ERROR_INVALID_STATE; }
+
+  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  // Twice the time of a full DMA transfer on wire, CTS may pause transmission.
+  const uint32_t timeout_ms = ((2 * UART_BITS_PER_BYTE * 1000U * UART_DMA_MAX_LEN)
+                               / m_bauds) + 1;
+  size_t sent = 0;
+  bool waiting = true;
+
+  // Queue data as ring drains, then wait until all of it is out.
+  while(RUUVI_DRIVER_SUCCESS == err_code && waiting)
+  {
+    // Clear before checking state to not miss completion.
+    m_tx_done = false;
+    size_t len = tx_len - sent;
 
-  while(NRF_SUCCESS == err_code && nrfx_uarte_tx_in_progress(&m_uart));
+    if(len > tx_free()) { len = tx_free(); }
+
+    if(0 != len)
+    {
+      err_code |= ruuvi_interface_uart_send(p_tx + sent, len);
+      sent += len;
+    }
+    else if(sent < tx_len || m_tx_active)
+    {
+      err_code |= ruuvi_interface_yield_wait(&m_tx_done, timeout_ms);
+    }
+    else { waiting = false; }
+  }
+
+  if(RUUVI_DRIVER_ERROR_TIMEOUT == err_code) { nrfx_uarte_tx_abort(&m_uart); }
 
   return err_code;
 }
 
-#endif
\ No newline at end of file
+size_t ruuvi_interface_uart_tx_free(void)
+{
+  return tx_free();
+}
+
+size_t ruuvi_interface_uart_tx_capacity(void)
+{
+  return RUUVI_INTERFACE_UART_TX_RING_SIZE - 1;
+}
+
+size_t ruuvi_interface_uart_read(uint8_t* const p_rx, const size_t max_len)
+{
+  if(NULL == p_rx) { return 0; }
+
+  size_t read = 0;
+  size_t tail = m_rx_tail;
+  const size_t head = m_rx_head;
+
+  while(read < max_len && tail != head)
+  {
+    p_rx[read++] = m_rx_ring[tail];
+    tail = (tail + 1) % RUUVI_INTERFACE_UART_RX_RING_SIZE;
+  }
+
+  m_rx_tail = tail;
+  return read;
+}
+
+void ruuvi_interface_uart_rx_cb_set(const ruuvi_interface_uart_rx_cb_t cb)
+{
+  m_on_rx = cb;
+}
+
+void ruuvi_interface_uart_tx_cb_set(const ruuvi_interface_uart_tx_cb_t cb)
+{
+  m_on_tx = cb;
+}
+
+/** @} */
+#endif
@@ -8,6 +8,14 @@
  * Implementation for yielding execution or delaying for a given time.
  * Yield enters a low-power system on state, delay blocks and keeps CPU active.
  *
+ * Idle is tickless: all timeouts of this module are soft timers which share one
+ * RTC compare, armed for the nearest deadline. Yield does not sleep if there is
+ * work pending and accounts time slept and woken up by RTC counter of timers.
+ * Scheduled work is not pending for yield called from a scheduled task, as the
+ * queue advances only after the task returns.
+ * Counter runs only while a timer is running unless APP_TIMER_KEEPS_RTC_ACTIVE is set,
+ * spans longer than the 24-bit counter period, 512 s, are accounted modulo the period.
+ *
  */
 #include "ruuvi_driver_enabled_modules.h"
 #if RUUVI_NRF5_SDK15_YIELD_ENABLED
@@ -15,17 +23,25 @@
 #include "ruuvi_interface_log.h"
 #include "ruuvi_interface_yield.h"
 #include "ruuvi_driver_error.h"
+#include "app_util_platform.h"
 #include "nrf_delay.h"
 #include "nrf_pwr_mgmt.h"
 #include "nrf_error.h"
+#include <string.h>
 #if RUUVI_NRF5_SDK15_TIMER_ENABLED
   #include "ruuvi_interface_timer.h"
-  static ruuvi_interface_timer_id_t wakeup_timer;    //!< timer ID for wakeup
+  #include "app_timer.h"
+#endif
+#if RUUVI_NRF5_SDK15_SCHEDULER_ENABLED
+  #include "ruuvi_interface_scheduler.h"
 #endif
 
 static bool m_lp = false;                          //!< low-power mode enabled flag
-static volatile bool m_wakeup = false;             //!< wakeup flag
 static ruuvi_interface_yield_state_ind_fp_t m_ind; //!< State indication function
+static ruuvi_interface_yield_stats_t m_stats;      //!< Sleep accounting, times kept as ticks.
+static uint64_t m_sleep_ticks;                     //!< Total ticks in sleep.
+static uint64_t m_active_ticks;                    //!< Total ticks awake.
+static uint32_t m_active_cnt;                      //!< Counter at end of previous sleep.
 
 #ifdef FLOAT_ABI_HARD
 // Function handles and clears exception flags in FPSCR register and at the stack.
@@ -64,11 +80,83 @@ static void fpu_init(void)
 #endif
 
 /*
- * Set a flag to wake up
+ * Set wakeup flag of waiting call, given as context.
  */
 static void wakeup_handler(void* p_context)
 {
-  m_wakeup = true;
+  *((volatile bool*) p_context) = true;
+}
+
+/**
+ * @brief Check if wakeup timer can end a sleep of caller.
+ *
+ * Timer handler cannot preempt caller running at or above its priority, or with
+ * interrupts disabled.
+ */
+static bool wakeup_can_run(void)
+{
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  return m_lp && (0 == __get_PRIMASK())
+         && (APP_TIMER_CONFIG_IRQ_PRIORITY < current_int_priority_get());
+  #else
+  return false;
+  #endif
+}
+
+/** @brief Read RTC counter of timers, 0 if timers are not enabled. */
+static uint32_t idle_cnt_get(void)
+{
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  return app_timer_cnt_get();
+  #else
+  return 0;
+  #endif
+}
+
+/** @brief Ticks from one counter value to another, accounting for wrap. */
+static uint32_t idle_cnt_diff(const uint32_t cnt_to, const uint32_t cnt_from)
+{
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  return app_timer_cnt_diff_compute(cnt_to, cnt_from);
+  #else
+  return 0;
+  #endif
+}
+
+static uint64_t idle_ticks_to_us(const uint64_t ticks)
+{
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  // 1 000 000 / 32768 Hz = 15625 / 512.
+  return (ticks * 15625U * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1)) >> 9;
+  #else
+  return 0;
+  #endif
+}
+
+/** @brief Check if scheduler has work queued which can run after yield returns. */
+static bool idle_work_pending(void)
+{
+  #if RUUVI_NRF5_SDK15_SCHEDULER_ENABLED
+  // Queue holds at least the task which yields, skipping sleep would spin until timeout.
+  return !ruuvi_interface_scheduler_is_executing() && !ruuvi_interface_scheduler_is_empty();
+  #else
+  return false;
+  #endif
+}
+
+/**
+ * @brief Get time to nearest timer deadline.
+ *
+ * @param[out] us Time to deadline, 0 if deadline has passed.
+ * @return true if a deadline is known, false if device may sleep until an interrupt.
+ */
+static bool idle_deadline_get(uint32_t* const us)
+{
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  return (RUUVI_DRIVER_SUCCESS == ruuvi_interface_timer_soft_next_us(us));
+  #else
+  return false;
+  #endif
 }
 
 /**
@@ -79,33 +167,23 @@ ruuvi_driver_status_t ruuvi_interface_yield_init(void)
   fpu_init();
   ret_code_t err_code = nrf_pwr_mgmt_init();
   m_lp = false;
-  m_wakeup = false;
   m_ind = NULL;
+  ruuvi_interface_yield_stats_reset();
   return ruuvi_nrf5_sdk15_to_ruuvi_error(err_code);
 }
 
 #if RUUVI_NRF5_SDK15_TIMER_ENABLED
 ruuvi_driver_status_t ruuvi_interface_yield_low_power_enable(const bool enable)
 {
-  // Timer can be allocated after timer has initialized
-  ruuvi_driver_status_t timer_status = RUUVI_DRIVER_SUCCESS;
-
-  if(NULL == wakeup_timer)
-  {
-    timer_status = ruuvi_interface_timer_create(&wakeup_timer,
-                   RUUVI_INTERFACE_TIMER_MODE_SINGLE_SHOT, wakeup_handler);
-  }
-
-  if(timer_status == RUUVI_DRIVER_SUCCESS)
-  {
-    m_lp = enable;
-  }
-  else
+  // Wakeup timer can be started after timer has initialized
+  if(enable && !ruuvi_interface_timer_is_init())
   {
     m_lp = false;
+    return RUUVI_DRIVER_ERROR_INVALID_STATE;
   }
 
-  return timer_status;
+  m_lp = enable;
+  return RUUVI_DRIVER_SUCCESS;
 }
 #else
 // Return error if timers are not enabled.
@@ -118,42 +196,138 @@ ruuvi_driver_status_t ruuvi_interface_yield_low_power_enable(const bool enable)
 
 ruuvi_driver_status_t ruuvi_interface_yield(void)
 {
+  // Read counter before deadline to never account less sleep than the deadline was.
+  const uint32_t sleep_cnt = idle_cnt_get();
+  uint32_t deadline_us = 0;
+  const bool deadline_known = idle_deadline_get(&deadline_us);
+
+  // Work queued by an interrupt just before yield would otherwise wait for next wakeup.
+  if(idle_work_pending() || (deadline_known && 0 == deadline_us))
+  {
+    m_stats.skipped++;
+    return RUUVI_DRIVER_SUCCESS;
+  }
+
+  m_active_ticks += idle_cnt_diff(sleep_cnt, m_active_cnt);
+
   if(NULL != m_ind) { m_ind(false); }
 
   nrf_pwr_mgmt_run();
+  // Interrupt which woke the device has run by now.
+  m_active_cnt = idle_cnt_get();
 
   if(NULL != m_ind) { m_ind(true); }
 
+  const uint32_t slept = idle_cnt_diff(m_active_cnt, sleep_cnt);
+  m_sleep_ticks += slept;
+  m_stats.sleeps++;
+
+  if(deadline_known && idle_ticks_to_us(slept) >= deadline_us) { m_stats.wake_timer++; }
+  else if(idle_work_pending()) { m_stats.wake_scheduler++; }
+  else { m_stats.wake_other++; }
+
   return RUUVI_DRIVER_SUCCESS;
 }
 
-ruuvi_driver_status_t ruuvi_interface_delay_ms(uint32_t time)
+ruuvi_driver_status_t ruuvi_interface_yield_stats_get(ruuvi_interface_yield_stats_t*
+    const stats)
 {
-  ruuvi_driver_status_t err_code = RUUVI_DRIVER_SUCCESS;
+  if(NULL == stats) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  const uint64_t total_ticks = m_sleep_ticks + m_active_ticks;
+  *stats = m_stats;
+  stats->sleep_us = idle_ticks_to_us(m_sleep_ticks);
+  stats->active_us = idle_ticks_to_us(m_active_ticks);
+  stats->active_ppm = (0 == total_ticks) ? 0 :
+                      (uint32_t)((m_active_ticks * 1000000U) / total_ticks);
+  return RUUVI_DRIVER_SUCCESS;
+}
+
+void ruuvi_interface_yield_stats_reset(void)
+{
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_sleep_ticks = 0;
+  m_active_ticks = 0;
+  m_active_cnt = idle_cnt_get();
+}
+
+ruuvi_driver_status_t ruuvi_interface_yield_wait(const volatile bool* const flag,
+    const uint32_t timeout_ms)
+{
+  if(NULL == flag) { return RUUVI_DRIVER_ERROR_NULL; }
+
+  bool timer_running = false;
   #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  // Timer and flag of each call are its own, nested calls from interrupts do not
+  // restart or stop the timer of interrupted call.
+  ruuvi_interface_timer_soft_t wakeup_timer = {0};
+  volatile bool wakeup = false;
+
+  if(wakeup_can_run())
+  {
+    // RTC tick may be underway, add 1 ms.
+    timer_running = (RUUVI_DRIVER_SUCCESS == ruuvi_interface_timer_soft_start(
+                       &wakeup_timer, RUUVI_INTERFACE_TIMER_MODE_SINGLE_SHOT,
+                       timeout_ms + 1, wakeup_handler, (void*) &wakeup));
+  }
 
-  if(m_lp)
+  if(timer_running)
   {
-    m_wakeup = false;
-    err_code |= ruuvi_interface_timer_start(wakeup_timer, time);
+    while(!(*flag) && !wakeup)
+    {
+      ruuvi_interface_yield();
+    }
+
+    ruuvi_interface_timer_soft_stop(&wakeup_timer);
+  }
+
+  #endif
 
-    while(RUUVI_DRIVER_SUCCESS == err_code && !m_wakeup)
+  if(!timer_running)
+  {
+    // No wakeup source, CPU cannot sleep without risk of missing the timeout.
+    for(uint32_t waited_us = 0; !(*flag) && waited_us < (timeout_ms * 1000U); waited_us++)
     {
-      err_code |= ruuvi_interface_yield();
+      nrf_delay_us(1);
     }
   }
 
-  #else
+  return (*flag) ? RUUVI_DRIVER_SUCCESS : RUUVI_DRIVER_ERROR_TIMEOUT;
+}
 
-  if(0) {}
+ruuvi_driver_status_t ruuvi_interface_delay_ms(uint32_t time)
+{
+  bool timer_running = false;
+  #if RUUVI_NRF5_SDK15_TIMER_ENABLED
+  ruuvi_interface_timer_soft_t wakeup_timer = {0};
+  volatile bool wakeup = false;
+
+  // Soft timer cannot time 0 ms, zero delay falls through to a no-op busy loop.
+  if(0 < time && wakeup_can_run())
+  {
+    timer_running = (RUUVI_DRIVER_SUCCESS == ruuvi_interface_timer_soft_start(
+                       &wakeup_timer, RUUVI_INTERFACE_TIMER_MODE_SINGLE_SHOT, time,
+                       wakeup_handler, (void*) &wakeup));
+  }
+
+  if(timer_running)
+  {
+    while(!wakeup)
+    {
+      ruuvi_interface_yield();
+    }
+
+    ruuvi_interface_timer_soft_stop(&wakeup_timer);
+  }
 
   #endif
-  else
+
+  if(!timer_running)
   {
     nrf_delay_ms(time);
   }
 
-  return err_code;
+  return RUUVI_DRIVER_SUCCESS;
 }
 
 ruuvi_driver_status_t ruuvi_interface_delay_us(uint32_t time)
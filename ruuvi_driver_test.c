@@ -1,8 +1,22 @@
+#include "ruuvi_driver_enabled_modules.h"
 #include "ruuvi_driver_error.h"
 #include "ruuvi_driver_test.h"
 #include "ruuvi_interface_gpio.h"
 #include "ruuvi_interface_gpio_interrupt_test.h"
 #include "ruuvi_interface_gpio_test.h"
+#include "ruuvi_interface_yield_test.h"
+#if RUUVI_INTERFACE_ACCELERATION_LIS2DH12_ENABLED
+  #include "ruuvi_interface_lis2dh12_test.h"
+#endif
+#if RUUVI_INTERFACE_ENVIRONMENTAL_BME280_ENABLED
+  #include "ruuvi_interface_bme280_test.h"
+#endif
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+  #include "ruuvi_interface_adc_stream_test.h"
+#endif
+#if RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_ENABLED
+  #include "ruuvi_interface_communication_uart_bridge_test.h"
+#endif
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -54,6 +68,14 @@ static bool ruuvi_driver_test_gpio_run(const ruuvi_driver_test_print_fp printfp)
       fail = true;
     }
 
+    status |= ruuvi_interface_gpio_test_port(gpio_test_cfg.input, gpio_test_cfg.output);
+
+    if(RUUVI_DRIVER_SUCCESS != status)
+    {
+      RUUVI_DRIVER_ERROR_CHECK(RUUVI_DRIVER_ERROR_SELFTEST, ~RUUVI_DRIVER_ERROR_FATAL);
+      fail = true;
+    }
+
     if(RUUVI_DRIVER_SUCCESS == status) { printfp("PASSED.\r\n"); }
     else { printfp("FAILED.\r\n"); }
   }
@@ -96,6 +118,73 @@ static bool ruuvi_driver_test_gpio_interrupt_run(const ruuvi_driver_test_print_f
   return !fail;
 }
 
+static bool ruuvi_driver_test_yield_run(const ruuvi_driver_test_print_fp printfp)
+{
+  printfp("Yield tests ");
+  ruuvi_driver_status_t status = ruuvi_interface_yield_test();
+
+  if(RUUVI_DRIVER_SUCCESS == status) { printfp("PASSED.\r\n"); }
+  else if(RUUVI_DRIVER_ERROR_SELFTEST != status) { printfp("SKIPPED.\r\n"); }
+  else { printfp("FAILED.\r\n"); }
+
+  return (RUUVI_DRIVER_ERROR_SELFTEST != status);
+}
+
+#if RUUVI_INTERFACE_ACCELERATION_LIS2DH12_ENABLED
+static bool ruuvi_driver_test_lis2dh12_conversion_run(const ruuvi_driver_test_print_fp
+    printfp)
+{
+  printfp("LIS2DH12 conversion tests ");
+  ruuvi_driver_status_t status = ruuvi_interface_lis2dh12_test_conversion();
+
+  if(RUUVI_DRIVER_SUCCESS == status) { printfp("PASSED.\r\n"); }
+  else { printfp("FAILED.\r\n"); }
+
+  ruuvi_interface_lis2dh12_test_conversion_benchmark(printfp);
+  return (RUUVI_DRIVER_SUCCESS == status);
+}
+#endif
+
+#if RUUVI_INTERFACE_ENVIRONMENTAL_BME280_ENABLED
+static bool ruuvi_driver_test_bme280_run(const ruuvi_driver_test_print_fp printfp)
+{
+  printfp("BME280 tests ");
+  ruuvi_driver_status_t status = ruuvi_interface_bme280_test_schedule();
+
+  if(RUUVI_DRIVER_SUCCESS == status) { printfp("PASSED.\r\n"); }
+  else { printfp("FAILED.\r\n"); }
+
+  return (RUUVI_DRIVER_SUCCESS == status);
+}
+#endif
+
+#if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+static bool ruuvi_driver_test_adc_stream_run(const ruuvi_driver_test_print_fp printfp)
+{
+  printfp("ADC stream tests ");
+  ruuvi_driver_status_t status = ruuvi_interface_adc_stream_test();
+
+  if(RUUVI_DRIVER_SUCCESS == status) { printfp("PASSED.\r\n"); }
+  else { printfp("FAILED.\r\n"); }
+
+  return (RUUVI_DRIVER_SUCCESS == status);
+}
+#endif
+
+#if RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_ENABLED
+static bool ruuvi_driver_test_uart_bridge_run(const ruuvi_driver_test_print_fp printfp)
+{
+  printfp("UART bridge tests ");
+  ruuvi_driver_status_t status = ruuvi_interface_communication_uart_bridge_test();
+
+  if(RUUVI_DRIVER_SUCCESS == status) { printfp("PASSED.\r\n"); }
+  else { printfp("FAILED.\r\n"); }
+
+  ruuvi_interface_communication_uart_bridge_test_benchmark(printfp);
+  return (RUUVI_DRIVER_SUCCESS == status);
+}
+#endif
+
 bool ruuvi_driver_test_all_run(const ruuvi_driver_test_print_fp printfp)
 {
   tests_passed = 0;
@@ -103,10 +192,23 @@ bool ruuvi_driver_test_all_run(const ruuvi_driver_test_print_fp printfp)
   printfp("Running driver tests... \r\n");
   ruuvi_driver_test_gpio_run(printfp);
   ruuvi_driver_test_gpio_interrupt_run(printfp);
+  ruuvi_driver_test_yield_run(printfp);
+  #if RUUVI_INTERFACE_ACCELERATION_LIS2DH12_ENABLED
+  ruuvi_driver_test_lis2dh12_conversion_run(printfp);
+  #endif
+  #if RUUVI_INTERFACE_ENVIRONMENTAL_BME280_ENABLED
+  ruuvi_driver_test_bme280_run(printfp);
+  #endif
+  #if RUUVI_INTERFACE_ADC_STREAM_ENABLED
+  ruuvi_driver_test_adc_stream_run(printfp);
+  #endif
+  #if RUUVI_INTERFACE_COMMUNICATION_UART_BRIDGE_ENABLED
+  ruuvi_driver_test_uart_bridge_run(printfp);
+  #endif
 }
 
-bool ruuvi_interface_expect_close(const float expect, const int8_t precision,
-                                  const float check)
+bool ruuvi_driver_expect_close(const float expect, const int8_t precision,
+                               const float check)
 {
   if(!isfinite(expect) || !isfinite(check)) { return false; }
 